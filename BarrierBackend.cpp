@@ -0,0 +1,287 @@
+#include "BarrierBackend.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <vector>
+
+namespace
+{
+    struct BarrierScope
+    {
+        D3D12_BARRIER_SYNC Sync;
+        D3D12_BARRIER_ACCESS Access;
+        D3D12_BARRIER_LAYOUT Layout;
+    };
+
+    struct StateScope
+    {
+        D3D12_RESOURCE_STATES State;
+        BarrierScope Scope;
+    };
+
+    const StateScope g_StateScopes[] =
+    {
+        {D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, {D3D12_BARRIER_SYNC_ALL_SHADING, D3D12_BARRIER_ACCESS_VERTEX_BUFFER | D3D12_BARRIER_ACCESS_CONSTANT_BUFFER, D3D12_BARRIER_LAYOUT_UNDEFINED}},
+        {D3D12_RESOURCE_STATE_INDEX_BUFFER, {D3D12_BARRIER_SYNC_INDEX_INPUT, D3D12_BARRIER_ACCESS_INDEX_BUFFER, D3D12_BARRIER_LAYOUT_UNDEFINED}},
+        {D3D12_RESOURCE_STATE_RENDER_TARGET, {D3D12_BARRIER_SYNC_RENDER_TARGET, D3D12_BARRIER_ACCESS_RENDER_TARGET, D3D12_BARRIER_LAYOUT_RENDER_TARGET}},
+        {D3D12_RESOURCE_STATE_UNORDERED_ACCESS, {D3D12_BARRIER_SYNC_ALL_SHADING, D3D12_BARRIER_ACCESS_UNORDERED_ACCESS, D3D12_BARRIER_LAYOUT_UNORDERED_ACCESS}},
+        {D3D12_RESOURCE_STATE_DEPTH_WRITE, {D3D12_BARRIER_SYNC_DEPTH_STENCIL, D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE}},
+        {D3D12_RESOURCE_STATE_DEPTH_READ, {D3D12_BARRIER_SYNC_DEPTH_STENCIL, D3D12_BARRIER_ACCESS_DEPTH_STENCIL_READ, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_READ}},
+        {D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, {D3D12_BARRIER_SYNC_NON_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE}},
+        {D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE}},
+        {D3D12_RESOURCE_STATE_STREAM_OUT, {D3D12_BARRIER_SYNC_VERTEX_SHADING, D3D12_BARRIER_ACCESS_STREAM_OUTPUT, D3D12_BARRIER_LAYOUT_UNDEFINED}},
+        {D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, {D3D12_BARRIER_SYNC_EXECUTE_INDIRECT, D3D12_BARRIER_ACCESS_INDIRECT_ARGUMENT, D3D12_BARRIER_LAYOUT_UNDEFINED}},
+        {D3D12_RESOURCE_STATE_COPY_DEST, {D3D12_BARRIER_SYNC_COPY, D3D12_BARRIER_ACCESS_COPY_DEST, D3D12_BARRIER_LAYOUT_COPY_DEST}},
+        {D3D12_RESOURCE_STATE_COPY_SOURCE, {D3D12_BARRIER_SYNC_COPY, D3D12_BARRIER_ACCESS_COPY_SOURCE, D3D12_BARRIER_LAYOUT_COPY_SOURCE}},
+        {D3D12_RESOURCE_STATE_RESOLVE_DEST, {D3D12_BARRIER_SYNC_RESOLVE, D3D12_BARRIER_ACCESS_RESOLVE_DEST, D3D12_BARRIER_LAYOUT_RESOLVE_DEST}},
+        {D3D12_RESOURCE_STATE_RESOLVE_SOURCE, {D3D12_BARRIER_SYNC_RESOLVE, D3D12_BARRIER_ACCESS_RESOLVE_SOURCE, D3D12_BARRIER_LAYOUT_RESOLVE_SOURCE}}
+    };
+
+    const D3D12_RESOURCE_STATES g_WriteStates =
+        D3D12_RESOURCE_STATE_RENDER_TARGET |
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS |
+        D3D12_RESOURCE_STATE_DEPTH_WRITE |
+        D3D12_RESOURCE_STATE_STREAM_OUT |
+        D3D12_RESOURCE_STATE_COPY_DEST |
+        D3D12_RESOURCE_STATE_RESOLVE_DEST;
+
+    // Buffers and simultaneous-access textures are implicitly promoted out of COMMON by their first use
+    // and decay back to it, so work the legacy state doesn't show may be using them in it.
+    bool IsPromotable(const D3D12_RESOURCE_DESC& desc)
+    {
+        return desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER || (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS) != 0;
+    }
+
+    BarrierScope GetBarrierScope(D3D12_RESOURCE_STATES state, bool promotable)
+    {
+        // COMMON and PRESENT: nothing on the queue is using the resource, unless a promoted use is.
+        if(state == D3D12_RESOURCE_STATE_COMMON)
+        {
+            if(promotable)
+            {
+                return {D3D12_BARRIER_SYNC_ALL, D3D12_BARRIER_ACCESS_COMMON, D3D12_BARRIER_LAYOUT_COMMON};
+            }
+
+            return {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_COMMON};
+        }
+
+        BarrierScope scope = {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_COMMON, D3D12_BARRIER_LAYOUT_UNDEFINED};
+        D3D12_RESOURCE_STATES remaining = state;
+        bool mixedLayouts = false;
+
+        for (const StateScope& stateScope : g_StateScopes)
+        {
+            if((state & stateScope.State) != stateScope.State)
+            {
+                continue;
+            }
+
+            remaining &= ~stateScope.State;
+            scope.Sync |= stateScope.Scope.Sync;
+            scope.Access |= stateScope.Scope.Access;
+
+            if(stateScope.Scope.Layout != D3D12_BARRIER_LAYOUT_UNDEFINED)
+            {
+                mixedLayouts |= scope.Layout != D3D12_BARRIER_LAYOUT_UNDEFINED && scope.Layout != stateScope.Scope.Layout;
+                scope.Layout = stateScope.Scope.Layout;
+            }
+        }
+
+        // Anything without a precise equivalent waits for and makes visible everything.
+        if(remaining != 0)
+        {
+            return {D3D12_BARRIER_SYNC_ALL, D3D12_BARRIER_ACCESS_COMMON, D3D12_BARRIER_LAYOUT_COMMON};
+        }
+
+        // Several read states at once, such as GENERIC_READ, share the one layout every read can use.
+        // Read-only depth also allows shader reads.
+        if(mixedLayouts || scope.Layout == D3D12_BARRIER_LAYOUT_UNDEFINED)
+        {
+            if(state & g_WriteStates)
+            {
+                scope.Layout = D3D12_BARRIER_LAYOUT_COMMON;
+            }
+            else if(state & D3D12_RESOURCE_STATE_DEPTH_READ)
+            {
+                scope.Layout = D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_READ;
+            }
+            else
+            {
+                scope.Layout = D3D12_BARRIER_LAYOUT_GENERIC_READ;
+            }
+        }
+
+        return scope;
+    }
+
+    void RecordBarrierGroups(
+        ID3D12GraphicsCommandList7* enhancedList,
+        const std::vector<D3D12_TEXTURE_BARRIER>& textureBarriers,
+        const std::vector<D3D12_BUFFER_BARRIER>& bufferBarriers)
+    {
+        D3D12_BARRIER_GROUP groups[2];
+        UINT32 groupCount = 0;
+        if(!textureBarriers.empty())
+        {
+            groups[groupCount++] = CD3DX12_BARRIER_GROUP(static_cast<UINT32>(textureBarriers.size()), textureBarriers.data());
+        }
+        if(!bufferBarriers.empty())
+        {
+            groups[groupCount++] = CD3DX12_BARRIER_GROUP(static_cast<UINT32>(bufferBarriers.size()), bufferBarriers.data());
+        }
+
+        enhancedList->Barrier(groupCount, groups);
+    }
+}
+
+BarrierBackend ChooseBarrierBackend(const Microsoft::WRL::ComPtr<ID3D12Device2>& device)
+{
+    D3D12_FEATURE_DATA_D3D12_OPTIONS12 options = {};
+    if(SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS12, &options, sizeof(options))) && options.EnhancedBarriersSupported)
+    {
+        return BarrierBackend_Enhanced;
+    }
+
+    return BarrierBackend_Legacy;
+}
+
+const char* GetBarrierBackendName(BarrierBackend backend)
+{
+    return backend == BarrierBackend_Enhanced ? "enhanced" : "legacy";
+}
+
+Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList7> GetEnhancedBarrierList(
+    ID3D12GraphicsCommandList* commandList,
+    BarrierBackend backend)
+{
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList7> enhancedList;
+    if(backend == BarrierBackend_Enhanced)
+    {
+        // Left null on failure.
+        commandList->QueryInterface(IID_PPV_ARGS(&enhancedList));
+    }
+
+    return enhancedList;
+}
+
+void RecordTransitions(
+    ID3D12GraphicsCommandList* commandList,
+    ID3D12GraphicsCommandList7* enhancedList,
+    const D3D12_RESOURCE_BARRIER* barriers,
+    UINT count)
+{
+    if(!enhancedList)
+    {
+        commandList->ResourceBarrier(count, barriers);
+        return;
+    }
+
+    std::vector<D3D12_TEXTURE_BARRIER> textureBarriers;
+    std::vector<D3D12_BUFFER_BARRIER> bufferBarriers;
+
+    for (UINT i = 0; i < count; ++i)
+    {
+        const D3D12_RESOURCE_TRANSITION_BARRIER& transition = barriers[i].Transition;
+        D3D12_RESOURCE_DESC desc = transition.pResource->GetDesc();
+        bool promotable = IsPromotable(desc);
+        BarrierScope before = GetBarrierScope(transition.StateBefore, promotable);
+        BarrierScope after = GetBarrierScope(transition.StateAfter, promotable);
+
+        // Simultaneous-access textures only ever have the common layout.
+        if(promotable)
+        {
+            before.Layout = D3D12_BARRIER_LAYOUT_COMMON;
+            after.Layout = D3D12_BARRIER_LAYOUT_COMMON;
+        }
+
+        if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            bufferBarriers.push_back(CD3DX12_BUFFER_BARRIER(
+                before.Sync,
+                after.Sync,
+                before.Access,
+                after.Access,
+                transition.pResource));
+        }
+        else
+        {
+            textureBarriers.push_back(CD3DX12_TEXTURE_BARRIER(
+                before.Sync,
+                after.Sync,
+                before.Access,
+                after.Access,
+                before.Layout,
+                after.Layout,
+                transition.pResource,
+                CD3DX12_BARRIER_SUBRESOURCE_RANGE(0xffffffff)));
+        }
+    }
+
+    RecordBarrierGroups(enhancedList, textureBarriers, bufferBarriers);
+}
+
+void RecordAliasing(
+    ID3D12GraphicsCommandList* commandList,
+    ID3D12GraphicsCommandList7* enhancedList,
+    const AliasingBarrier* barriers,
+    UINT count)
+{
+    if(!enhancedList)
+    {
+        // Barriers in one call take effect in order, so the transitions come after the activations.
+        std::vector<D3D12_RESOURCE_BARRIER> aliasingBarriers;
+        for (UINT i = 0; i < count; ++i)
+        {
+            aliasingBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, barriers[i].Resource));
+        }
+        for (UINT i = 0; i < count; ++i)
+        {
+            if(barriers[i].StateBefore != barriers[i].State)
+            {
+                aliasingBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(barriers[i].Resource, barriers[i].StateBefore, barriers[i].State));
+            }
+        }
+
+        commandList->ResourceBarrier(static_cast<UINT>(aliasingBarriers.size()), aliasingBarriers.data());
+        return;
+    }
+
+    std::vector<D3D12_TEXTURE_BARRIER> textureBarriers;
+    std::vector<D3D12_BUFFER_BARRIER> bufferBarriers;
+
+    for (UINT i = 0; i < count; ++i)
+    {
+        D3D12_RESOURCE_DESC desc = barriers[i].Resource->GetDesc();
+        bool promotable = IsPromotable(desc);
+        BarrierScope after = GetBarrierScope(barriers[i].State, promotable);
+
+        // Whatever used the memory before is unknown, so wait for everything; none of its writes need
+        // to be made visible.
+        if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            bufferBarriers.push_back(CD3DX12_BUFFER_BARRIER(
+                D3D12_BARRIER_SYNC_ALL,
+                after.Sync,
+                D3D12_BARRIER_ACCESS_NO_ACCESS,
+                after.Access,
+                barriers[i].Resource));
+        }
+        else
+        {
+            textureBarriers.push_back(CD3DX12_TEXTURE_BARRIER(
+                D3D12_BARRIER_SYNC_ALL,
+                after.Sync,
+                D3D12_BARRIER_ACCESS_NO_ACCESS,
+                after.Access,
+                D3D12_BARRIER_LAYOUT_UNDEFINED,
+                promotable ? D3D12_BARRIER_LAYOUT_COMMON : after.Layout,
+                barriers[i].Resource,
+                CD3DX12_BARRIER_SUBRESOURCE_RANGE(0xffffffff),
+                D3D12_TEXTURE_BARRIER_FLAG_DISCARD));
+        }
+    }
+
+    RecordBarrierGroups(enhancedList, textureBarriers, bufferBarriers);
+}
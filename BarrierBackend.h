@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+
+enum BarrierBackend
+{
+    // ID3D12GraphicsCommandList::ResourceBarrier with transition barriers.
+    BarrierBackend_Legacy,
+    // ID3D12GraphicsCommandList7::Barrier with texture and buffer barrier groups.
+    BarrierBackend_Enhanced
+};
+
+// Makes Resource the one using memory it shares with other placed resources, throwing away whatever
+// is there. State is the state the resource is in at that point, and StateBefore the one it was left
+// in when it last used the memory.
+struct AliasingBarrier
+{
+    ID3D12Resource* Resource;
+    D3D12_RESOURCE_STATES StateBefore;
+    D3D12_RESOURCE_STATES State;
+};
+
+// Enhanced when the device reports EnhancedBarriersSupported, legacy otherwise.
+BarrierBackend ChooseBarrierBackend(const Microsoft::WRL::ComPtr<ID3D12Device2>& device);
+
+const char* GetBarrierBackendName(BarrierBackend backend);
+
+// The interface enhanced barriers are recorded through: commandList's ID3D12GraphicsCommandList7 when
+// backend is enhanced and the list has one, null otherwise. Query it once per list and hand it to the
+// Record functions with the list.
+Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList7> GetEnhancedBarrierList(
+    ID3D12GraphicsCommandList* commandList,
+    BarrierBackend backend);
+
+// Records whole-resource transition barriers, as legacy transitions when enhancedList is null. The
+// enhanced backend turns each one into a barrier whose sync, access and layout cover only what the two
+// states use, so unrelated work before and after it can overlap, where a legacy transition waits for
+// everything.
+void RecordTransitions(
+    ID3D12GraphicsCommandList* commandList,
+    ID3D12GraphicsCommandList7* enhancedList,
+    const D3D12_RESOURCE_BARRIER* barriers,
+    UINT count);
+
+// Records aliasing barriers, as legacy ones when enhancedList is null, which wait for all earlier work
+// and leave states alone, so each is followed by a transition from StateBefore into State. The enhanced
+// backend also waits for all earlier work, then moves textures from the undefined layout into the
+// layout of State with a discard, so the new resource starts out initialized.
+void RecordAliasing(
+    ID3D12GraphicsCommandList* commandList,
+    ID3D12GraphicsCommandList7* enhancedList,
+    const AliasingBarrier* barriers,
+    UINT count);
@@ -0,0 +1,190 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    const char* const g_FrameStageNames[FrameStage_Count] =
+    {
+        "record",
+        "execute",
+        "present",
+        "fenceWait",
+        "total",
+        "displayLatency"
+    };
+
+    const char* const g_StatisticNames[] =
+    {
+        "min",
+        "avg",
+        "p50",
+        "p95",
+        "p99",
+        "max"
+    };
+
+    double Percentile(const std::vector<double>& sorted, double percentile)
+    {
+        // Nearest-rank, so every reported value is a frame that actually happened.
+        size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * sorted.size()));
+        return sorted[std::max<size_t>(rank, 1) - 1];
+    }
+
+    double GetStatistic(const TimingSummary& summary, size_t index)
+    {
+        const double values[] = {summary.Min, summary.Avg, summary.P50, summary.P95, summary.P99, summary.Max};
+        return values[index];
+    }
+
+    template<size_t N>
+    size_t FindName(const char* const (&names)[N], const std::string& name)
+    {
+        return std::find(names, names + N, name) - names;
+    }
+}
+
+BenchmarkRecorder::BenchmarkRecorder(uint32_t frameCount, uint32_t warmupFrameCount)
+    : m_FrameCount(frameCount)
+    , m_WarmupFrameCount(warmupFrameCount)
+    , m_FramesSeen(0)
+{
+    for (std::vector<double>& samples : m_Samples)
+    {
+        samples.reserve(frameCount);
+    }
+}
+
+void BenchmarkRecorder::AddFrame(const FrameTimings& timings)
+{
+    if(IsComplete())
+    {
+        return;
+    }
+
+    if(m_FramesSeen++ < m_WarmupFrameCount)
+    {
+        return;
+    }
+
+    for (int i = 0; i < FrameStage_Count; ++i)
+    {
+        if(timings[i] >= 0)
+        {
+            m_Samples[i].push_back(timings[i]);
+        }
+    }
+}
+
+bool BenchmarkRecorder::IsComplete() const
+{
+    return m_Samples[FrameStage_Total].size() >= m_FrameCount;
+}
+
+TimingSummary BenchmarkRecorder::Summarize(FrameStage stage) const
+{
+    TimingSummary summary = {};
+
+    std::vector<double> sorted = m_Samples[stage];
+    if(sorted.empty())
+    {
+        return summary;
+    }
+
+    std::sort(sorted.begin(), sorted.end());
+
+    summary.Min = sorted.front();
+    summary.Avg = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+    summary.P50 = Percentile(sorted, 50);
+    summary.P95 = Percentile(sorted, 95);
+    summary.P99 = Percentile(sorted, 99);
+    summary.Max = sorted.back();
+
+    return summary;
+}
+
+bool BenchmarkRecorder::WriteReport(const std::filesystem::path& path) const
+{
+    std::ofstream file(path);
+    if(!file)
+    {
+        return false;
+    }
+
+    file << "{\n";
+    file << "  \"frames\": " << m_Samples[FrameStage_Total].size() << ",\n";
+    file << "  \"warmupFrames\": " << m_WarmupFrameCount << ",\n";
+    file << "  \"unit\": \"ms\",\n";
+    file << "  \"stages\": {\n";
+
+    for (int i = 0; i < FrameStage_Count; ++i)
+    {
+        TimingSummary summary = Summarize(static_cast<FrameStage>(i));
+
+        file << "    \"" << g_FrameStageNames[i] << "\": {";
+        for (size_t j = 0; j < std::size(g_StatisticNames); ++j)
+        {
+            file << (j == 0 ? " " : ", ") << "\"" << g_StatisticNames[j] << "\": " << GetStatistic(summary, j);
+        }
+        file << " }" << (i + 1 < FrameStage_Count ? "," : "") << "\n";
+    }
+
+    file << "  }\n";
+    file << "}\n";
+
+    return static_cast<bool>(file);
+}
+
+bool BenchmarkRecorder::CheckBudget(const std::filesystem::path& path) const
+{
+    std::ifstream file(path);
+    if(!file)
+    {
+        std::cout << "Benchmark: cannot read budget file " << path.string() << std::endl;
+        return false;
+    }
+
+    bool withinBudget = true;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream entry(line);
+        std::string stageName;
+        std::string statisticName;
+        double budget;
+
+        if(!(entry >> stageName) || stageName[0] == '#')
+        {
+            continue;
+        }
+
+        entry >> statisticName >> budget;
+
+        size_t stage = FindName(g_FrameStageNames, stageName);
+        size_t statistic = FindName(g_StatisticNames, statisticName);
+        if(!entry || stage == FrameStage_Count || statistic == std::size(g_StatisticNames))
+        {
+            std::cout << "Benchmark: malformed budget entry \"" << line << "\"" << std::endl;
+            withinBudget = false;
+            continue;
+        }
+
+        double value = GetStatistic(Summarize(static_cast<FrameStage>(stage)), statistic);
+        if(value > budget)
+        {
+            std::cout << "Benchmark: " << stageName << " " << statisticName << " " << value
+                      << " ms exceeds budget of " << budget << " ms" << std::endl;
+            withinBudget = false;
+        }
+    }
+
+    return withinBudget;
+}
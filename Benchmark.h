@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Collects per-frame CPU timings for --benchmark runs and reports their distribution.
+
+enum FrameStage
+{
+    FrameStage_Record,
+    FrameStage_Execute,
+    FrameStage_Present,
+    FrameStage_FenceWait,
+    FrameStage_Total,
+    FrameStage_DisplayLatency,
+    FrameStage_Count
+};
+
+// Milliseconds spent in each stage of Render(); Total is the sum of the stages before it.
+// DisplayLatency is the time from Present until an earlier frame reached the screen.
+// Negative values mark something that wasn't measured this frame and are not recorded.
+typedef std::array<double, FrameStage_Count> FrameTimings;
+
+struct TimingSummary
+{
+    double Min;
+    double Avg;
+    double P50;
+    double P95;
+    double P99;
+    double Max;
+};
+
+class BenchmarkRecorder
+{
+public:
+    BenchmarkRecorder(uint32_t frameCount, uint32_t warmupFrameCount);
+
+    // Frames submitted during warmup are dropped.
+    void AddFrame(const FrameTimings& timings);
+
+    bool IsComplete() const;
+
+    TimingSummary Summarize(FrameStage stage) const;
+
+    bool WriteReport(const std::filesystem::path& path) const;
+
+    // Budget files hold one "<stage> <statistic> <milliseconds>" entry per line, e.g. "total p99 8.0".
+    // Returns false if any entry is exceeded or the file cannot be read.
+    bool CheckBudget(const std::filesystem::path& path) const;
+
+private:
+    uint32_t m_FrameCount;
+    uint32_t m_WarmupFrameCount;
+    uint32_t m_FramesSeen;
+    std::array<std::vector<double>, FrameStage_Count> m_Samples;
+};
@@ -0,0 +1,179 @@
+#include "BindlessHeap.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t g_GenerationCount = 1u << (32 - BindlessHeap::IndexBits);
+}
+
+BindlessHeap::BindlessHeap(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, uint32_t capacity)
+    : m_Device(device)
+    , m_DescriptorSize(device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV))
+    , m_Capacity(std::min(capacity, IndexMask + 1))
+    , m_Generations(m_Capacity, 1)
+    , m_Registered(m_Capacity, false)
+    , m_RegisteredCount(0)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+    desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    desc.NumDescriptors = m_Capacity;
+    desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+    ThrowIfFailed(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&m_Heap)));
+
+    m_CpuStart = m_Heap->GetCPUDescriptorHandleForHeapStart();
+    m_GpuStart = m_Heap->GetGPUDescriptorHandleForHeapStart();
+
+    // Lowest slots first, so a lightly used heap stays compact.
+    m_FreeSlots.reserve(m_Capacity);
+    for (uint32_t slot = m_Capacity; slot-- > 0;)
+    {
+        m_FreeSlots.push_back(slot);
+    }
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE BindlessHeap::Bind(ID3D12GraphicsCommandList* commandList) const
+{
+    ID3D12DescriptorHeap* heaps[] = {m_Heap.Get()};
+    commandList->SetDescriptorHeaps(1, heaps);
+
+    return m_GpuStart;
+}
+
+BindlessHandle BindlessHeap::RegisterConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc)
+{
+    BindlessHandle handle = AllocateSlot();
+    m_Device->CreateConstantBufferView(&desc, GetCpuHandle(handle));
+
+    return handle;
+}
+
+BindlessHandle BindlessHeap::RegisterShaderResourceView(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc)
+{
+    BindlessHandle handle = AllocateSlot();
+    m_Device->CreateShaderResourceView(resource, desc, GetCpuHandle(handle));
+
+    return handle;
+}
+
+BindlessHandle BindlessHeap::RegisterUnorderedAccessView(
+    ID3D12Resource* resource,
+    ID3D12Resource* counterResource,
+    const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc)
+{
+    BindlessHandle handle = AllocateSlot();
+    m_Device->CreateUnorderedAccessView(resource, counterResource, desc, GetCpuHandle(handle));
+
+    return handle;
+}
+
+BindlessHandle BindlessHeap::RegisterCopy(D3D12_CPU_DESCRIPTOR_HANDLE source)
+{
+    BindlessHandle handle = AllocateSlot();
+    m_Device->CopyDescriptorsSimple(1, GetCpuHandle(handle), source, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    return handle;
+}
+
+void BindlessHeap::Unregister(BindlessHandle handle, const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if(!IsValidLocked(handle))
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+
+    uint32_t slot = handle & IndexMask;
+
+    // Generation zero is skipped so that no handle is ever zero.
+    uint32_t& generation = m_Generations[slot];
+    generation = generation + 1 < g_GenerationCount ? generation + 1 : 1;
+    m_Registered[slot] = false;
+    --m_RegisteredCount;
+
+    if(fence)
+    {
+        m_Retired.push_back({fence, fenceValue, slot});
+    }
+    else
+    {
+        m_FreeSlots.push_back(slot);
+    }
+}
+
+bool BindlessHeap::IsValid(BindlessHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return IsValidLocked(handle);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE BindlessHeap::GetCpuHandle(BindlessHandle handle) const
+{
+    if(!IsValid(handle))
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+
+    return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_CpuStart, handle & IndexMask, m_DescriptorSize);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE BindlessHeap::GetGpuHandle(BindlessHandle handle) const
+{
+    if(!IsValid(handle))
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+
+    return CD3DX12_GPU_DESCRIPTOR_HANDLE(m_GpuStart, handle & IndexMask, m_DescriptorSize);
+}
+
+BindlessHeapStatistics BindlessHeap::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    BindlessHeapStatistics statistics;
+    statistics.Capacity = m_Capacity;
+    statistics.Registered = m_RegisteredCount;
+    statistics.Retiring = static_cast<uint32_t>(m_Retired.size());
+
+    return statistics;
+}
+
+BindlessHandle BindlessHeap::AllocateSlot()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // Retired in fence order, so stop at the first slot the GPU may still be reading.
+    while (!m_Retired.empty() && m_Retired.front().Fence->GetCompletedValue() >= m_Retired.front().FenceValue)
+    {
+        m_FreeSlots.push_back(m_Retired.front().Slot);
+        m_Retired.pop_front();
+    }
+
+    if(m_FreeSlots.empty())
+    {
+        ThrowIfFailed(E_OUTOFMEMORY);
+    }
+
+    uint32_t slot = m_FreeSlots.back();
+    m_FreeSlots.pop_back();
+
+    m_Registered[slot] = true;
+    ++m_RegisteredCount;
+
+    return m_Generations[slot] << IndexBits | slot;
+}
+
+bool BindlessHeap::IsValidLocked(BindlessHandle handle) const
+{
+    uint32_t slot = handle & IndexMask;
+
+    return slot < m_Capacity && m_Registered[slot] && m_Generations[slot] == handle >> IndexBits;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// A descriptor's slot in the BindlessHeap in the low IndexBits, tagged with the slot's generation in
+// the rest. Zero is never a valid handle.
+typedef uint32_t BindlessHandle;
+
+struct BindlessHeapStatistics
+{
+    uint32_t Capacity;
+    uint32_t Registered;
+    // Unregistered slots waiting for the GPU before they can be handed out again.
+    uint32_t Retiring;
+};
+
+// One large shader-visible CBV_SRV_UAV heap. A view is registered once and keeps its handle until
+// it is unregistered; shaders index the heap with the handle's slot instead of being given a
+// descriptor table per draw. Safe to use from several threads.
+class BindlessHeap
+{
+public:
+    static constexpr uint32_t IndexBits = 20;
+    static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+
+    BindlessHeap(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, uint32_t capacity);
+
+    // Sets the heap on the list and returns the start of the table that reaches every slot.
+    D3D12_GPU_DESCRIPTOR_HANDLE Bind(ID3D12GraphicsCommandList* commandList) const;
+
+    BindlessHandle RegisterConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc);
+    BindlessHandle RegisterShaderResourceView(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc);
+    BindlessHandle RegisterUnorderedAccessView(
+        ID3D12Resource* resource,
+        ID3D12Resource* counterResource,
+        const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc);
+    // Copies a view created elsewhere, e.g. in a DescriptorAllocator range.
+    BindlessHandle RegisterCopy(D3D12_CPU_DESCRIPTOR_HANDLE source);
+
+    // The handle is stale as soon as this returns, but its slot is only reused once the fence has
+    // passed fenceValue. Pass a null fence when the GPU is known to be done with the slot.
+    void Unregister(BindlessHandle handle, const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue);
+
+    bool IsValid(BindlessHandle handle) const;
+
+    // Both throw E_INVALIDARG for a stale handle.
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(BindlessHandle handle) const;
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(BindlessHandle handle) const;
+
+    BindlessHeapStatistics GetStatistics() const;
+
+private:
+    struct RetiredSlot
+    {
+        Microsoft::WRL::ComPtr<ID3D12Fence> Fence;
+        uint64_t FenceValue;
+        uint32_t Slot;
+    };
+
+    BindlessHandle AllocateSlot();
+
+    // Call with m_Mutex held.
+    bool IsValidLocked(BindlessHandle handle) const;
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_Heap;
+    D3D12_CPU_DESCRIPTOR_HANDLE m_CpuStart;
+    D3D12_GPU_DESCRIPTOR_HANDLE m_GpuStart;
+    uint32_t m_DescriptorSize;
+    uint32_t m_Capacity;
+
+    mutable std::mutex m_Mutex;
+    // Generation of each slot's current registration; bumped when it is unregistered.
+    std::vector<uint32_t> m_Generations;
+    std::vector<bool> m_Registered;
+    std::vector<uint32_t> m_FreeSlots;
+    std::deque<RetiredSlot> m_Retired;
+    uint32_t m_RegisteredCount;
+};
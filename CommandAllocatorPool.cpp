@@ -0,0 +1,65 @@
+#include "CommandAllocatorPool.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+CommandAllocatorPool::CommandAllocatorPool(const Microsoft::WRL::ComPtr<ID3D12Device2>& device)
+    : m_Device(device)
+    , m_Statistics()
+{
+}
+
+Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CommandAllocatorPool::Acquire(D3D12_COMMAND_LIST_TYPE type)
+{
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        std::deque<Entry>& available = m_Available[type];
+        if(!available.empty() && available.front().Fence->GetCompletedValue() >= available.front().FenceValue)
+        {
+            allocator = std::move(available.front().Allocator);
+            available.pop_front();
+
+            ++m_Statistics.Hits;
+            --m_Statistics.Available;
+        }
+        else
+        {
+            ++m_Statistics.Misses;
+            ++m_Statistics.Allocators;
+        }
+    }
+
+    if(allocator)
+    {
+        ThrowIfFailed(allocator->Reset());
+    }
+    else
+    {
+        ThrowIfFailed(m_Device->CreateCommandAllocator(type, IID_PPV_ARGS(&allocator)));
+    }
+
+    return allocator;
+}
+
+void CommandAllocatorPool::Release(
+    D3D12_COMMAND_LIST_TYPE type,
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator,
+    const Microsoft::WRL::ComPtr<ID3D12Fence>& fence,
+    uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_Available[type].push_back({std::move(allocator), fence, fenceValue});
+    ++m_Statistics.Available;
+}
+
+CommandAllocatorPoolStatistics CommandAllocatorPool::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return m_Statistics;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+
+struct CommandAllocatorPoolStatistics
+{
+    // Acquires served by a recycled allocator, and those that had to create one.
+    uint64_t Hits;
+    uint64_t Misses;
+    // Allocators created so far, and how many of them are currently back in the pool.
+    size_t Allocators;
+    size_t Available;
+};
+
+// Hands out command allocators per command list type and takes them back tagged with the fence value
+// of the work recorded into them. An allocator is only reset, on a later Acquire, once its fence has
+// passed that value. Safe to use from several recording threads.
+class CommandAllocatorPool
+{
+public:
+    explicit CommandAllocatorPool(const Microsoft::WRL::ComPtr<ID3D12Device2>& device);
+
+    // The allocator is reset and ready for recording.
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> Acquire(D3D12_COMMAND_LIST_TYPE type);
+
+    void Release(
+        D3D12_COMMAND_LIST_TYPE type,
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator,
+        const Microsoft::WRL::ComPtr<ID3D12Fence>& fence,
+        uint64_t fenceValue);
+
+    CommandAllocatorPoolStatistics GetStatistics() const;
+
+private:
+    struct Entry
+    {
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> Allocator;
+        Microsoft::WRL::ComPtr<ID3D12Fence> Fence;
+        uint64_t FenceValue;
+    };
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+
+    mutable std::mutex m_Mutex;
+    // Released in submission order, so the oldest entry is the one most likely to have completed.
+    std::map<D3D12_COMMAND_LIST_TYPE, std::deque<Entry>> m_Available;
+    CommandAllocatorPoolStatistics m_Statistics;
+};
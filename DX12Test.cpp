@@ -1,7 +1,15 @@
 #include "DX12Test.h"
 
-constexpr int g_NumFrames = 3;
+constexpr uint32_t g_MinFrames = 2;
+constexpr uint32_t g_MaxFrames = 4;
+constexpr uint64_t g_UploadMemoryPerFrame = 1 << 20;
+constexpr uint32_t g_BindlessCapacity = 1 << 16;
+uint32_t g_NumFrames = 3;
 bool g_UseWarp = false;
+#if !defined(_WIN32)
+std::chrono::microseconds g_NullGpuLatency(0);
+std::chrono::microseconds g_NullPipelineLatency(0);
+#endif
 
 uint32_t g_ClientWidth = 1280;
 uint32_t g_ClientHeight = 720;
@@ -14,23 +22,106 @@ RECT g_WindowRect;
 ComPtr<ID3D12Device2> g_Device;
 ComPtr<ID3D12CommandQueue> g_CommandQueue;
 ComPtr<IDXGISwapChain4> g_SwapChain;
-ComPtr<ID3D12Resource> g_BackBuffers[g_NumFrames];
-ComPtr<ID3D12GraphicsCommandList> g_CommandList;
-ComPtr<ID3D12CommandAllocator> g_CommandAllocators[g_NumFrames];
-ComPtr<ID3D12DescriptorHeap> g_RTVDescriptorHeap;
-UINT g_RTVDescriptorSize;
+std::vector<FrameContext> g_FrameContexts;
+std::unique_ptr<CommandAllocatorPool> g_CommandAllocatorPool;
+std::unique_ptr<UploadRing> g_UploadRing;
+std::unique_ptr<BindlessHeap> g_BindlessHeap;
+std::unique_ptr<ResourceAllocator> g_ResourceAllocator;
+// Declared after what its releases refer to, so it is destroyed before them.
+std::unique_ptr<ReleaseQueue> g_ReleaseQueue;
+// Layouts of the textures uploaded so far, by shape.
+FootprintCache g_FootprintCache;
+// Pipelines compiled in earlier runs, loaded from g_PipelineCachePath and written back on exit.
+std::wstring g_PipelineCachePath = L"pipelines.bin";
+std::unique_ptr<PipelineCache> g_PipelineCache;
+// Compiles pipelines off the render thread; --pipeline-fallback draws the scene with a placeholder
+// pipeline meanwhile instead of skipping it.
+uint32_t g_PipelineCompileThreadCount = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+bool g_PipelineFallback = false;
+std::unique_ptr<PipelineCompiler> g_PipelineCompiler;
+
+// Draws are recorded in parallel into their own lists, as an external pass of the render graph.
+uint32_t g_DrawCount = 0;
+uint32_t g_RecordThreadCount = std::max(1u, std::thread::hardware_concurrency());
+bool g_RecordBenchmark = false;
+bool g_AllocationBenchmark = false;
+bool g_CopyBenchmark = false;
+// --test runs the self-checks in Tests.h instead of rendering.
+bool g_RunTests = false;
+bool g_LegacyBarriers = false;
+std::unique_ptr<Scene> g_Scene;
+std::unique_ptr<ParallelRecorder> g_ParallelRecorder;
+
+std::unique_ptr<RenderGraph> g_RenderGraph;
+std::unique_ptr<PendingBarrierResolver> g_BarrierResolver;
+// Transitions dropped by the render graph's trackers since Update last reported them.
+uint64_t g_EliminatedBarriers = 0;
+std::unique_ptr<DescriptorAllocator> g_DescriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 UINT g_CurrentBackBufferIndex;
 
 ComPtr<ID3D12Fence> g_Fence;
 uint64_t g_FenceValue = 0;
-uint64_t g_FenceValues[g_NumFrames] = {};
 HANDLE g_FenceEvent;
+std::unique_ptr<FenceWaiter> g_FenceWaiter;
+// One slot per frame in flight, so copies out of earlier frames can still be pending while the next one renders.
+std::unique_ptr<ReadbackRing> g_ReadbackRing;
+
+// --capture writes every back buffer to this directory.
+std::wstring g_CapturePath;
+uint32_t g_CaptureThreadCount = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+std::unique_ptr<FrameCapture> g_FrameCapture;
+
+// 0 paces frames by blocking on the next back buffer's fence after Present; anything else waits on
+// the swap chain's frame-latency waitable object at the start of the frame.
+uint32_t g_MaxFrameLatency = 0;
+HANDLE g_FrameLatencyWaitable = nullptr;
+
+struct PresentTime
+{
+    UINT PresentCount;
+    LONGLONG Time;
+};
+
+// QPC time of recent Presents, indexed by present count, to match against GetFrameStatistics.
+constexpr UINT g_PresentHistorySize = 16;
+PresentTime g_PresentTimes[g_PresentHistorySize] = {};
+UINT g_LastDisplayedPresentCount = 0;
+double g_DisplayLatency = -1;
+double g_FrameStartWait = 0;
 
 bool g_Vsync = true;
 bool g_TearingSupported = false;
 bool g_FullScreen = false;
 
+uint32_t g_BenchmarkFrames = 0;
+uint32_t g_BenchmarkWarmupFrames = 60;
+std::wstring g_BenchmarkOutputPath = L"benchmark.json";
+std::wstring g_BenchmarkBudgetPath;
+std::unique_ptr<BenchmarkRecorder> g_Benchmark;
+FrameTimings g_FrameTimings = {};
+
+enum class RenderCommandType
+{
+    Resize,
+    ToggleFullScreen,
+    ToggleVsync
+};
+
+struct RenderCommand
+{
+    RenderCommandType Type;
+    uint32_t Width;
+    uint32_t Height;
+};
+
+// Filled by the window thread, drained by the render thread between frames.
+EventQueue<RenderCommand, 256> g_RenderCommands;
+std::thread g_RenderThread;
+std::atomic<bool> g_QuitRequested(false);
+
+#if defined(_WIN32)
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
+#endif
 
 void ParseCommandLineArguments()
 {
@@ -50,11 +141,92 @@ void ParseCommandLineArguments()
         {
             g_UseWarp = true;
         }
+        if(::wcscmp(argv[i], L"--frames") == 0)
+        {
+            g_NumFrames = std::clamp<uint32_t>(::wcstoul(argv[i + 1], nullptr, 10), g_MinFrames, g_MaxFrames);
+        }
+        if(::wcscmp(argv[i], L"--draws") == 0)
+        {
+            g_DrawCount = ::wcstoul(argv[i + 1], nullptr, 10);
+        }
+        if(::wcscmp(argv[i], L"--record-threads") == 0)
+        {
+            g_RecordThreadCount = std::max(1ul, ::wcstoul(argv[i + 1], nullptr, 10));
+        }
+        if(::wcscmp(argv[i], L"--record-benchmark") == 0)
+        {
+            g_RecordBenchmark = true;
+        }
+        if(::wcscmp(argv[i], L"--test") == 0)
+        {
+            g_RunTests = true;
+        }
+        if(::wcscmp(argv[i], L"--allocation-benchmark") == 0)
+        {
+            g_AllocationBenchmark = true;
+        }
+        if(::wcscmp(argv[i], L"--copy-benchmark") == 0)
+        {
+            g_CopyBenchmark = true;
+        }
+        if(::wcscmp(argv[i], L"--legacy-barriers") == 0)
+        {
+            g_LegacyBarriers = true;
+        }
+        if(::wcscmp(argv[i], L"--max-frame-latency") == 0)
+        {
+            g_MaxFrameLatency = std::clamp<uint32_t>(::wcstoul(argv[i + 1], nullptr, 10), 1, 16);
+        }
+        if(::wcscmp(argv[i], L"--benchmark") == 0)
+        {
+            g_BenchmarkFrames = ::wcstoul(argv[i + 1], nullptr, 10);
+        }
+        if(::wcscmp(argv[i], L"--benchmark-warmup") == 0)
+        {
+            g_BenchmarkWarmupFrames = ::wcstoul(argv[i + 1], nullptr, 10);
+        }
+        if(::wcscmp(argv[i], L"--benchmark-output") == 0)
+        {
+            g_BenchmarkOutputPath = argv[i + 1];
+        }
+        if(::wcscmp(argv[i], L"--benchmark-budget") == 0)
+        {
+            g_BenchmarkBudgetPath = argv[i + 1];
+        }
+        if(::wcscmp(argv[i], L"--capture") == 0)
+        {
+            g_CapturePath = argv[i + 1];
+        }
+        if(::wcscmp(argv[i], L"--pipeline-cache") == 0)
+        {
+            g_PipelineCachePath = argv[i + 1];
+        }
+        if(::wcscmp(argv[i], L"--pipeline-fallback") == 0)
+        {
+            g_PipelineFallback = true;
+        }
+#if !defined(_WIN32)
+        if(::wcscmp(argv[i], L"--gpu-latency") == 0)
+        {
+            g_NullGpuLatency = std::chrono::microseconds(::wcstoul(argv[i + 1], nullptr, 10));
+        }
+        if(::wcscmp(argv[i], L"--pipeline-latency") == 0)
+        {
+            g_NullPipelineLatency = std::chrono::microseconds(::wcstoul(argv[i + 1], nullptr, 10));
+        }
+#endif
     }
 
     ::LocalFree(argv);
+
+    if(g_BenchmarkFrames > 0)
+    {
+        g_Vsync = false;
+        g_Benchmark = std::make_unique<BenchmarkRecorder>(g_BenchmarkFrames, g_BenchmarkWarmupFrames);
+    }
 }
 
+#if defined(_WIN32)
 void EnableDebugLayer()
 {
 #if defined(_DEBUG)
@@ -191,6 +363,12 @@ ComPtr<ID3D12Device2> CreateDevice(ComPtr<IDXGIAdapter4> adapter)
 
     return d3d12Device2;
 }
+#else
+ComPtr<ID3D12Device2> CreateDevice()
+{
+    return CreateNullDevice(g_NullGpuLatency, g_NullPipelineLatency);
+}
+#endif
 
 ComPtr<ID3D12CommandQueue> CreateCommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type)
 {
@@ -211,6 +389,7 @@ bool CheckTearingSupport()
 {
     BOOL allowedTearing = FALSE;
 
+#if defined(_WIN32)
     ComPtr<IDXGIFactory4> factory4;
     if(SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&factory4))))
     {
@@ -223,6 +402,9 @@ bool CheckTearingSupport()
             }
         }
     }
+#else
+    allowedTearing = TRUE;
+#endif
 
     return allowedTearing == TRUE;
 }
@@ -235,13 +417,6 @@ ComPtr<IDXGISwapChain4> CreateSwapChain(
     uint32_t bufferCount)
 {
     ComPtr<IDXGISwapChain4> dxgiSwapChain4;
-    ComPtr<IDXGIFactory4> dxgiFactory4;
-    UINT createFactoryFlags = 0;
-#if defined(_DEBUG)
-    // createFactoryFlags = DXGI_CREATE_FACTORY_DEBUG;
-#endif
-
-    ThrowIfFailed(CreateDXGIFactory2(createFactoryFlags, IID_PPV_ARGS(&dxgiFactory4)));
 
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc;
     swapChainDesc.Width = width;
@@ -252,9 +427,22 @@ ComPtr<IDXGISwapChain4> CreateSwapChain(
     swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
     swapChainDesc.BufferCount = bufferCount;
     swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
-    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
     swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
     swapChainDesc.Flags = CheckTearingSupport() ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
+    if(g_MaxFrameLatency > 0)
+    {
+        swapChainDesc.Flags |= DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+    }
+
+#if defined(_WIN32)
+    ComPtr<IDXGIFactory4> dxgiFactory4;
+    UINT createFactoryFlags = 0;
+#if defined(_DEBUG)
+    // createFactoryFlags = DXGI_CREATE_FACTORY_DEBUG;
+#endif
+
+    ThrowIfFailed(CreateDXGIFactory2(createFactoryFlags, IID_PPV_ARGS(&dxgiFactory4)));
 
     ComPtr<IDXGISwapChain1> dxgiSwapChain1;
     ThrowIfFailed(dxgiFactory4->CreateSwapChainForHwnd(
@@ -266,69 +454,29 @@ ComPtr<IDXGISwapChain4> CreateSwapChain(
         &dxgiSwapChain1));
     ThrowIfFailed(dxgiFactory4->MakeWindowAssociation(hWnd, DXGI_MWA_NO_ALT_ENTER));
     ThrowIfFailed(dxgiSwapChain1.As(&dxgiSwapChain4));
+#else
+    dxgiSwapChain4 = CreateNullSwapChain(commandQueue, swapChainDesc);
+#endif
 
     return dxgiSwapChain4;
 }
 
-ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors)
-{
-    ComPtr<ID3D12DescriptorHeap> descriptorHeap;
-
-    D3D12_DESCRIPTOR_HEAP_DESC des = {};
-    des.NumDescriptors = numDescriptors;
-    des.Type = type;
-
-    ThrowIfFailed(device->CreateDescriptorHeap(&des, IID_PPV_ARGS(&descriptorHeap)));
-
-    return descriptorHeap;
-}
-
 void UpdateRenderTargetViews(
     const ComPtr<ID3D12Device2>& device,
-    const ComPtr<IDXGISwapChain4>& swapChain,
-    const ComPtr<ID3D12DescriptorHeap>& descriptorHeap)
+    const ComPtr<IDXGISwapChain4>& swapChain)
 {
-    auto rvtDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rvtHandle(descriptorHeap->GetCPUDescriptorHandleForHeapStart());
-
     for (UINT i = 0; i < g_NumFrames; ++i)
     {
         ComPtr<ID3D12Resource> backBuffer;
         ThrowIfFailed(swapChain->GetBuffer(i, IID_PPV_ARGS(&backBuffer)));
 
-        device->CreateRenderTargetView(backBuffer.Get(), nullptr, rvtHandle);
-
-        g_BackBuffers[i] = backBuffer;
+        device->CreateRenderTargetView(backBuffer.Get(), nullptr, g_FrameContexts[i].RenderTargetView.GetHandle());
 
-        rvtHandle.Offset(rvtDescriptorSize);
+        g_FrameContexts[i].BackBuffer = backBuffer;
+        ResourceStateTracker::AddGlobalState(backBuffer.Get(), D3D12_RESOURCE_STATE_PRESENT);
     }
 }
 
-ComPtr<ID3D12CommandAllocator> CreateCommandAllocator(
-    const ComPtr<ID3D12Device2>& device,
-    const D3D12_COMMAND_LIST_TYPE& type)
-{
-    ComPtr<ID3D12CommandAllocator> allocator;
-    ThrowIfFailed(device->CreateCommandAllocator(type, IID_PPV_ARGS(&allocator)));
-
-    return allocator;
-}
-
-ComPtr<ID3D12GraphicsCommandList> CreateCommandList(
-    const ComPtr<ID3D12Device2>& device,
-    const ComPtr<ID3D12CommandAllocator>& allocator,
-    const D3D12_COMMAND_LIST_TYPE& type)
-{
-    ComPtr<ID3D12GraphicsCommandList> commandList;
-
-    ThrowIfFailed(device->CreateCommandList(0, type, allocator.Get(), nullptr, IID_PPV_ARGS(&commandList)));
-
-    ThrowIfFailed(commandList->Close());
-
-    return commandList;
-}
-
 ComPtr<ID3D12Fence> CreateFence(ComPtr<ID3D12Device2> device)
 {
     ComPtr<ID3D12Fence> fence;
@@ -401,71 +549,270 @@ void Update()
         sprintf_s(buffer, 500, "FPS: %f\n", fps);
         std::cout << buffer;
 
+        sprintf_s(buffer, 500, "Barriers eliminated per frame: %f\n", g_EliminatedBarriers / static_cast<double>(frameCounter));
+        std::cout << buffer;
+        g_EliminatedBarriers = 0;
+
+        if(g_DisplayLatency >= 0)
+        {
+            sprintf_s(buffer, 500, "Present to display: %f ms\n", g_DisplayLatency);
+            std::cout << buffer;
+        }
+
         frameCounter = 0;
         elapsedSeconds = 0;
     }
 }
 
-void Render()
+double ToMilliseconds(std::chrono::high_resolution_clock::duration duration)
 {
-    auto allocator = g_CommandAllocators[g_CurrentBackBufferIndex];
-    auto backBuffer = g_BackBuffers[g_CurrentBackBufferIndex];
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
 
-    allocator->Reset();
-    g_CommandList->Reset(allocator.Get(), nullptr);
+// Blocks until the swap chain can queue another frame and the frame's context is free again.
+void WaitForNextFrame()
+{
+    std::chrono::high_resolution_clock clock;
+    auto waitStart = clock.now();
+
+    if(g_FrameLatencyWaitable)
+    {
+        ::WaitForSingleObject(g_FrameLatencyWaitable, 1000);
+        WaitForFenceValue(g_Fence, g_FrameContexts[g_CurrentBackBufferIndex].FenceValue, g_FenceEvent);
+    }
+
+    g_FrameStartWait = ToMilliseconds(clock.now() - waitStart);
+}
 
+// Returns the time from Present until the most recently displayed frame reached the screen, or -1
+// when no new frame has been displayed since the last call.
+double MeasureDisplayLatency()
+{
+    DXGI_FRAME_STATISTICS statistics;
+    if(FAILED(g_SwapChain->GetFrameStatistics(&statistics)) || statistics.PresentCount == g_LastDisplayedPresentCount)
     {
-        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-            backBuffer.Get(),
-            D3D12_RESOURCE_STATE_PRESENT,
-            D3D12_RESOURCE_STATE_RENDER_TARGET);
+        return -1;
+    }
 
-        g_CommandList->ResourceBarrier(1, &barrier);
+    g_LastDisplayedPresentCount = statistics.PresentCount;
+
+    const PresentTime& present = g_PresentTimes[statistics.PresentCount % g_PresentHistorySize];
+    if(present.PresentCount != statistics.PresentCount)
+    {
+        return -1;
     }
 
+    LARGE_INTEGER frequency;
+    ::QueryPerformanceFrequency(&frequency);
+
+    return (statistics.SyncQPCTime.QuadPart - present.Time) * 1000.0 / frequency.QuadPart;
+}
+
+void Render()
+{
+    std::chrono::high_resolution_clock clock;
+    auto recordStart = clock.now();
+
+    FrameContext& frame = g_FrameContexts[g_CurrentBackBufferIndex];
+    auto backBuffer = frame.BackBuffer;
+
+    g_ReleaseQueue->Collect();
+
+    D3D12_CPU_DESCRIPTOR_HANDLE rvt = frame.RenderTargetView.GetHandle();
+
+    g_RenderGraph->Reset();
+    RenderGraphResource backBufferResource = g_RenderGraph->ImportResource(backBuffer.Get());
+
+    g_RenderGraph->AddPass("Clear", {}, {{backBufferResource, D3D12_RESOURCE_STATE_RENDER_TARGET}}, [&](ID3D12GraphicsCommandList* commandList)
     {
         FLOAT clearColor[] = {1, 0, 0, 0};
-        CD3DX12_CPU_DESCRIPTOR_HANDLE rvt(
-            g_RTVDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
-            g_CurrentBackBufferIndex,
-            g_RTVDescriptorSize);
 
-        g_CommandList->ClearRenderTargetView(
+        commandList->ClearRenderTargetView(
             rvt,
             clearColor,
             0,
             nullptr);
-    }
+    });
 
+    if(g_Scene && g_Scene->Update())
     {
-        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-            backBuffer.Get(),
-            D3D12_RESOURCE_STATE_RENDER_TARGET,
-            D3D12_RESOURCE_STATE_PRESENT);
+        g_RenderGraph->AddExternalPass("Scene", {}, {{backBufferResource, D3D12_RESOURCE_STATE_RENDER_TARGET}}, [&](std::vector<TrackedCommandList>& commandLists)
+        {
+            g_ParallelRecorder->Record(g_Scene->GetDrawCount(), [&](ID3D12GraphicsCommandList* commandList, uint32_t begin, uint32_t end)
+            {
+                g_Scene->RecordSetup(commandList, rvt, g_ClientWidth, g_ClientHeight);
+                g_Scene->RecordDraws(commandList, *g_UploadRing, begin, end);
+            });
 
-        g_CommandList->ResourceBarrier(1, &barrier);
+            std::vector<ID3D12CommandList*> drawCommandLists;
+            g_ParallelRecorder->GetCommandLists(drawCommandLists);
+            for (ID3D12CommandList* commandList : drawCommandLists)
+            {
+                commandLists.push_back({commandList, nullptr});
+            }
+        });
     }
 
-    ThrowIfFailed(g_CommandList->Close());
-
-    ID3D12CommandList* const commandLists[] =
+    if(g_FrameCapture)
     {
-        g_CommandList.Get()
-    };
-    g_CommandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+        g_RenderGraph->AddPass("Capture", {{backBufferResource, D3D12_RESOURCE_STATE_COPY_SOURCE}}, {}, [&](ID3D12GraphicsCommandList* commandList)
+        {
+            g_FrameCapture->Capture(commandList, backBuffer.Get());
+        }, RenderGraphPassFlags_SideEffects);
+    }
+
+    g_RenderGraph->SetOutput(backBufferResource, D3D12_RESOURCE_STATE_PRESENT);
+
+    std::vector<TrackedCommandList> trackedLists;
+    g_RenderGraph->Execute(trackedLists);
+
+    std::vector<ID3D12CommandList*> commandLists;
+    g_BarrierResolver->Resolve(trackedLists, commandLists);
+
+    g_EliminatedBarriers += g_RenderGraph->GetBarrierStatistics().Eliminated;
+
+    auto executeStart = clock.now();
+
+    g_CommandQueue->ExecuteCommandLists(static_cast<UINT>(commandLists.size()), commandLists.data());
+
+    auto presentStart = clock.now();
 
     UINT syncInterval = g_Vsync ? 1 : 0;
-    UINT presentFlags = g_TearingSupported && !g_Vsync ? DXGI_FEATURE_PRESENT_ALLOW_TEARING : 0;
+    UINT presentFlags = g_TearingSupported && !g_Vsync ? DXGI_PRESENT_ALLOW_TEARING : 0;
+    LARGE_INTEGER presentTime;
+    ::QueryPerformanceCounter(&presentTime);
     ThrowIfFailed(g_SwapChain->Present(syncInterval, presentFlags));
 
-    g_FenceValues[g_CurrentBackBufferIndex] = Signal(
+    UINT presentCount;
+    if(SUCCEEDED(g_SwapChain->GetLastPresentCount(&presentCount)))
+    {
+        g_PresentTimes[presentCount % g_PresentHistorySize] = {presentCount, presentTime.QuadPart};
+    }
+
+    auto fenceWaitStart = clock.now();
+
+    frame.FenceValue = Signal(
         g_CommandQueue,
         g_Fence,
         g_FenceValue);
 
+    g_UploadRing->FinishFrame(g_Fence, frame.FenceValue);
+    g_ReadbackRing->FinishFrame(g_Fence, frame.FenceValue);
+    g_BarrierResolver->Release(g_Fence, frame.FenceValue);
+    g_RenderGraph->Release(g_Fence, frame.FenceValue);
+    if(g_Scene)
+    {
+        g_ParallelRecorder->Release(g_Fence, frame.FenceValue);
+    }
+
     g_CurrentBackBufferIndex = g_SwapChain->GetCurrentBackBufferIndex();
     
-    WaitForFenceValue(g_Fence, g_FenceValues[g_CurrentBackBufferIndex], g_FenceEvent);
+    if(!g_FrameLatencyWaitable)
+    {
+        WaitForFenceValue(g_Fence, g_FrameContexts[g_CurrentBackBufferIndex].FenceValue, g_FenceEvent);
+    }
+
+    auto frameEnd = clock.now();
+
+    double displayLatency = MeasureDisplayLatency();
+    if(displayLatency >= 0)
+    {
+        g_DisplayLatency = displayLatency;
+    }
+
+    g_FrameTimings[FrameStage_Record] = ToMilliseconds(executeStart - recordStart);
+    g_FrameTimings[FrameStage_Execute] = ToMilliseconds(presentStart - executeStart);
+    g_FrameTimings[FrameStage_Present] = ToMilliseconds(fenceWaitStart - presentStart);
+    g_FrameTimings[FrameStage_FenceWait] = g_FrameStartWait + ToMilliseconds(frameEnd - fenceWaitStart);
+    g_FrameTimings[FrameStage_Total] = g_FrameStartWait + ToMilliseconds(frameEnd - recordStart);
+    g_FrameTimings[FrameStage_DisplayLatency] = displayLatency;
+}
+
+// Returns true once the benchmark has recorded all of its frames.
+bool AdvanceBenchmark()
+{
+    if(!g_Benchmark)
+    {
+        return false;
+    }
+
+    g_Benchmark->AddFrame(g_FrameTimings);
+
+    return g_Benchmark->IsComplete();
+}
+
+// Writes the benchmark report and returns the process exit code: non-zero when the report could
+// not be written or a budget entry was exceeded.
+int FinishBenchmark()
+{
+    if(!g_Benchmark)
+    {
+        return 0;
+    }
+
+    TimingSummary total = g_Benchmark->Summarize(FrameStage_Total);
+    char buffer[500];
+    sprintf_s(buffer, 500, "Benchmark: avg %.3f ms, p99 %.3f ms, max %.3f ms\n", total.Avg, total.P99, total.Max);
+    std::cout << buffer;
+
+    if(!g_Benchmark->WriteReport(g_BenchmarkOutputPath))
+    {
+        std::cout << "Benchmark: cannot write report" << std::endl;
+        return 1;
+    }
+
+    if(!g_BenchmarkBudgetPath.empty() && !g_Benchmark->CheckBudget(g_BenchmarkBudgetPath))
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+// Waits for the captured frames still being written and reports how many made it to disk.
+void FinishCapture()
+{
+    if(!g_FrameCapture)
+    {
+        return;
+    }
+
+    g_FrameCapture->Drain();
+
+    FrameCaptureStatistics statistics = g_FrameCapture->GetStatistics();
+    std::cout << "Capture: " << statistics.Written << " frames written ("
+              << statistics.BytesWritten << " bytes), dropped: " << statistics.Dropped << std::endl;
+
+    g_FrameCapture.reset();
+}
+
+// Writes new pipelines back to the cache file and reports how much compiling it saved. Pipelines
+// still being compiled are waited for, so they are written too.
+void FinishPipelineCache()
+{
+    if(!g_PipelineCache)
+    {
+        return;
+    }
+
+    g_PipelineCompiler->Drain();
+
+    PipelineCompilerStatistics compilerStatistics = g_PipelineCompiler->GetStatistics();
+    g_PipelineCompiler.reset();
+
+    std::cout << "Pipeline compiler: " << compilerStatistics.Compiled << " compiled, "
+              << compilerStatistics.Failed << " failed, longest wait: " << compilerStatistics.MaxLatencyMilliseconds << " ms" << std::endl;
+
+    g_PipelineCache->Save();
+
+    PipelineCacheStatistics statistics = g_PipelineCache->GetStatistics();
+    std::cout << "Pipeline cache: " << statistics.Hits << " hits, " << statistics.Misses << " misses"
+              << (statistics.Invalidated ? " (invalidated)" : "")
+              << ", compile: " << statistics.CompileMilliseconds << " ms"
+              << ", load: " << statistics.LoadMilliseconds << " ms"
+              << ", saved: " << statistics.SavedMilliseconds << " ms" << std::endl;
+
+    g_PipelineCache.reset();
 }
 
 void Resize(uint32_t width, uint32_t height)
@@ -478,12 +825,17 @@ void Resize(uint32_t width, uint32_t height)
         return;
     }
 
+    g_ClientWidth = width;
+    g_ClientHeight = height;
+
     Flush(g_CommandQueue, g_Fence, g_FenceValue, g_FenceEvent);
 
-    for (int i = 0; i < g_NumFrames; ++i)
+    uint64_t currentFenceValue = g_FrameContexts[g_CurrentBackBufferIndex].FenceValue;
+    for (FrameContext& frame : g_FrameContexts)
     {
-        g_BackBuffers[i].Reset();
-        g_FenceValues[i] = g_FenceValues[g_CurrentBackBufferIndex];
+        ResourceStateTracker::RemoveGlobalState(frame.BackBuffer.Get());
+        frame.BackBuffer.Reset();
+        frame.FenceValue = currentFenceValue;
     }
 
     DXGI_SWAP_CHAIN_DESC swapChainDes = {};
@@ -497,9 +849,470 @@ void Resize(uint32_t width, uint32_t height)
 
     g_CurrentBackBufferIndex = g_SwapChain->GetCurrentBackBufferIndex();
 
-    UpdateRenderTargetViews(g_Device, g_SwapChain, g_RTVDescriptorHeap);
+    UpdateRenderTargetViews(g_Device, g_SwapChain);
+}
+
+void InitializeD3D12(HWND hWnd, const ComPtr<ID3D12Device2>& device)
+{
+    g_Device = device;
+
+    g_CommandQueue = CreateCommandQueue(g_Device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+    g_SwapChain = CreateSwapChain(hWnd, g_CommandQueue, g_ClientWidth, g_ClientHeight, g_NumFrames);
+
+    if(g_MaxFrameLatency > 0)
+    {
+        ThrowIfFailed(g_SwapChain->SetMaximumFrameLatency(g_MaxFrameLatency));
+        g_FrameLatencyWaitable = g_SwapChain->GetFrameLatencyWaitableObject();
+    }
+
+    g_CurrentBackBufferIndex = g_SwapChain->GetCurrentBackBufferIndex();
+
+    // Pages are only created on first use, so heap types nothing allocates from cost nothing.
+    for (int type = 0; type < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++type)
+    {
+        g_DescriptorAllocators[type] = std::make_unique<DescriptorAllocator>(g_Device, static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(type));
+    }
+
+    g_BindlessHeap = std::make_unique<BindlessHeap>(g_Device, g_BindlessCapacity);
+    g_ResourceAllocator = std::make_unique<ResourceAllocator>(g_Device);
+    g_ReleaseQueue = std::make_unique<ReleaseQueue>();
+
+    g_FrameContexts.resize(g_NumFrames);
+    for (FrameContext& frame : g_FrameContexts)
+    {
+        frame.RenderTargetView = g_DescriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_RTV]->Allocate();
+    }
+
+    UpdateRenderTargetViews(g_Device, g_SwapChain);
+
+    g_Fence = CreateFence(g_Device);
+    g_FenceEvent = CreateEventHandle();
+    g_FenceWaiter = std::make_unique<FenceWaiter>();
+    if(g_CapturePath.empty())
+    {
+        g_ReadbackRing = std::make_unique<ReadbackRing>(g_Device, *g_FenceWaiter, g_NumFrames);
+    }
+    else
+    {
+        // Each capture thread holds a slot while it converts, on top of the frames in flight.
+        g_ReadbackRing = std::make_unique<ReadbackRing>(g_Device, *g_FenceWaiter, g_NumFrames + g_CaptureThreadCount);
+        try
+        {
+            g_FrameCapture = std::make_unique<FrameCapture>(g_CapturePath, *g_ReadbackRing, g_CaptureThreadCount, 2 * g_CaptureThreadCount);
+        }
+        catch (const std::filesystem::filesystem_error& error)
+        {
+            std::cout << "Capture: " << error.what() << ", running without it" << std::endl;
+        }
+    }
+
+    g_CommandAllocatorPool = std::make_unique<CommandAllocatorPool>(g_Device);
+
+    g_RenderGraph = std::make_unique<RenderGraph>(g_Device, *g_CommandAllocatorPool, *g_ReleaseQueue);
+    g_BarrierResolver = std::make_unique<PendingBarrierResolver>(g_Device, *g_CommandAllocatorPool);
+
+    BarrierBackend barrierBackend = g_LegacyBarriers ? BarrierBackend_Legacy : ChooseBarrierBackend(g_Device);
+    ResourceStateTracker::SetBarrierBackend(barrierBackend);
+    std::cout << "Barriers: " << GetBarrierBackendName(barrierBackend) << std::endl;
+
+    g_PipelineCache = std::make_unique<PipelineCache>(g_Device, g_PipelineCachePath);
+    g_PipelineCompiler = std::make_unique<PipelineCompiler>(*g_PipelineCache, g_PipelineCompileThreadCount);
+
+    uint64_t uploadMemoryPerFrame = g_UploadMemoryPerFrame;
+    if(g_DrawCount > 0)
+    {
+        g_Scene = std::make_unique<Scene>(
+            *g_ResourceAllocator,
+            *g_BindlessHeap,
+            *g_PipelineCache,
+            *g_PipelineCompiler,
+            g_PipelineFallback,
+            DXGI_FORMAT_R8G8B8A8_UNORM,
+            g_DrawCount);
+        g_ParallelRecorder = std::make_unique<ParallelRecorder>(g_Device, *g_CommandAllocatorPool, g_RecordThreadCount);
+        uploadMemoryPerFrame += g_Scene->GetUploadSize();
+    }
+
+    // One frame more than can be in flight, so space lost to wrapping never makes a frame wait.
+    g_UploadRing = std::make_unique<UploadRing>(g_Device, (g_NumFrames + 1) * uploadMemoryPerFrame);
+}
+
+// Records the scene with every thread count up to g_RecordThreadCount without submitting anything,
+// and prints how many draws per millisecond each one managed.
+void RunRecordBenchmark()
+{
+    constexpr uint32_t iterations = 20;
+
+    Scene scene(
+        *g_ResourceAllocator,
+        *g_BindlessHeap,
+        *g_PipelineCache,
+        *g_PipelineCompiler,
+        false,
+        DXGI_FORMAT_R8G8B8A8_UNORM,
+        g_DrawCount > 0 ? g_DrawCount : 100000);
+    // Recording is measured with the real pipeline bound.
+    g_PipelineCompiler->Drain();
+    scene.Update();
+    D3D12_CPU_DESCRIPTOR_HANDLE rvt = g_FrameContexts[0].RenderTargetView.GetHandle();
+    UploadRing uploadRing(g_Device, 2 * scene.GetUploadSize());
+
+    for (uint32_t threadCount = 1; threadCount <= g_RecordThreadCount; ++threadCount)
+    {
+        ParallelRecorder recorder(g_Device, *g_CommandAllocatorPool, threadCount);
+
+        std::chrono::high_resolution_clock clock;
+        std::chrono::high_resolution_clock::duration elapsed(0);
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            auto start = clock.now();
+            recorder.Record(scene.GetDrawCount(), [&](ID3D12GraphicsCommandList* commandList, uint32_t begin, uint32_t end)
+            {
+                scene.RecordSetup(commandList, rvt, g_ClientWidth, g_ClientHeight);
+                scene.RecordDraws(commandList, uploadRing, begin, end);
+            });
+            elapsed += clock.now() - start;
+
+            // Nothing was submitted, so the allocators and upload space are free again straight away.
+            recorder.Release(g_Fence, 0);
+            uploadRing.FinishFrame(g_Fence, 0);
+        }
+
+        char buffer[500];
+        sprintf_s(buffer, 500, "Record threads: %u, draws/ms: %f\n", threadCount,
+                  static_cast<double>(scene.GetDrawCount()) * iterations / ToMilliseconds(elapsed));
+        std::cout << buffer;
+    }
+}
+
+struct AllocationEvent
+{
+    // Frees the resource allocated by event Id instead, if not set.
+    bool Allocate;
+    uint32_t Id;
+    D3D12_RESOURCE_DESC Desc;
+};
+
+// A fixed mix of streaming-like allocations: mostly small constant and vertex buffers, some large
+// buffers, textures and render targets, freed in random order.
+std::vector<AllocationEvent> CreateAllocationTrace(uint32_t allocationCount)
+{
+    std::mt19937 random(1);
+    std::vector<AllocationEvent> trace;
+    std::vector<uint32_t> live;
+
+    for (uint32_t id = 0; id < allocationCount; ++id)
+    {
+        while (!live.empty() && (live.size() >= 2048 || random() % 2 == 0))
+        {
+            size_t index = random() % live.size();
+            trace.push_back({false, live[index], {}});
+            live[index] = live.back();
+            live.pop_back();
+        }
+
+        D3D12_RESOURCE_DESC desc;
+        uint32_t kind = random() % 100;
+        if(kind < 50)
+        {
+            desc = CD3DX12_RESOURCE_DESC::Buffer(256 * (1 + random() % 128));
+        }
+        else if(kind < 75)
+        {
+            desc = CD3DX12_RESOURCE_DESC::Buffer((64 << 10) + random() % (8 << 20));
+        }
+        else if(kind < 92)
+        {
+            uint32_t side = 16u << (random() % 8);
+            desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, side, side);
+        }
+        else
+        {
+            uint32_t side = 256u << (random() % 4);
+            desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16G16B16A16_FLOAT, side, side, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+        }
+
+        trace.push_back({true, id, desc});
+        live.push_back(id);
+    }
+
+    for (uint32_t id : live)
+    {
+        trace.push_back({false, id, {}});
+    }
+
+    return trace;
+}
+
+// Replays the same allocation trace with a committed resource per allocation and with the resource
+// allocator, and prints the time each takes per call and how much memory they held at their peak.
+void RunAllocationBenchmark()
+{
+    constexpr uint32_t allocationCount = 20000;
+    std::vector<AllocationEvent> trace = CreateAllocationTrace(allocationCount);
+
+    uint64_t requested = 0;
+    uint64_t peakRequested = 0;
+    uint64_t committed = 0;
+    uint64_t peakCommitted = 0;
+    std::vector<uint64_t> sizes(allocationCount);
+    std::vector<uint64_t> committedSizes(allocationCount);
+    for (const AllocationEvent& event : trace)
+    {
+        if(event.Allocate)
+        {
+            // What the resource itself needs, against what it takes once committed on its own.
+            D3D12_RESOURCE_ALLOCATION_INFO info = g_Device->GetResourceAllocationInfo(0, 1, &event.Desc);
+            sizes[event.Id] = event.Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? event.Desc.Width : info.SizeInBytes;
+            committedSizes[event.Id] = info.SizeInBytes;
+        }
+
+        requested = event.Allocate ? requested + sizes[event.Id] : requested - sizes[event.Id];
+        committed = event.Allocate ? committed + committedSizes[event.Id] : committed - committedSizes[event.Id];
+        peakRequested = std::max(peakRequested, requested);
+        peakCommitted = std::max(peakCommitted, committed);
+    }
+
+    auto initialState = [](const D3D12_RESOURCE_DESC& desc)
+    {
+        return (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET) ? D3D12_RESOURCE_STATE_RENDER_TARGET : D3D12_RESOURCE_STATE_COMMON;
+    };
+
+    std::chrono::high_resolution_clock clock;
+    std::chrono::high_resolution_clock::duration allocateTime(0);
+    std::chrono::high_resolution_clock::duration freeTime(0);
+
+    {
+        std::vector<ComPtr<ID3D12Resource>> resources(allocationCount);
+        CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+        for (const AllocationEvent& event : trace)
+        {
+            auto start = clock.now();
+            if(event.Allocate)
+            {
+                ThrowIfFailed(g_Device->CreateCommittedResource(
+                    &heapProperties,
+                    D3D12_HEAP_FLAG_NONE,
+                    &event.Desc,
+                    initialState(event.Desc),
+                    nullptr,
+                    IID_PPV_ARGS(&resources[event.Id])));
+                allocateTime += clock.now() - start;
+            }
+            else
+            {
+                resources[event.Id].Reset();
+                freeTime += clock.now() - start;
+            }
+        }
+    }
+
+    char buffer[500];
+    sprintf_s(buffer, 500, "Committed: allocate %f us, free %f us, peak memory %f MB (%f MB requested)\n",
+              ToMilliseconds(allocateTime) * 1000 / allocationCount,
+              ToMilliseconds(freeTime) * 1000 / allocationCount,
+              peakCommitted / 1048576.0,
+              peakRequested / 1048576.0);
+    std::cout << buffer;
+
+    allocateTime = freeTime = std::chrono::high_resolution_clock::duration(0);
+    uint64_t peakReserved = 0;
+    double peakFragmentation = 0;
+
+    {
+        ResourceAllocator allocator(g_Device);
+        std::vector<ResourceAllocation> allocations(allocationCount);
+        for (const AllocationEvent& event : trace)
+        {
+            auto start = clock.now();
+            if(event.Allocate)
+            {
+                allocations[event.Id] = allocator.Allocate(D3D12_HEAP_TYPE_DEFAULT, event.Desc, initialState(event.Desc));
+                allocateTime += clock.now() - start;
+
+                // Sampled at each allocation, outside the timing.
+                ResourceAllocatorStatistics statistics = allocator.GetStatistics();
+                peakReserved = std::max(peakReserved, statistics.Reserved + statistics.CommittedSize);
+                peakFragmentation = std::max(peakFragmentation, statistics.Fragmentation);
+            }
+            else
+            {
+                allocator.Free(allocations[event.Id]);
+                freeTime += clock.now() - start;
+            }
+        }
+    }
+
+    sprintf_s(buffer, 500, "Placed: allocate %f us, free %f us, peak memory %f MB, peak fragmentation %f\n",
+              ToMilliseconds(allocateTime) * 1000 / allocationCount,
+              ToMilliseconds(freeTime) * 1000 / allocationCount,
+              peakReserved / 1048576.0,
+              peakFragmentation);
+    std::cout << buffer;
+}
+
+// Copies RGBA8 textures of typical sizes into a mapped UPLOAD buffer with d3dx12's MemcpySubresource
+// and with CopySubresource, and prints the throughput of each. 1000x1000 has a row pitch that needs
+// padding, so its rows can't be merged. Then uploads a texture array with mips through d3dx12's
+// UpdateSubresources and UpdateSubresourcesParallel, and times getting its layout from the device
+// against g_FootprintCache. Copy speed compares the routines on one thread; scaling compares the same
+// routine on one thread and on g_RecordThreadCount, so neither figure hides in the other.
+void RunCopyBenchmark()
+{
+    const uint32_t sizes[] = {256, 1000, 1024, 2048, 4096};
+    constexpr uint64_t bytesPerRun = 512ull << 20;
+
+    D3D12_RESOURCE_DESC largestDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 4096, 4096, 1, 1);
+    UINT64 uploadSize;
+    g_Device->GetCopyableFootprints(&largestDesc, 0, 1, 0, nullptr, nullptr, nullptr, &uploadSize);
+
+    ComPtr<ID3D12Resource> uploadBuffer;
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadSize);
+    ThrowIfFailed(g_Device->CreateCommittedResource(
+        &heapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&uploadBuffer)));
+
+    void* uploadData;
+    CD3DX12_RANGE readRange(0, 0);
+    ThrowIfFailed(uploadBuffer->Map(0, &readRange, &uploadData));
+
+    WorkerPool singleWorker(1);
+    WorkerPool workers(g_RecordThreadCount);
+    std::vector<uint8_t> pixels(static_cast<size_t>(4096) * 4096 * 4, 0x5a);
+
+    // Returns GB/s.
+    auto measure = [](uint64_t size, const std::function<void()>& copy)
+    {
+        uint32_t iterations = static_cast<uint32_t>(std::max<uint64_t>(4, bytesPerRun / size));
+
+        std::chrono::high_resolution_clock clock;
+        auto start = clock.now();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            copy();
+        }
+
+        return static_cast<double>(size) * iterations / ToMilliseconds(clock.now() - start) / 1e6;
+    };
+
+    char buffer[500];
+
+    for (uint32_t size : sizes)
+    {
+        D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, 1, 1);
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout;
+        UINT rowCount;
+        UINT64 rowSize;
+        g_Device->GetCopyableFootprints(&desc, 0, 1, 0, &layout, &rowCount, &rowSize, nullptr);
+
+        D3D12_SUBRESOURCE_DATA source = {pixels.data(), static_cast<LONG_PTR>(rowSize), static_cast<LONG_PTR>(rowSize * rowCount)};
+        D3D12_MEMCPY_DEST destination = {uploadData, layout.Footprint.RowPitch, static_cast<SIZE_T>(layout.Footprint.RowPitch) * rowCount};
+        uint64_t copySize = rowSize * rowCount;
+
+        double rowByRow = measure(copySize, [&] { MemcpySubresource(&destination, &source, static_cast<SIZE_T>(rowSize), rowCount, 1); });
+        double singleThread = measure(copySize, [&] { CopySubresource(destination, source, static_cast<SIZE_T>(rowSize), rowCount, 1, true); });
+        double multiThread = measure(copySize, [&] { CopySubresource(destination, source, static_cast<SIZE_T>(rowSize), rowCount, 1, true, &workers); });
+
+        sprintf_s(buffer, 500, "Copy %ux%u: MemcpySubresource %.2f GB/s, CopySubresource %.2f GB/s; %u threads %.2f GB/s, %.2fx one\n",
+                  size, size, rowByRow, singleThread, g_RecordThreadCount, multiThread, multiThread / singleThread);
+        std::cout << buffer;
+    }
+
+    // A whole texture the way a loader would upload it: six 1024x1024 slices, as in a cube map, with full mip chains.
+    D3D12_RESOURCE_DESC arrayDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 1024, 1024, 6, 11);
+    constexpr UINT subresourceCount = 6 * 11;
+
+    ComPtr<ID3D12Resource> texture;
+    CD3DX12_HEAP_PROPERTIES textureHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+    ThrowIfFailed(g_Device->CreateCommittedResource(
+        &textureHeapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &arrayDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&texture)));
+
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresourceCount);
+    std::vector<UINT> rowCounts(subresourceCount);
+    std::vector<UINT64> rowSizes(subresourceCount);
+    UINT64 requiredSize;
+    g_Device->GetCopyableFootprints(&arrayDesc, 0, subresourceCount, 0, layouts.data(), rowCounts.data(), rowSizes.data(), &requiredSize);
+
+    // Every subresource reads from the start of the same pixels.
+    std::vector<D3D12_SUBRESOURCE_DATA> sources(subresourceCount);
+    uint64_t textureSize = 0;
+    for (UINT i = 0; i < subresourceCount; ++i)
+    {
+        sources[i] = {pixels.data(), static_cast<LONG_PTR>(rowSizes[i]), static_cast<LONG_PTR>(rowSizes[i] * rowCounts[i])};
+        textureSize += rowSizes[i] * rowCounts[i];
+    }
+
+    // Nothing recorded is ever submitted, so the allocator is free again straight away.
+    ComPtr<ID3D12CommandAllocator> allocator = g_CommandAllocatorPool->Acquire(D3D12_COMMAND_LIST_TYPE_DIRECT);
+    ComPtr<ID3D12GraphicsCommandList> commandList;
+    ThrowIfFailed(g_Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&commandList)));
+
+    double serial = measure(textureSize, [&]
+    {
+        UpdateSubresources(commandList.Get(), texture.Get(), uploadBuffer.Get(), 0, subresourceCount, requiredSize,
+                           layouts.data(), rowCounts.data(), rowSizes.data(), sources.data());
+    });
+    double singleThread = measure(textureSize, [&]
+    {
+        UpdateSubresourcesParallel(commandList.Get(), texture.Get(), uploadBuffer.Get(), 0, 0, subresourceCount, sources.data(),
+                                   g_FootprintCache, singleWorker);
+    });
+    double multiThread = measure(textureSize, [&]
+    {
+        UpdateSubresourcesParallel(commandList.Get(), texture.Get(), uploadBuffer.Get(), 0, 0, subresourceCount, sources.data(),
+                                   g_FootprintCache, workers);
+    });
+
+    ThrowIfFailed(commandList->Close());
+    g_CommandAllocatorPool->Release(D3D12_COMMAND_LIST_TYPE_DIRECT, allocator, g_Fence, 0);
+
+    sprintf_s(buffer, 500, "UpdateSubresources 1024x1024x6 with mips: d3dx12 %.2f GB/s, UpdateSubresourcesParallel %.2f GB/s; %u threads %.2f GB/s, %.2fx one\n",
+              serial, singleThread, g_RecordThreadCount, multiThread, multiThread / singleThread);
+    std::cout << buffer;
+
+    // The layout as d3dx12's GetRequiredIntermediateSize and UpdateSubresources get it, through the
+    // resource's device, and from the cache.
+    constexpr uint32_t lookups = 100000;
+    std::chrono::high_resolution_clock clock;
+    auto start = clock.now();
+    for (uint32_t i = 0; i < lookups; ++i)
+    {
+        D3D12_RESOURCE_DESC desc = texture->GetDesc();
+        ComPtr<ID3D12Device> device;
+        ThrowIfFailed(texture->GetDevice(IID_PPV_ARGS(&device)));
+        device->GetCopyableFootprints(&desc, 0, subresourceCount, 0, layouts.data(), rowCounts.data(), rowSizes.data(), &requiredSize);
+    }
+    double deviceTime = ToMilliseconds(clock.now() - start);
+
+    start = clock.now();
+    for (uint32_t i = 0; i < lookups; ++i)
+    {
+        D3D12_RESOURCE_DESC desc = texture->GetDesc();
+        requiredSize = g_FootprintCache.Get(desc, 0, subresourceCount).TotalBytes;
+    }
+    double cacheTime = ToMilliseconds(clock.now() - start);
+
+    FootprintCacheStatistics footprintStatistics = g_FootprintCache.GetStatistics();
+    sprintf_s(buffer, 500, "Footprints of %u subresources: device %.3f us, cached %.3f us (%zu entries, %llu hits, %llu misses)\n",
+              subresourceCount, deviceTime * 1000 / lookups, cacheTime * 1000 / lookups, footprintStatistics.Entries,
+              static_cast<unsigned long long>(footprintStatistics.Hits), static_cast<unsigned long long>(footprintStatistics.Misses));
+    std::cout << buffer;
+
+    uploadBuffer->Unmap(0, nullptr);
 }
 
+#if defined(_WIN32)
 void SetFullScreen(bool fullScreen)
 {
     if(g_FullScreen == fullScreen)
@@ -529,9 +1342,9 @@ void SetFullScreen(bool fullScreen)
             monitorInfo.rcMonitor.top,
             monitorInfo.rcMonitor.right - monitorInfo.rcMonitor.left,
             monitorInfo.rcMonitor.bottom - monitorInfo.rcMonitor.top,
-            SWP_FRAMECHANGED | SWP_NOACTIVATE);
+            SWP_FRAMECHANGED | SWP_NOACTIVATE | SWP_ASYNCWINDOWPOS);
 
-        ::ShowWindow(g_hWnd, SW_MAXIMIZE);
+        ::ShowWindowAsync(g_hWnd, SW_MAXIMIZE);
 
         return;
     }
@@ -545,11 +1358,99 @@ void SetFullScreen(bool fullScreen)
         g_WindowRect.top,
         g_WindowRect.right - g_WindowRect.left,
         g_WindowRect.bottom - g_WindowRect.top,
-        SWP_FRAMECHANGED | SWP_NOACTIVATE);
+        SWP_FRAMECHANGED | SWP_NOACTIVATE | SWP_ASYNCWINDOWPOS);
+
+    ::ShowWindowAsync(g_hWnd, SW_NORMAL);
+}
+#endif
+
+void PostRenderCommand(RenderCommandType type, uint32_t width = 0, uint32_t height = 0)
+{
+    if(!g_RenderCommands.TryPush({type, width, height}))
+    {
+        std::cout << "Render command queue is full, dropping command\n";
+    }
+}
+
+void ProcessRenderCommands()
+{
+    bool resize = false;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    RenderCommand command;
+    while (g_RenderCommands.TryPop(command))
+    {
+        switch (command.Type)
+        {
+        case RenderCommandType::Resize:
+            // Only the last size of a burst matters, and each resize flushes the GPU.
+            resize = true;
+            width = command.Width;
+            height = command.Height;
+            break;
+        case RenderCommandType::ToggleFullScreen:
+#if defined(_WIN32)
+            SetFullScreen(!g_FullScreen);
+#endif
+            break;
+        case RenderCommandType::ToggleVsync:
+            g_Vsync = !g_Vsync;
+            break;
+        }
+    }
+
+    if(resize)
+    {
+        Resize(width, height);
+    }
+}
+
+void RenderLoop()
+{
+    while (!g_QuitRequested)
+    {
+        ProcessRenderCommands();
+
+        WaitForNextFrame();
+        Update();
+        Render();
+
+        if(AdvanceBenchmark())
+        {
+            g_QuitRequested = true;
+#if defined(_WIN32)
+            ::PostMessageW(g_hWnd, WM_CLOSE, 0, 0);
+#endif
+        }
+    }
+}
+
+void StopRenderThread()
+{
+    if(!g_RenderThread.joinable())
+    {
+        return;
+    }
+
+    g_QuitRequested = true;
 
-    ::ShowWindow(g_hWnd, SW_NORMAL);
+#if defined(_WIN32)
+    // SetFullScreen on the render thread can still send style messages to this thread, so keep
+    // dispatching sent messages until it has exited.
+    HANDLE renderThread = g_RenderThread.native_handle();
+    while (::MsgWaitForMultipleObjects(1, &renderThread, FALSE, INFINITE, QS_SENDMESSAGE) == WAIT_OBJECT_0 + 1)
+    {
+        MSG msg;
+        ::PeekMessage(&msg, NULL, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+    }
+#endif
+
+    g_RenderThread.join();
 }
 
+#if defined(_WIN32)
+
 LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
     if(!g_IsInitialized)
@@ -560,32 +1461,29 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     switch(message)
     {
     case WM_PAINT:
-        {
-            Update();
-            Render();
-            break;
-        }
+        ::ValidateRect(hWnd, nullptr);
+        break;
     case WM_SYSKEYDOWN:
     case WM_KEYDOWN:
         {
             bool alt = (::GetAsyncKeyState(VK_MENU) & 0x8000) != 0;
 
-            switch (lParam)
+            switch (wParam)
             {
             case 'V':
-                g_Vsync = !g_Vsync;
+                PostRenderCommand(RenderCommandType::ToggleVsync);
                 break;
             case VK_ESCAPE:
-                ::PostQuitMessage(0);
+                ::PostMessageW(hWnd, WM_CLOSE, 0, 0);
                 break;
             case VK_RETURN:
                 if (alt)
                 {
-                    SetFullScreen(!g_FullScreen);
+                    PostRenderCommand(RenderCommandType::ToggleFullScreen);
                 }
                 break;
             case VK_F11:
-                SetFullScreen(!g_FullScreen);
+                PostRenderCommand(RenderCommandType::ToggleFullScreen);
                 break;
             default:
                 break;
@@ -602,9 +1500,14 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             int width = clientRect.right - clientRect.left;
             int height = clientRect.bottom - clientRect.top;
 
-            Resize(width, height);
+            PostRenderCommand(RenderCommandType::Resize, width, height);
             break;
         }
+    case WM_CLOSE:
+        // The swap chain must stop presenting before its window goes away.
+        StopRenderThread();
+        ::DestroyWindow(hWnd);
+        break;
     case WM_DESTROY:
         ::PostQuitMessage(0);
         break;
@@ -633,48 +1536,180 @@ int CALLBACK wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR lpCmdL
 
     ComPtr<IDXGIAdapter4> adapter = GetAdapter(g_UseWarp);
 
-    g_Device = CreateDevice(adapter);
+    InitializeD3D12(g_hWnd, CreateDevice(adapter));
 
-    g_CommandQueue = CreateCommandQueue(g_Device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+    if(g_RecordBenchmark)
+    {
+        RunRecordBenchmark();
+        ::CloseHandle(g_FenceEvent);
+        return 0;
+    }
+
+    if(g_AllocationBenchmark)
+    {
+        RunAllocationBenchmark();
+        ::CloseHandle(g_FenceEvent);
+        return 0;
+    }
 
-    g_SwapChain = CreateSwapChain(g_hWnd, g_CommandQueue, g_ClientWidth, g_ClientHeight, g_NumFrames);
+    if(g_CopyBenchmark)
+    {
+        RunCopyBenchmark();
+        ::CloseHandle(g_FenceEvent);
+        return 0;
+    }
 
-    g_CurrentBackBufferIndex = g_SwapChain->GetCurrentBackBufferIndex();
+    if(g_RunTests)
+    {
+        int failed = RunTests(g_Device.Get());
+        ::CloseHandle(g_FenceEvent);
+        return failed > 0 ? 1 : 0;
+    }
 
-    g_RTVDescriptorHeap = CreateDescriptorHeap(g_Device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, g_NumFrames);
-    g_RTVDescriptorSize = g_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    g_IsInitialized = true;
+
+    g_RenderThread = std::thread(RenderLoop);
 
-    UpdateRenderTargetViews(g_Device, g_SwapChain, g_RTVDescriptorHeap);
+    ::ShowWindow(g_hWnd, SW_SHOW);
 
-    for (int i = 0; i < g_NumFrames; ++i)
+    MSG msg = {};
+    while (::GetMessage(&msg, NULL, 0, 0) > 0)
     {
-        g_CommandAllocators[i] = CreateCommandAllocator(g_Device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+        ::TranslateMessage(&msg);
+        ::DispatchMessage(&msg);
     }
 
-    g_CommandList = CreateCommandList(g_Device, g_CommandAllocators[g_CurrentBackBufferIndex],
-                                      D3D12_COMMAND_LIST_TYPE_DIRECT);
+    StopRenderThread();
 
-    g_Fence = CreateFence(g_Device);
-    g_FenceEvent = CreateEventHandle();
+    Flush(g_CommandQueue, g_Fence, g_FenceValue, g_FenceEvent);
+    g_FenceWaiter->Drain();
+    FinishCapture();
+    FinishPipelineCache();
+    g_FenceWaiter.reset();
 
-    g_IsInitialized = true;
+    ::CloseHandle(g_FenceEvent);
+    if(g_FrameLatencyWaitable)
+    {
+        ::CloseHandle(g_FrameLatencyWaitable);
+    }
 
-    ::ShowWindow(g_hWnd, SW_SHOW);
+    return FinishBenchmark();
+}
+#else
+void RequestQuit(int)
+{
+    g_QuitRequested = true;
+}
 
-    MSG msg = {};
-    while (msg.message != WM_QUIT)
+int main(int argc, char** argv)
+{
+    SetCommandLineArguments(argc, argv);
+    ParseCommandLineArguments();
+
+    g_TearingSupported = CheckTearingSupport();
+
+    InitializeD3D12(g_hWnd, CreateDevice());
+
+    if(g_RecordBenchmark)
     {
-        if (::PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
-        {
-            ::TranslateMessage(&msg);
-            ::DispatchMessage(&msg);
-        }
+        RunRecordBenchmark();
+        ::CloseHandle(g_FenceEvent);
+        return 0;
     }
 
+    if(g_AllocationBenchmark)
+    {
+        RunAllocationBenchmark();
+        ::CloseHandle(g_FenceEvent);
+        return 0;
+    }
+
+    if(g_CopyBenchmark)
+    {
+        RunCopyBenchmark();
+        ::CloseHandle(g_FenceEvent);
+        return 0;
+    }
+
+    if(g_RunTests)
+    {
+        int failed = RunTests(g_Device.Get());
+        ::CloseHandle(g_FenceEvent);
+        return failed > 0 ? 1 : 0;
+    }
+
+    g_IsInitialized = true;
+
+    std::signal(SIGINT, RequestQuit);
+    std::signal(SIGTERM, RequestQuit);
+
+    g_RenderThread = std::thread(RenderLoop);
+    g_RenderThread.join();
+
     Flush(g_CommandQueue, g_Fence, g_FenceValue, g_FenceEvent);
+    g_FenceWaiter->Drain();
+    FinishCapture();
+    FinishPipelineCache();
+    g_FenceWaiter.reset();
 
     ::CloseHandle(g_FenceEvent);
+    if(g_FrameLatencyWaitable)
+    {
+        ::CloseHandle(g_FrameLatencyWaitable);
+    }
 
-    return 0;
+    NullDeviceStatistics statistics = GetNullDeviceStatistics(g_Device);
+    std::cout << "Command lists: " << statistics.CommandListsExecuted
+              << ", commands: " << statistics.CommandsExecuted
+              << ", barriers: " << statistics.BarriersExecuted
+              << ", presents: " << statistics.Presents << std::endl;
+
+    CommandAllocatorPoolStatistics allocatorStatistics = g_CommandAllocatorPool->GetStatistics();
+    std::cout << "Command allocators: " << allocatorStatistics.Allocators
+              << " (" << allocatorStatistics.Available << " available)"
+              << ", hits: " << allocatorStatistics.Hits
+              << ", misses: " << allocatorStatistics.Misses << std::endl;
+
+    DescriptorAllocatorStatistics descriptorStatistics = g_DescriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_RTV]->GetStatistics();
+    std::cout << "RTV descriptors: " << descriptorStatistics.Requested
+              << " of " << descriptorStatistics.Capacity
+              << ", pages: " << descriptorStatistics.Pages << std::endl;
+
+    BindlessHeapStatistics bindlessStatistics = g_BindlessHeap->GetStatistics();
+    std::cout << "Bindless descriptors: " << bindlessStatistics.Registered
+              << " of " << bindlessStatistics.Capacity
+              << ", retiring: " << bindlessStatistics.Retiring << std::endl;
+
+    ResourceAllocatorStatistics allocatorMemoryStatistics = g_ResourceAllocator->GetStatistics();
+    std::cout << "Placed resources: " << allocatorMemoryStatistics.Allocations
+              << " in " << allocatorMemoryStatistics.Heaps << " heaps"
+              << ", fragmentation: " << allocatorMemoryStatistics.Fragmentation << std::endl;
+
+    UploadRingStatistics uploadStatistics = g_UploadRing->GetStatistics();
+    std::cout << "Upload ring: " << uploadStatistics.Size
+              << " bytes, peak used: " << uploadStatistics.PeakUsed << std::endl;
+
+    ReadbackRingStatistics readbackStatistics = g_ReadbackRing->GetStatistics();
+    std::cout << "Readbacks: " << readbackStatistics.Completed
+              << ", dropped: " << readbackStatistics.Dropped
+              << ", slots: " << readbackStatistics.Slots << std::endl;
+
+    ReleaseQueueStatistics releaseStatistics = g_ReleaseQueue->GetStatistics();
+    std::cout << "Deferred releases: " << releaseStatistics.Released
+              << ", pending: " << releaseStatistics.Pending
+              << " in " << releaseStatistics.Batches << " batches"
+              << ", peak pending: " << releaseStatistics.PeakPending << std::endl;
+
+    RenderGraphStatistics graphStatistics = g_RenderGraph->GetStatistics();
+    std::cout << "Render graph: " << graphStatistics.Passes
+              << " passes, culled: " << graphStatistics.CulledPasses
+              << ", transitions: " << graphStatistics.Transitions
+              << ", transient memory: " << graphStatistics.TransientMemory
+              << " bytes (" << graphStatistics.TransientMemorySaved << " saved by aliasing)"
+              << ", compiles: " << graphStatistics.Compiles
+              << ", reuses: " << graphStatistics.Reuses << std::endl;
+
+    return FinishBenchmark();
 }
+#endif
 
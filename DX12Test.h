@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#if defined(_WIN32)
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3dcompiler.lib")
@@ -21,18 +22,53 @@
 #endif
 
 #include <wrl.h>
+#else
+#include "NullPlatform.h"
+#endif
 using namespace Microsoft::WRL;
 
 #include <iostream>
 
 #include "directXHeaders/directx/d3dx12.h"
+#if defined(_WIN32)
 #include <d3d12.h>
 #include <dxgi1_6.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
+#else
+#include "NullDevice.h"
+#include <csignal>
+#endif
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
+#include "Benchmark.h"
+#include "BindlessHeap.h"
+#include "CommandAllocatorPool.h"
+#include "DescriptorAllocator.h"
+#include "EventQueue.h"
+#include "FenceWaiter.h"
+#include "FootprintCache.h"
+#include "FrameCapture.h"
+#include "FrameContext.h"
+#include "ParallelRecorder.h"
+#include "PipelineCache.h"
+#include "PipelineCompiler.h"
+#include "ReadbackRing.h"
+#include "ReleaseQueue.h"
+#include "RenderGraph.h"
+#include "ResourceAllocator.h"
+#include "ResourceStateTracker.h"
+#include "Scene.h"
+#include "SubresourceCopy.h"
+#include "Tests.h"
+#include "UploadRing.h"
 #include "Helpers.h"
\ No newline at end of file
@@ -0,0 +1,282 @@
+#include "DescriptorAllocator.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <algorithm>
+
+namespace
+{
+    // Descriptors moved between a thread's cache and the shared free lists at a time, so larger blocks
+    // move in smaller batches and a cache holds about as many descriptors in each size class.
+    constexpr size_t g_CacheBatchDescriptors = 32;
+
+    std::atomic<uint64_t> g_NextAllocatorId(0);
+
+    uint32_t GetSizeClass(uint32_t count)
+    {
+        uint32_t sizeClass = 0;
+        while ((1u << sizeClass) < count)
+        {
+            ++sizeClass;
+        }
+
+        return sizeClass;
+    }
+
+    size_t GetCacheBatchSize(uint32_t sizeClass)
+    {
+        return std::max<size_t>(1, g_CacheBatchDescriptors >> sizeClass);
+    }
+}
+
+DescriptorAllocator::DescriptorAllocator(
+    const Microsoft::WRL::ComPtr<ID3D12Device2>& device,
+    D3D12_DESCRIPTOR_HEAP_TYPE type,
+    uint32_t descriptorsPerPage)
+    : m_Device(device)
+    , m_Type(type)
+    , m_DescriptorSize(device->GetDescriptorHandleIncrementSize(type))
+    // The largest size class is a whole page.
+    , m_DescriptorsPerPage(1u << GetSizeClass(std::max(1u, descriptorsPerPage)))
+    , m_ClassCount(GetSizeClass(m_DescriptorsPerPage) + 1)
+    , m_PageUsed(m_DescriptorsPerPage)
+    , m_FreeBlocks(m_ClassCount)
+    , m_Id(g_NextAllocatorId++)
+    , m_Requested(0)
+    , m_Allocated(0)
+{
+}
+
+DescriptorAllocation DescriptorAllocator::Allocate(uint32_t count)
+{
+    if(count == 0 || count > m_DescriptorsPerPage)
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+
+    uint32_t sizeClass = GetSizeClass(count);
+    Block block;
+
+    if(sizeClass < CachedClassCount)
+    {
+        Cache& cache = GetThreadCache();
+        std::lock_guard<std::mutex> lock(cache.Mutex);
+
+        std::vector<Block>& cached = cache.Blocks[sizeClass];
+        if(cached.empty())
+        {
+            TakeBlocks(sizeClass, cached, GetCacheBatchSize(sizeClass));
+        }
+
+        block = cached.back();
+        cached.pop_back();
+    }
+    else
+    {
+        std::vector<Block> blocks;
+        TakeBlocks(sizeClass, blocks, 1);
+        block = blocks.back();
+    }
+
+    m_Requested += count;
+    m_Allocated += 1ull << sizeClass;
+
+    DescriptorAllocation allocation;
+    allocation.Handle = block;
+    allocation.Count = count;
+    allocation.DescriptorSize = m_DescriptorSize;
+
+    return allocation;
+}
+
+void DescriptorAllocator::Free(const DescriptorAllocation& allocation)
+{
+    uint32_t sizeClass = GetSizeClass(allocation.Count);
+
+    m_Requested -= allocation.Count;
+    m_Allocated -= 1ull << sizeClass;
+
+    if(sizeClass < CachedClassCount)
+    {
+        Cache& cache = GetThreadCache();
+        std::lock_guard<std::mutex> lock(cache.Mutex);
+
+        // Past two batches, give one back so an idle cache doesn't hoard blocks other threads need.
+        std::vector<Block>& cached = cache.Blocks[sizeClass];
+        cached.push_back(allocation.Handle);
+        size_t batchSize = GetCacheBatchSize(sizeClass);
+        if(cached.size() > 2 * batchSize)
+        {
+            ReturnBlocks(sizeClass, cached, batchSize);
+        }
+    }
+    else
+    {
+        std::vector<Block> blocks(1, allocation.Handle);
+        ReturnBlocks(sizeClass, blocks, 1);
+    }
+}
+
+DescriptorAllocatorStatistics DescriptorAllocator::GetStatistics() const
+{
+    DescriptorAllocatorStatistics statistics = {};
+
+    // Allocate takes m_Mutex under a cache's lock, so the caches are read without m_Mutex held.
+    std::vector<std::shared_ptr<Cache>> caches;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        caches = m_Caches;
+    }
+
+    for (const std::shared_ptr<Cache>& cache : caches)
+    {
+        std::lock_guard<std::mutex> lock(cache->Mutex);
+        for (uint32_t i = 0; i < CachedClassCount; ++i)
+        {
+            statistics.Free += cache->Blocks[i].size() << i;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        statistics.Pages = static_cast<uint32_t>(m_Pages.size());
+        statistics.Capacity = static_cast<uint64_t>(m_Pages.size()) * m_DescriptorsPerPage;
+        for (uint32_t i = 0; i < m_ClassCount; ++i)
+        {
+            statistics.Free += m_FreeBlocks[i].size() << i;
+        }
+    }
+
+    statistics.Requested = m_Requested;
+    statistics.Allocated = m_Allocated;
+
+    if(statistics.Capacity > 0)
+    {
+        statistics.Occupancy = static_cast<double>(statistics.Requested) / statistics.Capacity;
+    }
+    if(statistics.Capacity > statistics.Allocated)
+    {
+        statistics.Fragmentation = static_cast<double>(statistics.Free) / (statistics.Capacity - statistics.Allocated);
+    }
+
+    return statistics;
+}
+
+DescriptorAllocator::Cache& DescriptorAllocator::GetThreadCache()
+{
+    // The caches the calling thread owns, by allocator id, handed back when the thread exits.
+    struct ThreadCaches
+    {
+        ~ThreadCaches()
+        {
+            for (auto& entry : Entries)
+            {
+                entry.second->Owned = false;
+            }
+        }
+
+        std::vector<std::pair<uint64_t, std::shared_ptr<Cache>>> Entries;
+    };
+    thread_local ThreadCaches threadCaches;
+
+    for (auto& entry : threadCaches.Entries)
+    {
+        if(entry.first == m_Id)
+        {
+            return *entry.second;
+        }
+    }
+
+    std::shared_ptr<Cache> cache;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        for (const std::shared_ptr<Cache>& candidate : m_Caches)
+        {
+            if(!candidate->Owned.exchange(true))
+            {
+                cache = candidate;
+                break;
+            }
+        }
+
+        if(!cache)
+        {
+            cache = std::make_shared<Cache>();
+            m_Caches.push_back(cache);
+        }
+    }
+
+    threadCaches.Entries.emplace_back(m_Id, cache);
+
+    return *cache;
+}
+
+void DescriptorAllocator::TakeBlocks(uint32_t sizeClass, std::vector<Block>& blocks, size_t count)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    std::vector<Block>& freeBlocks = m_FreeBlocks[sizeClass];
+    for (size_t i = 0; i < count; ++i)
+    {
+        if(freeBlocks.empty())
+        {
+            blocks.push_back(CarveBlock(sizeClass));
+        }
+        else
+        {
+            blocks.push_back(freeBlocks.back());
+            freeBlocks.pop_back();
+        }
+    }
+}
+
+void DescriptorAllocator::ReturnBlocks(uint32_t sizeClass, std::vector<Block>& blocks, size_t count)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    std::vector<Block>& freeBlocks = m_FreeBlocks[sizeClass];
+    freeBlocks.insert(freeBlocks.end(), blocks.end() - count, blocks.end());
+    blocks.resize(blocks.size() - count);
+}
+
+DescriptorAllocator::Block DescriptorAllocator::CarveBlock(uint32_t sizeClass)
+{
+    uint32_t size = 1u << sizeClass;
+
+    if(m_PageUsed + size > m_DescriptorsPerPage)
+    {
+        // Hand what is left of the page to the smaller size classes rather than lose it.
+        if(!m_Pages.empty())
+        {
+            CD3DX12_CPU_DESCRIPTOR_HANDLE remainder(m_Pages.back()->GetCPUDescriptorHandleForHeapStart(), m_PageUsed, m_DescriptorSize);
+            for (uint32_t i = sizeClass; i-- > 0;)
+            {
+                if(m_PageUsed + (1u << i) <= m_DescriptorsPerPage)
+                {
+                    m_FreeBlocks[i].push_back(remainder);
+                    remainder.Offset(1 << i, m_DescriptorSize);
+                    m_PageUsed += 1u << i;
+                }
+            }
+        }
+
+        D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+        desc.Type = m_Type;
+        desc.NumDescriptors = m_DescriptorsPerPage;
+
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap;
+        ThrowIfFailed(m_Device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap)));
+
+        m_Pages.push_back(heap);
+        m_PageUsed = 0;
+    }
+
+    Block block = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_Pages.back()->GetCPUDescriptorHandleForHeapStart(), m_PageUsed, m_DescriptorSize);
+    m_PageUsed += size;
+
+    return block;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// A contiguous range of CPU descriptors from a DescriptorAllocator.
+struct DescriptorAllocation
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE Handle;
+    uint32_t Count;
+    uint32_t DescriptorSize;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetHandle(uint32_t index = 0) const
+    {
+        return CD3DX12_CPU_DESCRIPTOR_HANDLE(Handle, index, DescriptorSize);
+    }
+};
+
+struct DescriptorAllocatorStatistics
+{
+    uint32_t Pages;
+    // Descriptors in all pages, asked for by live allocations, and taken by them once rounded up to
+    // their size class.
+    uint64_t Capacity;
+    uint64_t Requested;
+    uint64_t Allocated;
+    // Descriptors on free lists, which only serve allocations of their own size class.
+    uint64_t Free;
+    // Requested / Capacity, and the share of unallocated space that is held on free lists.
+    double Occupancy;
+    double Fragmentation;
+};
+
+// Hands out ranges of non-shader-visible descriptors of one heap type. Requests are rounded up to a
+// power of two and served from that size class's free list, so Allocate and Free are O(1); pages of
+// descriptorsPerPage descriptors are added as needed. Small ranges go through a cache owned by the
+// calling thread, so threads creating views at the same time don't contend; a thread that exits leaves
+// its cache, blocks and all, to the next thread that starts using the allocator.
+class DescriptorAllocator
+{
+public:
+    DescriptorAllocator(
+        const Microsoft::WRL::ComPtr<ID3D12Device2>& device,
+        D3D12_DESCRIPTOR_HEAP_TYPE type,
+        uint32_t descriptorsPerPage = 256);
+
+    DescriptorAllocator(const DescriptorAllocator&) = delete;
+    DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+    // Throws E_INVALIDARG for zero descriptors or more than a page holds.
+    DescriptorAllocation Allocate(uint32_t count = 1);
+
+    void Free(const DescriptorAllocation& allocation);
+
+    DescriptorAllocatorStatistics GetStatistics() const;
+
+private:
+    // A free range is just its first descriptor; its length is implied by the list it is on.
+    typedef D3D12_CPU_DESCRIPTOR_HANDLE Block;
+
+    static constexpr uint32_t CachedClassCount = 4;
+
+    // Only its owning thread allocates and frees through a cache, so its lock is only ever contended
+    // by GetStatistics.
+    struct alignas(64) Cache
+    {
+        mutable std::mutex Mutex;
+        std::vector<Block> Blocks[CachedClassCount];
+        // Cleared when the owning thread exits.
+        std::atomic<bool> Owned{true};
+    };
+
+    // Returns the calling thread's cache, adopting an unowned one or adding one the first time.
+    Cache& GetThreadCache();
+
+    // Both take m_Mutex.
+    void TakeBlocks(uint32_t sizeClass, std::vector<Block>& blocks, size_t count);
+    void ReturnBlocks(uint32_t sizeClass, std::vector<Block>& blocks, size_t count);
+
+    // Call with m_Mutex held.
+    Block CarveBlock(uint32_t sizeClass);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    D3D12_DESCRIPTOR_HEAP_TYPE m_Type;
+    uint32_t m_DescriptorSize;
+    uint32_t m_DescriptorsPerPage;
+    uint32_t m_ClassCount;
+
+    mutable std::mutex m_Mutex;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> m_Pages;
+    // Descriptors of the newest page that no block has been carved from yet.
+    uint32_t m_PageUsed;
+    std::vector<std::vector<Block>> m_FreeBlocks;
+    // Identifies this allocator to the threads' cache lookups; never reused.
+    uint64_t m_Id;
+    std::vector<std::shared_ptr<Cache>> m_Caches;
+
+    std::atomic<uint64_t> m_Requested;
+    std::atomic<uint64_t> m_Allocated;
+};
@@ -0,0 +1,97 @@
+#include "DescriptorAllocator.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
+TEST(DescriptorAllocatorGivesThreadsDisjointRanges)
+{
+    DescriptorAllocator allocator(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 64);
+    uint32_t descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    const uint32_t threadCount = 4;
+    std::vector<std::vector<DescriptorAllocation>> allocations(threadCount);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            // Sizes from every cached size class and a few past them.
+            for (uint32_t i = 0; i < 200; ++i)
+            {
+                allocations[t].push_back(allocator.Allocate(1 + (i * 7 + t) % 24));
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::vector<std::pair<SIZE_T, SIZE_T>> ranges;
+    for (const std::vector<DescriptorAllocation>& threadAllocations : allocations)
+    {
+        for (const DescriptorAllocation& allocation : threadAllocations)
+        {
+            ranges.emplace_back(allocation.Handle.ptr, allocation.Handle.ptr + allocation.Count * descriptorSize);
+        }
+    }
+    std::sort(ranges.begin(), ranges.end());
+
+    bool disjoint = true;
+    for (size_t i = 1; i < ranges.size(); ++i)
+    {
+        disjoint = disjoint && ranges[i - 1].second <= ranges[i].first;
+    }
+    CHECK(disjoint);
+
+    // Freed on other threads than the ones that allocated them.
+    threads.clear();
+    for (uint32_t t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (const DescriptorAllocation& allocation : allocations[(t + 1) % threadCount])
+            {
+                allocator.Free(allocation);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    DescriptorAllocatorStatistics statistics = allocator.GetStatistics();
+    CHECK(statistics.Requested == 0);
+    CHECK(statistics.Allocated == 0);
+}
+
+TEST(DescriptorAllocatorAdoptsCachesOfExitedThreads)
+{
+    DescriptorAllocator allocator(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    std::thread([&]()
+    {
+        allocator.Free(allocator.Allocate());
+    }).join();
+
+    // The exited thread's cache still holds a batch of single descriptors.
+    uint64_t free = allocator.GetStatistics().Free;
+    CHECK(free > 1);
+
+    DescriptorAllocation allocation;
+    std::thread([&]()
+    {
+        allocation = allocator.Allocate();
+    }).join();
+
+    // Served from the adopted cache rather than a fresh batch carved from the page.
+    DescriptorAllocatorStatistics statistics = allocator.GetStatistics();
+    CHECK(statistics.Free == free - 1);
+    CHECK(statistics.Pages == 1);
+
+    allocator.Free(allocation);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded single-producer, single-consumer ring buffer. Neither side ever blocks or takes a lock:
+// TryPush fails when the ring is full and TryPop when it is empty.
+template<typename T, size_t Capacity>
+class EventQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool TryPush(const T& item)
+    {
+        size_t tail = m_Tail.load(std::memory_order_relaxed);
+        if(tail - m_Head.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+
+        m_Items[tail & (Capacity - 1)] = item;
+        m_Tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool TryPop(T& item)
+    {
+        size_t head = m_Head.load(std::memory_order_relaxed);
+        if(head == m_Tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        item = m_Items[head & (Capacity - 1)];
+        m_Head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+private:
+    // Head and tail live on separate cache lines so the two threads don't contend on every push and pop.
+    alignas(64) std::atomic<size_t> m_Head{0};
+    alignas(64) std::atomic<size_t> m_Tail{0};
+    std::array<T, Capacity> m_Items;
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+template<typename... TInterfaces>
+using FakeComObject = Microsoft::WRL::RuntimeClass<Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::ClassicCom>, TInterfaces...>;
+#else
+template<typename... TInterfaces>
+using FakeComObject = Microsoft::WRL::Base<TInterfaces...>;
+#endif
+
+// For tests: a fence only the test completes, to any value and in any order across fences. Like the
+// kernel, it keeps its own reference on armed events, so a waiter may close its event while one is armed.
+class FakeFence : public FakeComObject<Microsoft::WRL::ChainInterfaces<ID3D12Fence, ID3D12Pageable, ID3D12DeviceChild, ID3D12Object>>
+{
+public:
+    ~FakeFence()
+    {
+        for (const auto& event : m_Events)
+        {
+            ::CloseHandle(event.second);
+        }
+    }
+
+    void Complete(UINT64 value)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_CompletedValue = value;
+
+        for (auto it = m_Events.begin(); it != m_Events.end();)
+        {
+            if(it->first <= value)
+            {
+                ::SetEvent(it->second);
+                ::CloseHandle(it->second);
+                it = m_Events.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    size_t GetArmedCount()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        return m_Events.size();
+    }
+
+    UINT64 STDMETHODCALLTYPE GetCompletedValue() override
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        return m_CompletedValue;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetEventOnCompletion(UINT64 Value, HANDLE hEvent) override
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if(Value <= m_CompletedValue)
+        {
+            ::SetEvent(hEvent);
+            return S_OK;
+        }
+
+        HANDLE event;
+        if(!::DuplicateHandle(::GetCurrentProcess(), hEvent, ::GetCurrentProcess(), &event, 0, FALSE, DUPLICATE_SAME_ACCESS))
+        {
+            return E_FAIL;
+        }
+        m_Events.emplace_back(Value, event);
+
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE Signal(UINT64 Value) override
+    {
+        Complete(Value);
+
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData) override
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT DataSize, const void* pData) override
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* pData) override
+    {
+        return E_NOTIMPL;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetName(LPCWSTR Name) override
+    {
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void** ppvDevice) override
+    {
+        return E_NOTIMPL;
+    }
+
+private:
+    std::mutex m_Mutex;
+    UINT64 m_CompletedValue = 0;
+    std::vector<std::pair<UINT64, HANDLE>> m_Events;
+};
@@ -0,0 +1,99 @@
+#include "FenceWaiter.h"
+
+#include <algorithm>
+#include <iterator>
+
+FenceWaiter::FenceWaiter()
+    : m_Event(::CreateEvent(NULL, FALSE, FALSE, NULL))
+    , m_Running(0)
+    , m_Stop(false)
+{
+    m_Thread = std::thread(&FenceWaiter::Run, this);
+}
+
+FenceWaiter::~FenceWaiter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    ::SetEvent(m_Event);
+    m_Thread.join();
+
+    // Callbacks still pending are dropped without running.
+    m_Registrations.clear();
+    ::CloseHandle(m_Event);
+}
+
+void FenceWaiter::Enqueue(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t value, std::function<void()> callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Registrations.push_back({fence, value, std::move(callback), false});
+    }
+    ::SetEvent(m_Event);
+}
+
+size_t FenceWaiter::GetPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return m_Registrations.size();
+}
+
+void FenceWaiter::Drain()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Idle.wait(lock, [this] { return m_Registrations.empty() && m_Running == 0; });
+}
+
+void FenceWaiter::Run()
+{
+    std::vector<Registration> completed;
+
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if(m_Stop)
+            {
+                return;
+            }
+
+            // Every wake-up rescans all registrations, so one auto-reset event can stand in for any
+            // number of fences even when several complete between two waits.
+            auto firstCompleted = std::partition(m_Registrations.begin(), m_Registrations.end(),
+                [](const Registration& registration) { return registration.Fence->GetCompletedValue() < registration.Value; });
+            std::move(firstCompleted, m_Registrations.end(), std::back_inserter(completed));
+            m_Registrations.erase(firstCompleted, m_Registrations.end());
+
+            for (Registration& registration : m_Registrations)
+            {
+                if(!registration.Armed)
+                {
+                    ThrowIfFailed(registration.Fence->SetEventOnCompletion(registration.Value, m_Event));
+                    registration.Armed = true;
+                }
+            }
+
+            m_Running = completed.size();
+        }
+
+        for (Registration& registration : completed)
+        {
+            registration.Callback();
+        }
+        completed.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Running = 0;
+            if(m_Registrations.empty())
+            {
+                m_Idle.notify_all();
+            }
+        }
+
+        ::WaitForSingleObject(m_Event, INFINITE);
+    }
+}
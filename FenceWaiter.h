@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs callbacks once fences reach given values, so callers can queue work behind the GPU instead of
+// blocking on it. One thread and one event serve every registration. Callbacks run on that thread,
+// in no particular order relative to each other, and must not call back into the waiter's destructor.
+//
+// The waiter only uses GetCompletedValue and SetEventOnCompletion, so a fence from CreateNullDevice
+// that is signaled from the CPU works as a fake for testing.
+class FenceWaiter
+{
+public:
+    FenceWaiter();
+    ~FenceWaiter();
+
+    FenceWaiter(const FenceWaiter&) = delete;
+    FenceWaiter& operator=(const FenceWaiter&) = delete;
+
+    void Enqueue(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t value, std::function<void()> callback);
+
+    // Registrations whose callbacks have not started yet.
+    size_t GetPendingCount() const;
+
+    // Blocks until every callback registered so far has run.
+    void Drain();
+
+private:
+    struct Registration
+    {
+        Microsoft::WRL::ComPtr<ID3D12Fence> Fence;
+        uint64_t Value;
+        std::function<void()> Callback;
+        bool Armed;
+    };
+
+    void Run();
+
+    HANDLE m_Event;
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Idle;
+    std::vector<Registration> m_Registrations;
+    size_t m_Running;
+    bool m_Stop;
+    std::thread m_Thread;
+};
@@ -0,0 +1,152 @@
+#include "FakeFence.h"
+#include "FenceWaiter.h"
+#include "Tests.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Callbacks run on the waiter's thread, so the test polls for them, but gives up eventually.
+    template<typename Condition>
+    bool WaitFor(Condition condition)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!condition())
+        {
+            if(std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+
+    // Returns once the waiter has scanned its registrations after everything the test did so far and
+    // run all that scan found, to show that nothing else is about to run. A callback on a completed fence
+    // runs in the batch of the first such scan, and one it enqueues only in a batch after that one.
+    bool Settle(FenceWaiter& waiter)
+    {
+        auto fence = Microsoft::WRL::Make<FakeFence>();
+        auto settled = std::make_shared<std::atomic<bool>>(false);
+        waiter.Enqueue(fence, 0, [&waiter, fence, settled]
+        {
+            waiter.Enqueue(fence, 0, [settled] { *settled = true; });
+        });
+
+        return WaitFor([&] { return settled->load(); });
+    }
+}
+
+TEST(FenceWaiterRunsCallbacksInCompletionOrder)
+{
+    auto first = Microsoft::WRL::Make<FakeFence>();
+    auto second = Microsoft::WRL::Make<FakeFence>();
+    FenceWaiter waiter;
+
+    std::mutex mutex;
+    std::vector<int> order;
+    bool tooEarly = false;
+    auto record = [&](const Microsoft::WRL::ComPtr<FakeFence>& fence, uint64_t value, int id)
+    {
+        waiter.Enqueue(fence, value, [&, fence, value, id]
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tooEarly |= fence->GetCompletedValue() < value;
+            order.push_back(id);
+        });
+    };
+    auto count = [&]
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return order.size();
+    };
+
+    // Registered out of value order, and the later fence completes first.
+    record(first, 3, 3);
+    record(first, 1, 1);
+    record(second, 10, 10);
+    record(first, 2, 2);
+    record(second, 20, 20);
+
+    CHECK(WaitFor([&] { return first->GetArmedCount() + second->GetArmedCount() == 5; }));
+    CHECK(count() == 0);
+
+    second->Complete(10);
+    CHECK(WaitFor([&] { return count() == 1; }));
+
+    // Skips a value, as a queue that signals rarely would.
+    first->Complete(2);
+    CHECK(WaitFor([&] { return count() == 3; }));
+    CHECK(Settle(waiter));
+    CHECK(count() == 3);
+    CHECK(waiter.GetPendingCount() == 2);
+
+    // Past every remaining value at once.
+    second->Complete(25);
+    first->Complete(7);
+    waiter.Drain();
+    CHECK(waiter.GetPendingCount() == 0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK(!tooEarly);
+    if(CHECK(order.size() == 5))
+    {
+        CHECK(order[0] == 10);
+        CHECK((order[1] == 1 && order[2] == 2) || (order[1] == 2 && order[2] == 1));
+    }
+}
+
+TEST(FenceWaiterRunsCompletedRegistrationsImmediately)
+{
+    auto fence = Microsoft::WRL::Make<FakeFence>();
+    fence->Complete(5);
+
+    FenceWaiter waiter;
+    std::atomic<int> calls(0);
+    waiter.Enqueue(fence, 5, [&] { ++calls; });
+    waiter.Enqueue(fence, 1, [&] { ++calls; });
+    waiter.Drain();
+
+    CHECK(calls == 2);
+    CHECK(fence->GetArmedCount() == 0);
+
+    // Each callback runs once, however often the fence moves on afterwards.
+    fence->Complete(6);
+    CHECK(Settle(waiter));
+    CHECK(calls == 2);
+}
+
+TEST(FenceWaiterShutsDownWithWaitsPending)
+{
+    auto fence = Microsoft::WRL::Make<FakeFence>();
+    std::atomic<int> calls(0);
+
+    {
+        FenceWaiter waiter;
+        waiter.Enqueue(fence, 1, [&] { ++calls; });
+        waiter.Enqueue(fence, 100, [&] { ++calls; });
+        waiter.Enqueue(fence, 200, [&] { ++calls; });
+
+        fence->Complete(1);
+        CHECK(WaitFor([&] { return calls == 1; }));
+        CHECK(WaitFor([&] { return fence->GetArmedCount() == 2; }));
+        CHECK(waiter.GetPendingCount() == 2);
+    }
+
+    // The waiter is gone, its thread joined, and with it its event; the fence still holds its own
+    // reference.
+    CHECK(fence->GetArmedCount() == 2);
+    fence->Complete(200);
+    CHECK(calls == 1);
+}
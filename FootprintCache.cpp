@@ -0,0 +1,94 @@
+#include "FootprintCache.h"
+#include "HashHelpers.h"
+
+#include <mutex>
+
+bool FootprintCache::Key::operator==(const Key& other) const
+{
+    return Dimension == other.Dimension &&
+        Width == other.Width &&
+        Height == other.Height &&
+        DepthOrArraySize == other.DepthOrArraySize &&
+        MipLevels == other.MipLevels &&
+        Format == other.Format &&
+        MipRegion.Width == other.MipRegion.Width &&
+        MipRegion.Height == other.MipRegion.Height &&
+        MipRegion.Depth == other.MipRegion.Depth &&
+        FirstSubresource == other.FirstSubresource &&
+        SubresourceCount == other.SubresourceCount;
+}
+
+size_t FootprintCache::KeyHash::operator()(const Key& key) const
+{
+    uint64_t hash = g_FnvOffsetBasis;
+    Hash(hash, key.Dimension);
+    Hash(hash, key.Width);
+    Hash(hash, key.Height);
+    Hash(hash, key.DepthOrArraySize);
+    Hash(hash, key.MipLevels);
+    Hash(hash, key.Format);
+    Hash(hash, key.MipRegion.Width);
+    Hash(hash, key.MipRegion.Height);
+    Hash(hash, key.MipRegion.Depth);
+    Hash(hash, key.FirstSubresource);
+    Hash(hash, key.SubresourceCount);
+
+    return static_cast<size_t>(hash);
+}
+
+FootprintCache::FootprintCache()
+    : m_Hits(0)
+    , m_Misses(0)
+{
+}
+
+const CopyableFootprints& FootprintCache::Get(const D3D12_RESOURCE_DESC1& desc, UINT firstSubresource, UINT subresourceCount)
+{
+    Key key = {desc.Dimension, desc.Width, desc.Height, desc.DepthOrArraySize, desc.MipLevels, desc.Format,
+               desc.SamplerFeedbackMipRegion, firstSubresource, subresourceCount};
+
+    {
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+        auto it = m_Entries.find(key);
+        if(it != m_Entries.end())
+        {
+            m_Hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+    }
+
+    // Computed outside the lock. Threads missing on the same shape at once compute it twice, and
+    // the first to insert wins.
+    CopyableFootprints footprints;
+    footprints.Layouts.resize(subresourceCount);
+    footprints.RowCounts.resize(subresourceCount);
+    footprints.RowSizes.resize(subresourceCount);
+    // A shape the format table can't lay out is the caller's mistake, and isn't cached.
+    if(!D3DX12GetCopyableFootprints(desc, firstSubresource, subresourceCount, 0,
+                                    footprints.Layouts.data(), footprints.RowCounts.data(), footprints.RowSizes.data(), &footprints.TotalBytes))
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+
+    m_Misses.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::shared_mutex> lock(m_Mutex);
+    return m_Entries.emplace(key, std::move(footprints)).first->second;
+}
+
+const CopyableFootprints& FootprintCache::Get(const D3D12_RESOURCE_DESC& desc, UINT firstSubresource, UINT subresourceCount)
+{
+    return Get(D3DX12ResourceDesc0ToDesc1(desc), firstSubresource, subresourceCount);
+}
+
+FootprintCacheStatistics FootprintCache::GetStatistics() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_Mutex);
+
+    FootprintCacheStatistics statistics = {};
+    statistics.Entries = m_Entries.size();
+    statistics.Hits = m_Hits.load(std::memory_order_relaxed);
+    statistics.Misses = m_Misses.load(std::memory_order_relaxed);
+
+    return statistics;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "FormatTable.h"
+
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+// What GetCopyableFootprints returns for a range of subresources. Offsets start at 0; a copy placed
+// elsewhere in its buffer adds its own offset to each.
+struct CopyableFootprints
+{
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts;
+    std::vector<UINT> RowCounts;
+    std::vector<UINT64> RowSizes;
+    UINT64 TotalBytes;
+};
+
+struct FootprintCacheStatistics
+{
+    size_t Entries;
+    uint64_t Hits;
+    uint64_t Misses;
+};
+
+// Copyable footprints computed once per resource shape and subresource range, from the format table
+// rather than a device, and kept for the lifetime of the cache. Only the fields the layout depends on
+// make up the shape, so e.g. textures differing in flags or sample count share an entry. Safe to use
+// from several threads; lookups only take a shared lock.
+class FootprintCache
+{
+public:
+    FootprintCache();
+
+    FootprintCache(const FootprintCache&) = delete;
+    FootprintCache& operator=(const FootprintCache&) = delete;
+
+    // The reference stays valid as long as the cache. desc is as GetDesc returns it, with MipLevels resolved.
+    // Throws for shapes the format table can't lay out.
+    const CopyableFootprints& Get(const D3D12_RESOURCE_DESC1& desc, UINT firstSubresource, UINT subresourceCount);
+    const CopyableFootprints& Get(const D3D12_RESOURCE_DESC& desc, UINT firstSubresource, UINT subresourceCount);
+
+    FootprintCacheStatistics GetStatistics() const;
+
+private:
+    struct Key
+    {
+        D3D12_RESOURCE_DIMENSION Dimension;
+        UINT64 Width;
+        UINT Height;
+        UINT16 DepthOrArraySize;
+        UINT16 MipLevels;
+        DXGI_FORMAT Format;
+        // Sampler feedback formats are laid out by their mip region.
+        D3D12_MIP_REGION MipRegion;
+        UINT FirstSubresource;
+        UINT SubresourceCount;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    mutable std::shared_mutex m_Mutex;
+    std::unordered_map<Key, CopyableFootprints, KeyHash> m_Entries;
+    std::atomic<uint64_t> m_Hits;
+    std::atomic<uint64_t> m_Misses;
+};
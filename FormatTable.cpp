@@ -0,0 +1,68 @@
+#include "FormatTable.h"
+
+// d3dx12 declares its format table without defining it, so D3DX12GetCopyableFootprints would not link.
+// These are the members the d3dx12 helpers call, answered from g_FormatTable. Declared plain static by
+// d3dx12, they can't be constexpr, and they are out of line so users of d3dx12.h don't need this header.
+
+bool D3D12_PROPERTY_LAYOUT_FORMAT_TABLE::FormatExists(DXGI_FORMAT Format)
+{
+    return GetFormatLayout(Format).Exists;
+}
+
+bool D3D12_PROPERTY_LAYOUT_FORMAT_TABLE::IsBlockCompressFormat(DXGI_FORMAT Format)
+{
+    return GetFormatLayout(Format).BlockCompressed;
+}
+
+UINT D3D12_PROPERTY_LAYOUT_FORMAT_TABLE::GetBitsPerUnit(DXGI_FORMAT Format)
+{
+    return GetFormatLayout(Format).BitsPerUnit;
+}
+
+UINT D3D12_PROPERTY_LAYOUT_FORMAT_TABLE::GetWidthAlignment(DXGI_FORMAT Format)
+{
+    return GetFormatLayout(Format).WidthAlignment;
+}
+
+UINT D3D12_PROPERTY_LAYOUT_FORMAT_TABLE::GetHeightAlignment(DXGI_FORMAT Format)
+{
+    return GetFormatLayout(Format).HeightAlignment;
+}
+
+UINT D3D12_PROPERTY_LAYOUT_FORMAT_TABLE::GetDepthAlignment(DXGI_FORMAT Format)
+{
+    return GetFormatLayout(Format).DepthAlignment;
+}
+
+BOOL D3D12_PROPERTY_LAYOUT_FORMAT_TABLE::Planar(DXGI_FORMAT Format)
+{
+    return GetFormatLayout(Format).Planar;
+}
+
+UINT8 D3D12_PROPERTY_LAYOUT_FORMAT_TABLE::GetPlaneCount(DXGI_FORMAT Format)
+{
+    return GetFormatLayout(Format).PlaneCount;
+}
+
+HRESULT D3D12_PROPERTY_LAYOUT_FORMAT_TABLE::CalculateMinimumRowMajorRowPitch(DXGI_FORMAT Format, UINT Width, UINT& RowPitch)
+{
+    uint64_t rowSize = GetFormatRowSize(Format, Width);
+    if(rowSize > UINT_MAX)
+    {
+        return E_INVALIDARG;
+    }
+
+    RowPitch = static_cast<UINT>(rowSize);
+    return S_OK;
+}
+
+void D3D12_PROPERTY_LAYOUT_FORMAT_TABLE::GetPlaneSubsampledSizeAndFormatForCopyableLayout(
+    UINT PlaneSlice, DXGI_FORMAT Format, UINT Width, UINT Height,
+    DXGI_FORMAT& PlaneFormat, UINT& MinPlanePitchWidth, UINT& PlaneWidth, UINT& PlaneHeight)
+{
+    const FormatPlane& plane = GetFormatPlane(Format, PlaneSlice);
+    PlaneFormat = plane.Format;
+    PlaneWidth = ((Width - 1) >> plane.WidthShift) + 1;
+    PlaneHeight = ((Height - 1) >> plane.HeightShift) + 1;
+    MinPlanePitchWidth = ((Width - 1) >> plane.PitchWidthShift) + 1;
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+// What copies need to know about a DXGI format, as plain data so the footprint math needs neither a
+// device nor a switch over formats, and can run at compile time. A unit is a texel for most formats,
+// a 4x4 block for block-compressed ones and a pair of texels for packed 4:2:2 ones like YUY2.
+struct FormatPlane
+{
+    DXGI_FORMAT Format;
+    // The plane is the resource's width and height, shifted right by these and rounded up.
+    uint8_t WidthShift;
+    uint8_t HeightShift;
+    // The same for the width the plane's row pitch is computed from, which NV11 pads past the plane.
+    uint8_t PitchWidthShift;
+};
+
+struct FormatLayout
+{
+    bool Exists;
+    bool BlockCompressed;
+    // Depth-stencil and multi-plane YUV formats. Their copies align rows to a whole placement.
+    bool Planar;
+    uint8_t BitsPerUnit;
+    uint8_t WidthAlignment;
+    uint8_t HeightAlignment;
+    uint8_t DepthAlignment;
+    uint8_t PlaneCount;
+    FormatPlane Planes[3];
+};
+
+inline constexpr uint32_t g_FormatCount = DXGI_FORMAT_A4B4G4R4_UNORM + 1;
+
+// One entry per DXGI_FORMAT value, and one past them that every other value maps to. Values DXGI never
+// assigned don't exist, and are units of a single texel and no bits, so the math on them stays defined.
+inline constexpr std::array<FormatLayout, g_FormatCount + 1> g_FormatTable = []
+{
+    std::array<FormatLayout, g_FormatCount + 1> table = {};
+    for (FormatLayout& layout : table)
+    {
+        layout.WidthAlignment = 1;
+        layout.HeightAlignment = 1;
+        layout.DepthAlignment = 1;
+        layout.PlaneCount = 1;
+    }
+
+    // Formats first to last, inclusive, as one plane of units widthAlignment by heightAlignment texels.
+    auto add = [&table](DXGI_FORMAT first, DXGI_FORMAT last, uint8_t bitsPerUnit, uint8_t widthAlignment = 1, uint8_t heightAlignment = 1)
+    {
+        for (uint32_t format = first; format <= last; ++format)
+        {
+            FormatLayout& layout = table[format];
+            layout.Exists = true;
+            layout.BitsPerUnit = bitsPerUnit;
+            layout.WidthAlignment = widthAlignment;
+            layout.HeightAlignment = heightAlignment;
+            layout.Planes[0] = {static_cast<DXGI_FORMAT>(format), 0, 0, 0};
+            layout.Planes[1] = layout.Planes[0];
+            layout.Planes[2] = layout.Planes[0];
+        }
+    };
+
+    auto addBlockCompressed = [&](DXGI_FORMAT first, DXGI_FORMAT last, uint8_t bitsPerBlock)
+    {
+        add(first, last, bitsPerBlock, 4, 4);
+        for (uint32_t format = first; format <= last; ++format)
+        {
+            table[format].BlockCompressed = true;
+        }
+    };
+
+    auto addPlanar = [&](DXGI_FORMAT first, DXGI_FORMAT last, uint8_t bitsPerUnit, uint8_t widthAlignment, uint8_t heightAlignment,
+                         uint8_t planeCount, FormatPlane luma, FormatPlane chroma)
+    {
+        add(first, last, bitsPerUnit, widthAlignment, heightAlignment);
+        for (uint32_t format = first; format <= last; ++format)
+        {
+            FormatLayout& layout = table[format];
+            layout.Planar = true;
+            layout.PlaneCount = planeCount;
+            layout.Planes[0] = luma;
+            layout.Planes[1] = chroma;
+            layout.Planes[2] = chroma;
+        }
+    };
+
+    // Buffers have no format; a byte per texel makes a buffer's row its width.
+    add(DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN, 8);
+
+    add(DXGI_FORMAT_R32G32B32A32_TYPELESS, DXGI_FORMAT_R32G32B32A32_SINT, 128);
+    add(DXGI_FORMAT_R32G32B32_TYPELESS, DXGI_FORMAT_R32G32B32_SINT, 96);
+    add(DXGI_FORMAT_R16G16B16A16_TYPELESS, DXGI_FORMAT_R32G32_SINT, 64);
+    addPlanar(DXGI_FORMAT_R32G8X24_TYPELESS, DXGI_FORMAT_X32_TYPELESS_G8X24_UINT, 64, 1, 1, 2,
+              {DXGI_FORMAT_R32_TYPELESS, 0, 0, 0}, {DXGI_FORMAT_R8_TYPELESS, 0, 0, 0});
+    add(DXGI_FORMAT_R10G10B10A2_TYPELESS, DXGI_FORMAT_R32_SINT, 32);
+    addPlanar(DXGI_FORMAT_R24G8_TYPELESS, DXGI_FORMAT_X24_TYPELESS_G8_UINT, 32, 1, 1, 2,
+              {DXGI_FORMAT_R32_TYPELESS, 0, 0, 0}, {DXGI_FORMAT_R8_TYPELESS, 0, 0, 0});
+    add(DXGI_FORMAT_R8G8_TYPELESS, DXGI_FORMAT_R16_SINT, 16);
+    add(DXGI_FORMAT_R8_TYPELESS, DXGI_FORMAT_A8_UNORM, 8);
+    add(DXGI_FORMAT_R1_UNORM, DXGI_FORMAT_R1_UNORM, 1);
+    add(DXGI_FORMAT_R9G9B9E5_SHAREDEXP, DXGI_FORMAT_R9G9B9E5_SHAREDEXP, 32);
+    add(DXGI_FORMAT_R8G8_B8G8_UNORM, DXGI_FORMAT_G8R8_G8B8_UNORM, 32, 2);
+    addBlockCompressed(DXGI_FORMAT_BC1_TYPELESS, DXGI_FORMAT_BC1_UNORM_SRGB, 64);
+    addBlockCompressed(DXGI_FORMAT_BC2_TYPELESS, DXGI_FORMAT_BC3_UNORM_SRGB, 128);
+    addBlockCompressed(DXGI_FORMAT_BC4_TYPELESS, DXGI_FORMAT_BC4_SNORM, 64);
+    addBlockCompressed(DXGI_FORMAT_BC5_TYPELESS, DXGI_FORMAT_BC5_SNORM, 128);
+    add(DXGI_FORMAT_B5G6R5_UNORM, DXGI_FORMAT_B5G5R5A1_UNORM, 16);
+    add(DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_B8G8R8X8_UNORM_SRGB, 32);
+    addBlockCompressed(DXGI_FORMAT_BC6H_TYPELESS, DXGI_FORMAT_BC7_UNORM_SRGB, 128);
+
+    add(DXGI_FORMAT_AYUV, DXGI_FORMAT_Y410, 32);
+    add(DXGI_FORMAT_Y416, DXGI_FORMAT_Y416, 64);
+    addPlanar(DXGI_FORMAT_NV12, DXGI_FORMAT_NV12, 8, 2, 2, 2,
+              {DXGI_FORMAT_R8_TYPELESS, 0, 0, 0}, {DXGI_FORMAT_R8G8_TYPELESS, 1, 1, 1});
+    addPlanar(DXGI_FORMAT_P010, DXGI_FORMAT_P016, 16, 2, 2, 2,
+              {DXGI_FORMAT_R16_TYPELESS, 0, 0, 0}, {DXGI_FORMAT_R16G16_TYPELESS, 1, 1, 1});
+    addPlanar(DXGI_FORMAT_420_OPAQUE, DXGI_FORMAT_420_OPAQUE, 8, 2, 2, 2,
+              {DXGI_FORMAT_R8_TYPELESS, 0, 0, 0}, {DXGI_FORMAT_R8G8_TYPELESS, 1, 1, 1});
+    add(DXGI_FORMAT_YUY2, DXGI_FORMAT_YUY2, 32, 2);
+    add(DXGI_FORMAT_Y210, DXGI_FORMAT_Y216, 64, 2);
+    addPlanar(DXGI_FORMAT_NV11, DXGI_FORMAT_NV11, 8, 4, 1, 2,
+              {DXGI_FORMAT_R8_TYPELESS, 0, 0, 0}, {DXGI_FORMAT_R8G8_TYPELESS, 2, 0, 1});
+    add(DXGI_FORMAT_AI44, DXGI_FORMAT_P8, 8);
+    add(DXGI_FORMAT_A8P8, DXGI_FORMAT_B4G4R4A4_UNORM, 16);
+    addPlanar(DXGI_FORMAT_P208, DXGI_FORMAT_P208, 8, 2, 1, 2,
+              {DXGI_FORMAT_R8_TYPELESS, 0, 0, 0}, {DXGI_FORMAT_R8G8_TYPELESS, 1, 0, 1});
+    addPlanar(DXGI_FORMAT_V208, DXGI_FORMAT_V208, 8, 1, 2, 3,
+              {DXGI_FORMAT_R8_TYPELESS, 0, 0, 0}, {DXGI_FORMAT_R8_TYPELESS, 0, 1, 0});
+    addPlanar(DXGI_FORMAT_V408, DXGI_FORMAT_V408, 8, 1, 1, 3,
+              {DXGI_FORMAT_R8_TYPELESS, 0, 0, 0}, {DXGI_FORMAT_R8_TYPELESS, 0, 0, 0});
+    add(DXGI_FORMAT_SAMPLER_FEEDBACK_MIN_MIP_OPAQUE, DXGI_FORMAT_SAMPLER_FEEDBACK_MIP_REGION_USED_OPAQUE, 8);
+    add(DXGI_FORMAT_A4B4G4R4_UNORM, DXGI_FORMAT_A4B4G4R4_UNORM, 16);
+
+    return table;
+}();
+
+constexpr const FormatLayout& GetFormatLayout(DXGI_FORMAT format)
+{
+    return g_FormatTable[std::min<uint32_t>(static_cast<uint32_t>(format), g_FormatCount)];
+}
+
+// The planes past a format's last repeat it, so any plane slice can be looked up.
+constexpr const FormatPlane& GetFormatPlane(DXGI_FORMAT format, UINT planeSlice)
+{
+    return GetFormatLayout(format).Planes[std::min<UINT>(planeSlice, 2)];
+}
+
+// Bytes in a row of width texels, rounded up to whole units.
+constexpr uint64_t GetFormatRowSize(DXGI_FORMAT format, uint64_t width)
+{
+    const FormatLayout& layout = GetFormatLayout(format);
+    return ((width + layout.WidthAlignment - 1) / layout.WidthAlignment * layout.BitsPerUnit + 7) / 8;
+}
+
+struct CopyableFootprint
+{
+    D3D12_SUBRESOURCE_FOOTPRINT Footprint;
+    UINT RowCount;
+    UINT64 RowSize;
+    // From the first byte of the subresource to the last byte of its last row.
+    UINT64 Size;
+};
+
+// One subresource's part of GetCopyableFootprints, from the resource description alone. Placing it is
+// left to the caller; each subresource starts at a multiple of D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT.
+constexpr CopyableFootprint GetCopyableFootprint(const D3D12_RESOURCE_DESC& desc, UINT subresource)
+{
+    const FormatLayout& layout = GetFormatLayout(desc.Format);
+
+    bool volume = desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+    UINT mipLevels = std::max<UINT>(desc.MipLevels, 1);
+    UINT arraySize = volume ? 1 : desc.DepthOrArraySize;
+    UINT mipLevel = subresource % mipLevels;
+    UINT planeSlice = subresource / mipLevels / arraySize;
+
+    UINT64 width = std::max<UINT64>(desc.Width >> mipLevel, 1);
+    UINT height = std::max<UINT>(desc.Height >> mipLevel, 1);
+    UINT depth = volume ? std::max<UINT>(desc.DepthOrArraySize >> mipLevel, 1) : 1;
+    width = (width + layout.WidthAlignment - 1) / layout.WidthAlignment * layout.WidthAlignment;
+    height = (height + layout.HeightAlignment - 1) / layout.HeightAlignment * layout.HeightAlignment;
+
+    const FormatPlane& plane = GetFormatPlane(desc.Format, planeSlice);
+    UINT planeWidth = static_cast<UINT>(((width - 1) >> plane.WidthShift) + 1);
+    UINT planeHeight = ((height - 1) >> plane.HeightShift) + 1;
+    UINT64 pitchWidth = ((width - 1) >> plane.PitchWidthShift) + 1;
+
+    UINT64 minimumRowPitch = GetFormatRowSize(plane.Format, pitchWidth);
+    UINT64 pitchAlignment = layout.Planar ? D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT : D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
+    UINT rowPitch = static_cast<UINT>((minimumRowPitch + pitchAlignment - 1) / pitchAlignment * pitchAlignment);
+    UINT rowCount = layout.Planar ? planeHeight : height / layout.HeightAlignment;
+
+    CopyableFootprint footprint = {};
+    footprint.Footprint = {plane.Format, planeWidth, planeHeight, depth, rowPitch};
+    footprint.RowCount = rowCount;
+    footprint.RowSize = GetFormatRowSize(plane.Format, planeWidth);
+    footprint.Size = static_cast<UINT64>(rowCount * depth - 1) * rowPitch + minimumRowPitch;
+
+    return footprint;
+}
+
+// A description with every field set, as the CD3DX12_RESOURCE_DESC constructors aren't constexpr.
+constexpr D3D12_RESOURCE_DESC MakeResourceDesc(
+    D3D12_RESOURCE_DIMENSION dimension,
+    UINT64 width,
+    UINT height,
+    UINT16 depthOrArraySize,
+    UINT16 mipLevels,
+    DXGI_FORMAT format)
+{
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = dimension;
+    desc.Alignment = 0;
+    desc.Width = width;
+    desc.Height = height;
+    desc.DepthOrArraySize = depthOrArraySize;
+    desc.MipLevels = mipLevels;
+    desc.Format = format;
+    desc.SampleDesc = {1, 0};
+    desc.Layout = dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? D3D12_TEXTURE_LAYOUT_ROW_MAJOR : D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    return desc;
+}
+
+// Checked against ID3D12Device::GetCopyableFootprints.
+static_assert(GetCopyableFootprint(MakeResourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, 100, 10, 1, 1, DXGI_FORMAT_R8G8B8A8_UNORM), 0).Footprint.RowPitch == 512);
+static_assert(GetCopyableFootprint(MakeResourceDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, 256, 256, 1, 9, DXGI_FORMAT_BC1_UNORM), 8).RowCount == 1);
+static_assert(GetCopyableFootprint(MakeResourceDesc(D3D12_RESOURCE_DIMENSION_BUFFER, 1000, 1, 1, 1, DXGI_FORMAT_UNKNOWN), 0).Size == 1000);
@@ -0,0 +1,200 @@
+#include "FrameCapture.h"
+#include "Qoi.h"
+
+#include <fstream>
+
+namespace
+{
+    bool IsBgra(DXGI_FORMAT format)
+    {
+        return format == DXGI_FORMAT_B8G8R8A8_UNORM || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+    }
+
+    bool IsSupportedFormat(DXGI_FORMAT format)
+    {
+        return IsBgra(format) || format == DXGI_FORMAT_R8G8B8A8_UNORM || format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    }
+}
+
+FrameCapture::FrameCapture(const std::filesystem::path& directory, ReadbackRing& readbackRing, uint32_t threadCount, uint32_t queueDepth)
+    : m_Directory(directory)
+    , m_ReadbackRing(readbackRing)
+    , m_QueueDepth(queueDepth)
+    , m_NextFrame(0)
+    , m_Busy(0)
+    , m_Stop(false)
+    , m_Statistics()
+{
+    // Every write would fail without it, dropping each frame without saying why.
+    std::error_code error;
+    std::filesystem::create_directories(m_Directory, error);
+    if(error)
+    {
+        throw std::filesystem::filesystem_error("cannot create the capture directory", m_Directory, error);
+    }
+
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_Threads.emplace_back(&FrameCapture::Run, this);
+    }
+}
+
+FrameCapture::~FrameCapture()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_WorkAvailable.notify_all();
+
+    for (std::thread& thread : m_Threads)
+    {
+        thread.join();
+    }
+}
+
+void FrameCapture::Capture(ID3D12GraphicsCommandList* commandList, ID3D12Resource* texture)
+{
+    D3D12_RESOURCE_DESC desc = texture->GetDesc();
+    if(!IsSupportedFormat(desc.Format))
+    {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+
+    uint64_t frame = m_NextFrame++;
+
+    // Only this thread adds jobs, so there is still room once the lock is dropped.
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if(m_Jobs.size() >= m_QueueDepth)
+        {
+            ++m_Statistics.Dropped;
+            return;
+        }
+    }
+
+    std::future<ReadbackResult> readback = m_ReadbackRing.ReadbackTexture(commandList, texture);
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if(!readback.valid())
+        {
+            ++m_Statistics.Dropped;
+            return;
+        }
+
+        m_Jobs.push_back({frame, desc.Format, std::move(readback)});
+    }
+    m_WorkAvailable.notify_one();
+}
+
+void FrameCapture::Drain()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Idle.wait(lock, [this] { return m_Jobs.empty() && m_Busy == 0; });
+}
+
+FrameCaptureStatistics FrameCapture::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    FrameCaptureStatistics statistics = m_Statistics;
+    statistics.Pending = m_Jobs.size() + m_Busy;
+
+    return statistics;
+}
+
+void FrameCapture::Run()
+{
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> encoded;
+
+    while (true)
+    {
+        Job job;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkAvailable.wait(lock, [this] { return m_Stop || !m_Jobs.empty(); });
+
+            // Queued frames are still written when stopping.
+            if(m_Jobs.empty())
+            {
+                return;
+            }
+
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+            ++m_Busy;
+        }
+
+        bool written = Write(job, pixels, encoded);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            --m_Busy;
+            if(written)
+            {
+                ++m_Statistics.Written;
+                m_Statistics.BytesWritten += encoded.size();
+            }
+            else
+            {
+                ++m_Statistics.Dropped;
+            }
+
+            if(m_Jobs.empty() && m_Busy == 0)
+            {
+                m_Idle.notify_all();
+            }
+        }
+    }
+}
+
+bool FrameCapture::Write(Job& job, std::vector<uint8_t>& pixels, std::vector<uint8_t>& encoded)
+{
+    uint32_t width;
+    uint32_t height;
+
+    // The slot goes back to the ring as soon as the rows are converted, before the slower encode.
+    try
+    {
+        ReadbackResult readback = job.Readback.get();
+        const D3D12_SUBRESOURCE_FOOTPRINT& footprint = readback.GetFootprint();
+        width = footprint.Width;
+        height = footprint.Height;
+
+        int red = IsBgra(job.Format) ? 2 : 0;
+        int blue = 2 - red;
+
+        pixels.resize(static_cast<size_t>(width) * height * 3);
+        uint8_t* destination = pixels.data();
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            const uint8_t* source = readback.GetData() + static_cast<size_t>(y) * footprint.RowPitch;
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                destination[0] = source[red];
+                destination[1] = source[1];
+                destination[2] = source[blue];
+                destination += 3;
+                source += 4;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        encoded.clear();
+        return false;
+    }
+
+    EncodeQoi(pixels, width, height, encoded);
+
+    char name[32];
+    sprintf_s(name, sizeof(name), "frame_%06llu.qoi", static_cast<unsigned long long>(job.Frame));
+
+    std::ofstream file(m_Directory / name, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+
+    return static_cast<bool>(file);
+}
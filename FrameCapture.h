@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ReadbackRing.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct FrameCaptureStatistics
+{
+    uint64_t Written;
+    uint64_t BytesWritten;
+    // Frames skipped because the queue or the readback ring was full, or whose readback or write failed.
+    uint64_t Dropped;
+    // Queued or being written.
+    uint64_t Pending;
+};
+
+// Writes frames to a directory as numbered QOI files, a fast lossless image format. The render thread
+// only records a copy into a readback slot and queues it. Worker threads wait for the copy, convert
+// it to tightly packed RGB, hand the slot back, and then encode and write. The queue is bounded and
+// the readback ring has a fixed number of slots; when either is full the frame is dropped, never
+// waited for. Frame numbers count dropped frames too, so gaps in the file names show where they were.
+class FrameCapture
+{
+public:
+    // Creates directory if needed, and throws std::filesystem::filesystem_error when that fails.
+    FrameCapture(const std::filesystem::path& directory, ReadbackRing& readbackRing, uint32_t threadCount, uint32_t queueDepth);
+    // Finishes the queued frames, so their readbacks must still be able to complete.
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Records a copy of texture, which must be in COPY_SOURCE, for the frame being recorded. Takes
+    // R8G8B8A8 and B8G8R8A8 textures, UNORM or SRGB. Call from one thread only.
+    void Capture(ID3D12GraphicsCommandList* commandList, ID3D12Resource* texture);
+
+    // Blocks until every frame captured so far has been written or dropped.
+    void Drain();
+
+    FrameCaptureStatistics GetStatistics() const;
+
+private:
+    struct Job
+    {
+        uint64_t Frame;
+        DXGI_FORMAT Format;
+        std::future<ReadbackResult> Readback;
+    };
+
+    void Run();
+
+    // Returns false when the readback or the write failed.
+    bool Write(Job& job, std::vector<uint8_t>& pixels, std::vector<uint8_t>& encoded);
+
+    std::filesystem::path m_Directory;
+    ReadbackRing& m_ReadbackRing;
+    uint32_t m_QueueDepth;
+    uint64_t m_NextFrame;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_WorkAvailable;
+    std::condition_variable m_Idle;
+    std::deque<Job> m_Jobs;
+    uint32_t m_Busy;
+    bool m_Stop;
+    FrameCaptureStatistics m_Statistics;
+
+    std::vector<std::thread> m_Threads;
+};
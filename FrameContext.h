@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+#include "DescriptorAllocator.h"
+
+#include <cstdint>
+
+// Everything one frame in flight owns. The context can be reused once the queue has passed FenceValue.
+struct FrameContext
+{
+    Microsoft::WRL::ComPtr<ID3D12Resource> BackBuffer;
+    DescriptorAllocation RenderTargetView;
+    uint64_t FenceValue;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// FNV-1a, for keys of the caches. Start from g_FnvOffsetBasis and hash one field after the other.
+
+constexpr uint64_t g_FnvOffsetBasis = 0xcbf29ce484222325ull;
+constexpr uint64_t g_FnvPrime = 0x100000001b3ull;
+
+// Integers and enums, least significant byte first. Hashing a structure a field at a time keeps the
+// padding inside it out of the hash.
+template<typename T>
+inline void Hash(uint64_t& hash, T value)
+{
+    uint64_t bits = static_cast<uint64_t>(value);
+    for (size_t i = 0; i < sizeof(T); ++i)
+    {
+        hash = (hash ^ ((bits >> (8 * i)) & 0xff)) * g_FnvPrime;
+    }
+}
+
+// Bytes as they are in memory, e.g. shader bytecode or a serialized blob.
+inline void Hash(uint64_t& hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * g_FnvPrime;
+    }
+}
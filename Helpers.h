@@ -1,13 +1,44 @@
 ﻿#pragma once
 
-#define WIN32_LEAN_AND_MEAN
 #include <exception>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
 #include <Windows.h>
+#else
+#include "NullPlatform.h"
+#endif
+
+// What ThrowIfFailed throws, so a caller that catches it can still tell why the call failed.
+class HResultException : public std::exception
+{
+public:
+    explicit HResultException(HRESULT hr)
+        : m_Result(hr)
+    {
+    }
+
+    HRESULT GetResult() const
+    {
+        return m_Result;
+    }
+
+    const char* what() const noexcept override
+    {
+        return "HRESULT failure";
+    }
+
+private:
+    HRESULT m_Result;
+};
 
 inline void ThrowIfFailed(HRESULT hr)
 {
     if(FAILED(hr))
     {
-        throw std::exception();
+        throw HResultException(hr);
     }
 }
\ No newline at end of file
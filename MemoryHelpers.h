@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <cstdint>
+
+// Small pieces of placement math shared by the allocators.
+
+// alignment doesn't have to be a power of two.
+inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// value must not be 0.
+inline uint32_t FindLowestBit(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return index;
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+// value must not be 0.
+inline uint32_t FindHighestBit(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return index;
+#else
+    return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+}
+
+inline bool IsRenderTargetOrDepthStencil(const D3D12_RESOURCE_DESC& desc)
+{
+    return (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0;
+}
+
+// The heaps a resource can go into on heap tier 1.
+inline D3D12_HEAP_FLAGS GetHeapCategory(const D3D12_RESOURCE_DESC& desc)
+{
+    if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    }
+
+    return IsRenderTargetOrDepthStencil(desc) ? D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES : D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+}
@@ -0,0 +1,2239 @@
+#include "NullDevice.h"
+#include "Helpers.h"
+#include "FormatTable.h"
+#include "MemoryHelpers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    constexpr UINT g_NullDescriptorSize = 32;
+    constexpr UINT64 g_NullGpuPageSize = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    constexpr std::chrono::microseconds g_NullRefreshPeriod(16667);
+    constexpr UINT g_NullMaximumFrameLatency = 16;
+
+    enum class NullCommandType : uint8_t
+    {
+        ClearState,
+        Draw,
+        Dispatch,
+        Copy,
+        ResourceBarrier,
+        SetState,
+        Clear,
+        Query,
+        Marker,
+        ExecuteBundle,
+        ExecuteIndirect,
+    };
+
+    struct NullCommand
+    {
+        NullCommandType Type;
+        UINT Count;
+    };
+
+    struct NullDescriptor
+    {
+        ID3D12Resource* Resource;
+        D3D12_GPU_VIRTUAL_ADDRESS Address;
+        D3D12_DESCRIPTOR_HEAP_TYPE Type;
+    };
+
+    enum class NullQueueOperationType
+    {
+        Execute,
+        Signal,
+        Wait,
+    };
+
+    class NullFence;
+
+    struct NullQueueOperation
+    {
+        NullQueueOperationType Type;
+        ComPtr<NullFence> Fence;
+        UINT64 Value;
+    };
+
+    class NullPrivateData
+    {
+    public:
+        HRESULT Get(REFGUID guid, UINT* pDataSize, void* pData)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for (const auto& entry : m_Entries)
+            {
+                if(entry.first == guid)
+                {
+                    UINT size = static_cast<UINT>(entry.second.size());
+                    if(pData && *pDataSize < size)
+                    {
+                        *pDataSize = size;
+                        return DXGI_ERROR_MORE_DATA;
+                    }
+                    if(pData)
+                    {
+                        memcpy(pData, entry.second.data(), size);
+                    }
+                    *pDataSize = size;
+                    return S_OK;
+                }
+            }
+
+            *pDataSize = 0;
+            return DXGI_ERROR_NOT_FOUND;
+        }
+
+        HRESULT Set(REFGUID guid, UINT dataSize, const void* pData)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Entries.erase(
+                std::remove_if(m_Entries.begin(), m_Entries.end(), [&guid](const auto& entry) { return entry.first == guid; }),
+                m_Entries.end());
+
+            if(pData)
+            {
+                const uint8_t* bytes = static_cast<const uint8_t*>(pData);
+                m_Entries.emplace_back(guid, std::vector<uint8_t>(bytes, bytes + dataSize));
+            }
+
+            return S_OK;
+        }
+
+    private:
+        std::mutex m_Mutex;
+        std::vector<std::pair<GUID, std::vector<uint8_t>>> m_Entries;
+    };
+
+    class NullDevice : public Microsoft::WRL::Base<Microsoft::WRL::ChainInterfaces<ID3D12Device2, ID3D12Device1, ID3D12Device, ID3D12Object>>
+    {
+    public:
+        NullDevice(std::chrono::microseconds gpuLatency, std::chrono::microseconds pipelineLatency)
+            : m_GpuLatency(gpuLatency)
+            , m_PipelineLatency(pipelineLatency)
+        {
+        }
+
+        std::chrono::microseconds GetGpuLatency() const
+        {
+            return m_GpuLatency;
+        }
+
+        D3D12_GPU_VIRTUAL_ADDRESS AllocateGpuVirtualAddress(UINT64 size)
+        {
+            return m_NextGpuVirtualAddress.fetch_add(AlignUp(std::max<UINT64>(size, 1), g_NullGpuPageSize));
+        }
+
+        void CountCommands(const NullCommand* commands, size_t count)
+        {
+            uint64_t draws = 0;
+            uint64_t barriers = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                draws += commands[i].Type == NullCommandType::Draw ? 1 : 0;
+                barriers += commands[i].Type == NullCommandType::ResourceBarrier ? commands[i].Count : 0;
+            }
+
+            m_CommandListsExecuted.fetch_add(1, std::memory_order_relaxed);
+            m_CommandsExecuted.fetch_add(count, std::memory_order_relaxed);
+            m_DrawsExecuted.fetch_add(draws, std::memory_order_relaxed);
+            m_BarriersExecuted.fetch_add(barriers, std::memory_order_relaxed);
+        }
+
+        void CountFenceSignal()
+        {
+            m_FencesSignaled.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void CountPresent()
+        {
+            m_Presents.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void Remove()
+        {
+            m_Removed.store(true, std::memory_order_relaxed);
+        }
+
+        bool IsRemoved() const
+        {
+            return m_Removed.load(std::memory_order_relaxed);
+        }
+
+        NullDeviceStatistics GetStatistics() const
+        {
+            NullDeviceStatistics statistics;
+            statistics.CommandListsExecuted = m_CommandListsExecuted.load(std::memory_order_relaxed);
+            statistics.CommandsExecuted = m_CommandsExecuted.load(std::memory_order_relaxed);
+            statistics.DrawsExecuted = m_DrawsExecuted.load(std::memory_order_relaxed);
+            statistics.BarriersExecuted = m_BarriersExecuted.load(std::memory_order_relaxed);
+            statistics.FencesSignaled = m_FencesSignaled.load(std::memory_order_relaxed);
+            statistics.Presents = m_Presents.load(std::memory_order_relaxed);
+
+            return statistics;
+        }
+
+        // ID3D12Object
+        HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData) override
+        {
+            return m_PrivateData.Get(guid, pDataSize, pData);
+        }
+
+        HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT DataSize, const void* pData) override
+        {
+            return m_PrivateData.Set(guid, DataSize, pData);
+        }
+
+        HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* pData) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetName(LPCWSTR Name) override
+        {
+            return S_OK;
+        }
+
+        // ID3D12Device
+        UINT STDMETHODCALLTYPE GetNodeCount() override
+        {
+            return 1;
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue) override;
+
+        HRESULT STDMETHODCALLTYPE CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** ppCommandAllocator) override;
+
+        HRESULT STDMETHODCALLTYPE CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc, REFIID riid, void** ppPipelineState) override;
+
+        HRESULT STDMETHODCALLTYPE CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* pDesc, REFIID riid, void** ppPipelineState) override;
+
+        HRESULT STDMETHODCALLTYPE CreateCommandList(
+            UINT nodeMask,
+            D3D12_COMMAND_LIST_TYPE type,
+            ID3D12CommandAllocator* pCommandAllocator,
+            ID3D12PipelineState* pInitialState,
+            REFIID riid,
+            void** ppCommandList) override;
+
+        HRESULT STDMETHODCALLTYPE CheckFeatureSupport(D3D12_FEATURE Feature, void* pFeatureSupportData, UINT FeatureSupportDataSize) override
+        {
+            switch (Feature)
+            {
+            case D3D12_FEATURE_D3D12_OPTIONS:
+                {
+                    if(FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS))
+                    {
+                        return E_INVALIDARG;
+                    }
+
+                    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+                    options.ResourceBindingTier = D3D12_RESOURCE_BINDING_TIER_3;
+                    options.ResourceHeapTier = D3D12_RESOURCE_HEAP_TIER_2;
+                    memcpy(pFeatureSupportData, &options, sizeof(options));
+                    return S_OK;
+                }
+            case D3D12_FEATURE_ARCHITECTURE:
+                {
+                    if(FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_ARCHITECTURE))
+                    {
+                        return E_INVALIDARG;
+                    }
+
+                    auto architecture = static_cast<D3D12_FEATURE_DATA_ARCHITECTURE*>(pFeatureSupportData);
+                    architecture->TileBasedRenderer = FALSE;
+                    architecture->UMA = FALSE;
+                    architecture->CacheCoherentUMA = FALSE;
+                    return S_OK;
+                }
+            case D3D12_FEATURE_FEATURE_LEVELS:
+                {
+                    if(FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_FEATURE_LEVELS))
+                    {
+                        return E_INVALIDARG;
+                    }
+
+                    auto levels = static_cast<D3D12_FEATURE_DATA_FEATURE_LEVELS*>(pFeatureSupportData);
+                    levels->MaxSupportedFeatureLevel = static_cast<D3D_FEATURE_LEVEL>(0);
+                    for (UINT i = 0; i < levels->NumFeatureLevels; ++i)
+                    {
+                        if(levels->pFeatureLevelsRequested[i] <= D3D_FEATURE_LEVEL_12_1)
+                        {
+                            levels->MaxSupportedFeatureLevel = std::max(levels->MaxSupportedFeatureLevel, levels->pFeatureLevelsRequested[i]);
+                        }
+                    }
+                    return S_OK;
+                }
+            case D3D12_FEATURE_D3D12_OPTIONS12:
+                {
+                    if(FeatureSupportDataSize != sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS12))
+                    {
+                        return E_INVALIDARG;
+                    }
+
+                    memset(pFeatureSupportData, 0, FeatureSupportDataSize);
+                    return S_OK;
+                }
+            default:
+                return E_INVALIDARG;
+            }
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc, REFIID riid, void** ppvHeap) override;
+
+        UINT STDMETHODCALLTYPE GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapType) override
+        {
+            return g_NullDescriptorSize;
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateRootSignature(
+            UINT nodeMask,
+            const void* pBlobWithRootSignature,
+            SIZE_T blobLengthInBytes,
+            REFIID riid,
+            void** ppvRootSignature) override;
+
+        void STDMETHODCALLTYPE CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override
+        {
+            WriteDescriptor(DestDescriptor, nullptr, pDesc ? pDesc->BufferLocation : 0, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        }
+
+        void STDMETHODCALLTYPE CreateShaderResourceView(
+            ID3D12Resource* pResource,
+            const D3D12_SHADER_RESOURCE_VIEW_DESC* pDesc,
+            D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override
+        {
+            WriteDescriptor(DestDescriptor, pResource, 0, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        }
+
+        void STDMETHODCALLTYPE CreateUnorderedAccessView(
+            ID3D12Resource* pResource,
+            ID3D12Resource* pCounterResource,
+            const D3D12_UNORDERED_ACCESS_VIEW_DESC* pDesc,
+            D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override
+        {
+            WriteDescriptor(DestDescriptor, pResource, 0, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        }
+
+        void STDMETHODCALLTYPE CreateRenderTargetView(
+            ID3D12Resource* pResource,
+            const D3D12_RENDER_TARGET_VIEW_DESC* pDesc,
+            D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override
+        {
+            WriteDescriptor(DestDescriptor, pResource, 0, D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+        }
+
+        void STDMETHODCALLTYPE CreateDepthStencilView(
+            ID3D12Resource* pResource,
+            const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc,
+            D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override
+        {
+            WriteDescriptor(DestDescriptor, pResource, 0, D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+        }
+
+        void STDMETHODCALLTYPE CreateSampler(const D3D12_SAMPLER_DESC* pDesc, D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) override
+        {
+            WriteDescriptor(DestDescriptor, nullptr, 0, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+        }
+
+        void STDMETHODCALLTYPE CopyDescriptors(
+            UINT NumDestDescriptorRanges,
+            const D3D12_CPU_DESCRIPTOR_HANDLE* pDestDescriptorRangeStarts,
+            const UINT* pDestDescriptorRangeSizes,
+            UINT NumSrcDescriptorRanges,
+            const D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorRangeStarts,
+            const UINT* pSrcDescriptorRangeSizes,
+            D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType) override
+        {
+            UINT destRange = 0;
+            UINT destOffset = 0;
+            for (UINT srcRange = 0; srcRange < NumSrcDescriptorRanges; ++srcRange)
+            {
+                UINT srcSize = pSrcDescriptorRangeSizes ? pSrcDescriptorRangeSizes[srcRange] : 1;
+                for (UINT srcOffset = 0; srcOffset < srcSize && destRange < NumDestDescriptorRanges; ++srcOffset)
+                {
+                    memcpy(
+                        reinterpret_cast<void*>(pDestDescriptorRangeStarts[destRange].ptr + destOffset * g_NullDescriptorSize),
+                        reinterpret_cast<const void*>(pSrcDescriptorRangeStarts[srcRange].ptr + srcOffset * g_NullDescriptorSize),
+                        g_NullDescriptorSize);
+
+                    UINT destSize = pDestDescriptorRangeSizes ? pDestDescriptorRangeSizes[destRange] : 1;
+                    if(++destOffset == destSize)
+                    {
+                        ++destRange;
+                        destOffset = 0;
+                    }
+                }
+            }
+        }
+
+        void STDMETHODCALLTYPE CopyDescriptorsSimple(
+            UINT NumDescriptors,
+            D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptorRangeStart,
+            D3D12_CPU_DESCRIPTOR_HANDLE SrcDescriptorRangeStart,
+            D3D12_DESCRIPTOR_HEAP_TYPE DescriptorHeapsType) override
+        {
+            memcpy(
+                reinterpret_cast<void*>(DestDescriptorRangeStart.ptr),
+                reinterpret_cast<const void*>(SrcDescriptorRangeStart.ptr),
+                NumDescriptors * g_NullDescriptorSize);
+        }
+
+        D3D12_RESOURCE_ALLOCATION_INFO STDMETHODCALLTYPE GetResourceAllocationInfo(
+            UINT visibleMask,
+            UINT numResourceDescs,
+            const D3D12_RESOURCE_DESC* pResourceDescs) override
+        {
+            D3D12_RESOURCE_ALLOCATION_INFO info = {0, D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT};
+            for (UINT i = 0; i < numResourceDescs; ++i)
+            {
+                D3D12_RESOURCE_ALLOCATION_INFO resourceInfo = GetSingleResourceAllocationInfo(pResourceDescs[i]);
+                info.SizeInBytes = AlignUp(info.SizeInBytes, resourceInfo.Alignment) + resourceInfo.SizeInBytes;
+                info.Alignment = std::max(info.Alignment, resourceInfo.Alignment);
+            }
+
+            return info;
+        }
+
+        D3D12_HEAP_PROPERTIES STDMETHODCALLTYPE GetCustomHeapProperties(UINT nodeMask, D3D12_HEAP_TYPE heapType) override
+        {
+            D3D12_HEAP_PROPERTIES properties = {};
+            properties.Type = D3D12_HEAP_TYPE_CUSTOM;
+            properties.CPUPageProperty = heapType == D3D12_HEAP_TYPE_DEFAULT
+                ? D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE
+                : heapType == D3D12_HEAP_TYPE_UPLOAD ? D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE : D3D12_CPU_PAGE_PROPERTY_WRITE_BACK;
+            properties.MemoryPoolPreference = heapType == D3D12_HEAP_TYPE_DEFAULT ? D3D12_MEMORY_POOL_L1 : D3D12_MEMORY_POOL_L0;
+
+            return properties;
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateCommittedResource(
+            const D3D12_HEAP_PROPERTIES* pHeapProperties,
+            D3D12_HEAP_FLAGS HeapFlags,
+            const D3D12_RESOURCE_DESC* pDesc,
+            D3D12_RESOURCE_STATES InitialResourceState,
+            const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+            REFIID riidResource,
+            void** ppvResource) override;
+
+        HRESULT STDMETHODCALLTYPE CreateHeap(const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap) override;
+
+        HRESULT STDMETHODCALLTYPE CreatePlacedResource(
+            ID3D12Heap* pHeap,
+            UINT64 HeapOffset,
+            const D3D12_RESOURCE_DESC* pDesc,
+            D3D12_RESOURCE_STATES InitialState,
+            const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+            REFIID riid,
+            void** ppvResource) override;
+
+        HRESULT STDMETHODCALLTYPE CreateReservedResource(
+            const D3D12_RESOURCE_DESC* pDesc,
+            D3D12_RESOURCE_STATES InitialState,
+            const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+            REFIID riid,
+            void** ppvResource) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateSharedHandle(
+            ID3D12DeviceChild* pObject,
+            const SECURITY_ATTRIBUTES* pAttributes,
+            DWORD Access,
+            LPCWSTR Name,
+            HANDLE* pHandle) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE OpenSharedHandle(HANDLE NTHandle, REFIID riid, void** ppvObj) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE OpenSharedHandleByName(LPCWSTR Name, DWORD Access, HANDLE* pNTHandle) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE MakeResident(UINT NumObjects, ID3D12Pageable* const* ppObjects) override
+        {
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE Evict(UINT NumObjects, ID3D12Pageable* const* ppObjects) override
+        {
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateFence(UINT64 InitialValue, D3D12_FENCE_FLAGS Flags, REFIID riid, void** ppFence) override;
+
+        HRESULT STDMETHODCALLTYPE GetDeviceRemovedReason() override
+        {
+            return IsRemoved() ? DXGI_ERROR_DEVICE_REMOVED : S_OK;
+        }
+
+        void STDMETHODCALLTYPE GetCopyableFootprints(
+            const D3D12_RESOURCE_DESC* pResourceDesc,
+            UINT FirstSubresource,
+            UINT NumSubresources,
+            UINT64 BaseOffset,
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts,
+            UINT* pNumRows,
+            UINT64* pRowSizeInBytes,
+            UINT64* pTotalBytes) override
+        {
+            // The layout follows from the description alone, as it does for a real device.
+            D3D12_RESOURCE_DESC desc = *pResourceDesc;
+            desc.MipLevels = std::max<UINT16>(desc.MipLevels, 1);
+            D3DX12GetCopyableFootprints(desc, FirstSubresource, NumSubresources, BaseOffset, pLayouts, pNumRows, pRowSizeInBytes, pTotalBytes);
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateQueryHeap(const D3D12_QUERY_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetStablePowerState(BOOL Enable) override
+        {
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateCommandSignature(
+            const D3D12_COMMAND_SIGNATURE_DESC* pDesc,
+            ID3D12RootSignature* pRootSignature,
+            REFIID riid,
+            void** ppvCommandSignature) override
+        {
+            return E_NOTIMPL;
+        }
+
+        void STDMETHODCALLTYPE GetResourceTiling(
+            ID3D12Resource* pTiledResource,
+            UINT* pNumTilesForEntireResource,
+            D3D12_PACKED_MIP_INFO* pPackedMipDesc,
+            D3D12_TILE_SHAPE* pStandardTileShapeForNonPackedMips,
+            UINT* pNumSubresourceTilings,
+            UINT FirstSubresourceTilingToGet,
+            D3D12_SUBRESOURCE_TILING* pSubresourceTilingsForNonPackedMips) override
+        {
+        }
+
+        LUID STDMETHODCALLTYPE GetAdapterLuid() override
+        {
+            return LUID{0, 0};
+        }
+
+        // ID3D12Device1
+        HRESULT STDMETHODCALLTYPE CreatePipelineLibrary(const void* pLibraryBlob, SIZE_T BlobLength, REFIID riid, void** ppPipelineLibrary) override;
+
+        HRESULT STDMETHODCALLTYPE SetEventOnMultipleFenceCompletion(
+            ID3D12Fence* const* ppFences,
+            const UINT64* pFenceValues,
+            UINT NumFences,
+            D3D12_MULTIPLE_FENCE_WAIT_FLAGS Flags,
+            HANDLE hEvent) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetResidencyPriority(
+            UINT NumObjects,
+            ID3D12Pageable* const* ppObjects,
+            const D3D12_RESIDENCY_PRIORITY* pPriorities) override
+        {
+            return S_OK;
+        }
+
+        // ID3D12Device2
+        HRESULT STDMETHODCALLTYPE CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc, REFIID riid, void** ppPipelineState) override;
+
+    private:
+        // Stands in for the driver compiling a new pipeline state.
+        void CompilePipeline() const
+        {
+            if(m_PipelineLatency.count() > 0)
+            {
+                std::this_thread::sleep_for(m_PipelineLatency);
+            }
+        }
+
+        static void WriteDescriptor(
+            D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor,
+            ID3D12Resource* resource,
+            D3D12_GPU_VIRTUAL_ADDRESS address,
+            D3D12_DESCRIPTOR_HEAP_TYPE type)
+        {
+            NullDescriptor descriptor = {resource, address, type};
+            memcpy(reinterpret_cast<void*>(destDescriptor.ptr), &descriptor, sizeof(descriptor));
+        }
+
+        D3D12_RESOURCE_ALLOCATION_INFO GetSingleResourceAllocationInfo(const D3D12_RESOURCE_DESC& desc)
+        {
+            UINT64 size = 0;
+            if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+            {
+                size = desc.Width;
+            }
+            else
+            {
+                UINT subresources = std::max<UINT>(desc.MipLevels, 1) *
+                    (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : desc.DepthOrArraySize);
+                GetCopyableFootprints(&desc, 0, subresources, 0, nullptr, nullptr, nullptr, &size);
+                size *= std::max<UINT>(desc.SampleDesc.Count, 1);
+            }
+
+            UINT64 alignment = desc.Alignment;
+            if(alignment == 0 || (alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT && size > g_NullGpuPageSize))
+            {
+                alignment = desc.SampleDesc.Count > 1 ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : g_NullGpuPageSize;
+            }
+
+            return {AlignUp(size, alignment), alignment};
+        }
+
+        std::chrono::microseconds m_GpuLatency;
+        std::chrono::microseconds m_PipelineLatency;
+        std::atomic<D3D12_GPU_VIRTUAL_ADDRESS> m_NextGpuVirtualAddress{0x100000000ull};
+        NullPrivateData m_PrivateData;
+
+        std::atomic<uint64_t> m_CommandListsExecuted{0};
+        std::atomic<uint64_t> m_CommandsExecuted{0};
+        std::atomic<uint64_t> m_DrawsExecuted{0};
+        std::atomic<uint64_t> m_BarriersExecuted{0};
+        std::atomic<uint64_t> m_FencesSignaled{0};
+        std::atomic<uint64_t> m_Presents{0};
+        std::atomic<bool> m_Removed{false};
+    };
+
+    template<typename... TInterfaces>
+    class NullDeviceChild : public Microsoft::WRL::Base<Microsoft::WRL::ChainInterfaces<TInterfaces..., ID3D12DeviceChild, ID3D12Object>>
+    {
+    public:
+        explicit NullDeviceChild(NullDevice* device) : m_Device(device)
+        {
+        }
+
+        HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData) override
+        {
+            return m_PrivateData.Get(guid, pDataSize, pData);
+        }
+
+        HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT DataSize, const void* pData) override
+        {
+            return m_PrivateData.Set(guid, DataSize, pData);
+        }
+
+        HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* pData) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetName(LPCWSTR Name) override
+        {
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void** ppvDevice) override
+        {
+            return m_Device->QueryInterface(riid, ppvDevice);
+        }
+
+    protected:
+        ComPtr<NullDevice> m_Device;
+        NullPrivateData m_PrivateData;
+    };
+
+    class NullFence : public NullDeviceChild<ID3D12Fence, ID3D12Pageable>
+    {
+    public:
+        NullFence(NullDevice* device, UINT64 initialValue) : NullDeviceChild(device), m_CompletedValue(initialValue)
+        {
+        }
+
+        ~NullFence()
+        {
+            for (const auto& event : m_Events)
+            {
+                ::CloseHandle(event.second);
+            }
+        }
+
+        UINT64 STDMETHODCALLTYPE GetCompletedValue() override
+        {
+            return m_CompletedValue.load(std::memory_order_acquire);
+        }
+
+        HRESULT STDMETHODCALLTYPE SetEventOnCompletion(UINT64 Value, HANDLE hEvent) override
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            if(!hEvent)
+            {
+                m_Condition.wait(lock, [this, Value] { return GetCompletedValue() >= Value; });
+            }
+            else if(GetCompletedValue() >= Value)
+            {
+                ::SetEvent(hEvent);
+            }
+            else
+            {
+                // Hold a reference like the kernel does, so the caller may close its handle first.
+                HANDLE event = nullptr;
+                ::DuplicateHandle(::GetCurrentProcess(), hEvent, ::GetCurrentProcess(), &event, 0, FALSE, DUPLICATE_SAME_ACCESS);
+                m_Events.emplace_back(Value, event);
+            }
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE Signal(UINT64 Value) override
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_CompletedValue.store(Value, std::memory_order_release);
+
+                auto firstPending = std::partition(m_Events.begin(), m_Events.end(), [Value](const auto& event) { return event.first > Value; });
+                for (auto it = firstPending; it != m_Events.end(); ++it)
+                {
+                    ::SetEvent(it->second);
+                    ::CloseHandle(it->second);
+                }
+                m_Events.erase(firstPending, m_Events.end());
+            }
+            m_Condition.notify_all();
+
+            m_Device->CountFenceSignal();
+
+            return S_OK;
+        }
+
+    private:
+        std::atomic<UINT64> m_CompletedValue;
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        std::vector<std::pair<UINT64, HANDLE>> m_Events;
+    };
+
+    class NullBlob : public Microsoft::WRL::Base<ID3DBlob>
+    {
+    public:
+        NullBlob(const void* data, size_t size)
+            : m_Data(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size)
+        {
+        }
+
+        LPVOID STDMETHODCALLTYPE GetBufferPointer() override
+        {
+            return m_Data.data();
+        }
+
+        SIZE_T STDMETHODCALLTYPE GetBufferSize() override
+        {
+            return m_Data.size();
+        }
+
+    private:
+        std::vector<uint8_t> m_Data;
+    };
+
+    class NullRootSignature : public NullDeviceChild<ID3D12RootSignature>
+    {
+    public:
+        NullRootSignature(NullDevice* device) : NullDeviceChild(device)
+        {
+        }
+    };
+
+    // Shaders are never run, so a pipeline state only remembers its bytecode to hand back as the cached blob.
+    class NullPipelineState : public NullDeviceChild<ID3D12PipelineState, ID3D12Pageable>
+    {
+    public:
+        NullPipelineState(NullDevice* device, const std::vector<D3D12_SHADER_BYTECODE>& shaders) : NullDeviceChild(device)
+        {
+            for (const D3D12_SHADER_BYTECODE& shader : shaders)
+            {
+                auto bytecode = static_cast<const uint8_t*>(shader.pShaderBytecode);
+                m_CachedBlob.insert(m_CachedBlob.end(), bytecode, bytecode + (bytecode ? shader.BytecodeLength : 0));
+            }
+        }
+
+        HRESULT STDMETHODCALLTYPE GetCachedBlob(ID3DBlob** ppBlob) override
+        {
+            *ppBlob = Microsoft::WRL::Make<NullBlob>(m_CachedBlob.data(), m_CachedBlob.size()).Detach();
+
+            return S_OK;
+        }
+
+    private:
+        std::vector<uint8_t> m_CachedBlob;
+    };
+
+    // The root signature and shaders of a pipeline state stream, all a null pipeline state needs.
+    struct NullPipelineStream : ID3DX12PipelineParserCallbacks
+    {
+        ID3D12RootSignature* RootSignature = nullptr;
+        D3D12_SHADER_BYTECODE VS = {};
+        D3D12_SHADER_BYTECODE PS = {};
+        D3D12_SHADER_BYTECODE DS = {};
+        D3D12_SHADER_BYTECODE HS = {};
+        D3D12_SHADER_BYTECODE GS = {};
+        D3D12_SHADER_BYTECODE CS = {};
+        D3D12_SHADER_BYTECODE AS = {};
+        D3D12_SHADER_BYTECODE MS = {};
+
+        void RootSignatureCb(ID3D12RootSignature* rootSignature) override { RootSignature = rootSignature; }
+        void VSCb(const D3D12_SHADER_BYTECODE& shader) override { VS = shader; }
+        void PSCb(const D3D12_SHADER_BYTECODE& shader) override { PS = shader; }
+        void DSCb(const D3D12_SHADER_BYTECODE& shader) override { DS = shader; }
+        void HSCb(const D3D12_SHADER_BYTECODE& shader) override { HS = shader; }
+        void GSCb(const D3D12_SHADER_BYTECODE& shader) override { GS = shader; }
+        void CSCb(const D3D12_SHADER_BYTECODE& shader) override { CS = shader; }
+        void ASCb(const D3D12_SHADER_BYTECODE& shader) override { AS = shader; }
+        void MSCb(const D3D12_SHADER_BYTECODE& shader) override { MS = shader; }
+
+        bool IsValid() const
+        {
+            return RootSignature && (VS.pShaderBytecode || CS.pShaderBytecode || MS.pShaderBytecode);
+        }
+
+        // In the order CreateGraphicsPipelineState uses, so the same shaders give the same cached blob.
+        std::vector<D3D12_SHADER_BYTECODE> GetShaders() const
+        {
+            return {VS, PS, DS, HS, GS, CS, AS, MS};
+        }
+    };
+
+    // Keeps the cached blob of each stored pipeline state by name. Loading checks the description
+    // against it, as a driver would, and skips the compile that creating the pipeline state costs.
+    class NullPipelineLibrary : public NullDeviceChild<ID3D12PipelineLibrary1, ID3D12PipelineLibrary>
+    {
+    public:
+        explicit NullPipelineLibrary(NullDevice* device) : NullDeviceChild(device)
+        {
+        }
+
+        // Reads what Serialize wrote. Blobs from another version of the null device are refused like
+        // those from another driver.
+        HRESULT Deserialize(const void* data, SIZE_T size)
+        {
+            const uint8_t* read = static_cast<const uint8_t*>(data);
+            const uint8_t* end = read + size;
+
+            auto readUint = [&](UINT& value)
+            {
+                if(end - read < static_cast<ptrdiff_t>(sizeof(UINT)))
+                {
+                    return false;
+                }
+                memcpy(&value, read, sizeof(UINT));
+                read += sizeof(UINT);
+                return true;
+            };
+
+            UINT magic;
+            UINT count;
+            if(!readUint(magic) || magic != g_SerializedMagic)
+            {
+                return D3D12_ERROR_DRIVER_VERSION_MISMATCH;
+            }
+            if(!readUint(count))
+            {
+                return E_INVALIDARG;
+            }
+
+            for (UINT i = 0; i < count; ++i)
+            {
+                UINT nameLength;
+                UINT blobSize;
+                if(!readUint(nameLength) || end - read < static_cast<ptrdiff_t>(nameLength * sizeof(WCHAR)))
+                {
+                    return E_INVALIDARG;
+                }
+                std::wstring name(nameLength, L'\0');
+                memcpy(&name[0], read, nameLength * sizeof(WCHAR));
+                read += nameLength * sizeof(WCHAR);
+
+                if(!readUint(blobSize) || end - read < static_cast<ptrdiff_t>(blobSize))
+                {
+                    return E_INVALIDARG;
+                }
+                m_Pipelines[name].assign(read, read + blobSize);
+                read += blobSize;
+            }
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE StorePipeline(LPCWSTR pName, ID3D12PipelineState* pPipeline) override
+        {
+            if(!pName || !pPipeline)
+            {
+                return E_INVALIDARG;
+            }
+
+            ComPtr<ID3DBlob> blob;
+            HRESULT hr = pPipeline->GetCachedBlob(&blob);
+            if(FAILED(hr))
+            {
+                return hr;
+            }
+
+            const uint8_t* data = static_cast<const uint8_t*>(blob->GetBufferPointer());
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            bool inserted = m_Pipelines.emplace(pName, std::vector<uint8_t>(data, data + blob->GetBufferSize())).second;
+
+            return inserted ? S_OK : E_INVALIDARG;
+        }
+
+        HRESULT STDMETHODCALLTYPE LoadGraphicsPipeline(
+            LPCWSTR pName,
+            const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc,
+            REFIID riid,
+            void** ppPipelineState) override
+        {
+            return Load(pName, {pDesc->VS, pDesc->PS, pDesc->DS, pDesc->HS, pDesc->GS}, riid, ppPipelineState);
+        }
+
+        HRESULT STDMETHODCALLTYPE LoadComputePipeline(
+            LPCWSTR pName,
+            const D3D12_COMPUTE_PIPELINE_STATE_DESC* pDesc,
+            REFIID riid,
+            void** ppPipelineState) override
+        {
+            return Load(pName, {pDesc->CS}, riid, ppPipelineState);
+        }
+
+        HRESULT STDMETHODCALLTYPE LoadPipeline(
+            LPCWSTR pName,
+            const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc,
+            REFIID riid,
+            void** ppPipelineState) override
+        {
+            NullPipelineStream stream;
+            if(FAILED(D3DX12ParsePipelineStream(*pDesc, &stream)))
+            {
+                return E_INVALIDARG;
+            }
+
+            return Load(pName, stream.GetShaders(), riid, ppPipelineState);
+        }
+
+        SIZE_T STDMETHODCALLTYPE GetSerializedSize() override
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            SIZE_T size = 2 * sizeof(UINT);
+            for (const auto& pipeline : m_Pipelines)
+            {
+                size += 2 * sizeof(UINT) + pipeline.first.size() * sizeof(WCHAR) + pipeline.second.size();
+            }
+
+            return size;
+        }
+
+        HRESULT STDMETHODCALLTYPE Serialize(void* pData, SIZE_T DataSizeInBytes) override
+        {
+            if(DataSizeInBytes < GetSerializedSize())
+            {
+                return E_INVALIDARG;
+            }
+
+            uint8_t* write = static_cast<uint8_t*>(pData);
+            auto writeBytes = [&write](const void* data, size_t size)
+            {
+                memcpy(write, data, size);
+                write += size;
+            };
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            UINT header[] = {g_SerializedMagic, static_cast<UINT>(m_Pipelines.size())};
+            writeBytes(header, sizeof(header));
+            for (const auto& pipeline : m_Pipelines)
+            {
+                UINT nameLength = static_cast<UINT>(pipeline.first.size());
+                UINT blobSize = static_cast<UINT>(pipeline.second.size());
+                writeBytes(&nameLength, sizeof(nameLength));
+                writeBytes(pipeline.first.data(), nameLength * sizeof(WCHAR));
+                writeBytes(&blobSize, sizeof(blobSize));
+                writeBytes(pipeline.second.data(), blobSize);
+            }
+
+            return S_OK;
+        }
+
+    private:
+        static constexpr UINT g_SerializedMagic = 0x314C504E;
+
+        HRESULT Load(LPCWSTR name, const std::vector<D3D12_SHADER_BYTECODE>& shaders, REFIID riid, void** ppPipelineState)
+        {
+            auto pipelineState = Microsoft::WRL::Make<NullPipelineState>(m_Device.Get(), shaders);
+
+            ComPtr<ID3DBlob> blob;
+            pipelineState->GetCachedBlob(&blob);
+            const uint8_t* data = static_cast<const uint8_t*>(blob->GetBufferPointer());
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                auto it = m_Pipelines.find(name);
+                if(it == m_Pipelines.end() ||
+                    it->second.size() != blob->GetBufferSize() ||
+                    !std::equal(it->second.begin(), it->second.end(), data))
+                {
+                    return E_INVALIDARG;
+                }
+            }
+
+            return pipelineState->QueryInterface(riid, ppPipelineState);
+        }
+
+        std::mutex m_Mutex;
+        std::map<std::wstring, std::vector<uint8_t>> m_Pipelines;
+    };
+
+    class NullHeap : public NullDeviceChild<ID3D12Heap, ID3D12Pageable>
+    {
+    public:
+        NullHeap(NullDevice* device, const D3D12_HEAP_DESC& desc) : NullDeviceChild(device), m_Desc(desc)
+        {
+            m_GpuVirtualAddress = m_Device->AllocateGpuVirtualAddress(desc.SizeInBytes);
+            if(desc.Properties.Type == D3D12_HEAP_TYPE_UPLOAD || desc.Properties.Type == D3D12_HEAP_TYPE_READBACK)
+            {
+                m_Memory.reset(new uint8_t[desc.SizeInBytes]);
+            }
+        }
+
+        D3D12_HEAP_DESC STDMETHODCALLTYPE GetDesc() override
+        {
+            return m_Desc;
+        }
+
+        D3D12_GPU_VIRTUAL_ADDRESS GetGpuVirtualAddress() const
+        {
+            return m_GpuVirtualAddress;
+        }
+
+        uint8_t* GetMemory() const
+        {
+            return m_Memory.get();
+        }
+
+    private:
+        D3D12_HEAP_DESC m_Desc;
+        D3D12_GPU_VIRTUAL_ADDRESS m_GpuVirtualAddress;
+        std::unique_ptr<uint8_t[]> m_Memory;
+    };
+
+    class NullResource : public NullDeviceChild<ID3D12Resource, ID3D12Pageable>
+    {
+    public:
+        // Committed resource: owns its address range and, on CPU-visible heaps, its memory.
+        NullResource(NullDevice* device, const D3D12_HEAP_PROPERTIES& heapProperties, D3D12_HEAP_FLAGS heapFlags, const D3D12_RESOURCE_DESC& desc)
+            : NullDeviceChild(device)
+            , m_Desc(desc)
+            , m_HeapProperties(heapProperties)
+            , m_HeapFlags(heapFlags)
+            , m_Memory(nullptr)
+        {
+            UINT64 size = m_Device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+            if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+            {
+                m_GpuVirtualAddress = m_Device->AllocateGpuVirtualAddress(size);
+            }
+            if(heapProperties.Type == D3D12_HEAP_TYPE_UPLOAD || heapProperties.Type == D3D12_HEAP_TYPE_READBACK)
+            {
+                m_OwnedMemory.reset(new uint8_t[size]);
+                m_Memory = m_OwnedMemory.get();
+            }
+        }
+
+        // Placed resource: aliases the memory and address range of its heap.
+        NullResource(NullDevice* device, NullHeap* heap, UINT64 heapOffset, const D3D12_RESOURCE_DESC& desc)
+            : NullDeviceChild(device)
+            , m_Desc(desc)
+            , m_HeapProperties(heap->GetDesc().Properties)
+            , m_HeapFlags(heap->GetDesc().Flags)
+            , m_Heap(heap)
+            , m_Memory(heap->GetMemory() ? heap->GetMemory() + heapOffset : nullptr)
+        {
+            if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+            {
+                m_GpuVirtualAddress = heap->GetGpuVirtualAddress() + heapOffset;
+            }
+        }
+
+        HRESULT STDMETHODCALLTYPE Map(UINT Subresource, const D3D12_RANGE* pReadRange, void** ppData) override
+        {
+            if(m_Device->IsRemoved())
+            {
+                return DXGI_ERROR_DEVICE_REMOVED;
+            }
+            if(!m_Memory)
+            {
+                return E_INVALIDARG;
+            }
+            if(ppData)
+            {
+                *ppData = m_Memory;
+            }
+
+            return S_OK;
+        }
+
+        void STDMETHODCALLTYPE Unmap(UINT Subresource, const D3D12_RANGE* pWrittenRange) override
+        {
+        }
+
+        D3D12_RESOURCE_DESC STDMETHODCALLTYPE GetDesc() override
+        {
+            return m_Desc;
+        }
+
+        D3D12_GPU_VIRTUAL_ADDRESS STDMETHODCALLTYPE GetGPUVirtualAddress() override
+        {
+            return m_GpuVirtualAddress;
+        }
+
+        HRESULT STDMETHODCALLTYPE WriteToSubresource(
+            UINT DstSubresource,
+            const D3D12_BOX* pDstBox,
+            const void* pSrcData,
+            UINT SrcRowPitch,
+            UINT SrcDepthPitch) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE ReadFromSubresource(
+            void* pDstData,
+            UINT DstRowPitch,
+            UINT DstDepthPitch,
+            UINT SrcSubresource,
+            const D3D12_BOX* pSrcBox) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetHeapProperties(D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS* pHeapFlags) override
+        {
+            if(pHeapProperties)
+            {
+                *pHeapProperties = m_HeapProperties;
+            }
+            if(pHeapFlags)
+            {
+                *pHeapFlags = m_HeapFlags;
+            }
+
+            return S_OK;
+        }
+
+    private:
+        D3D12_RESOURCE_DESC m_Desc;
+        D3D12_HEAP_PROPERTIES m_HeapProperties;
+        D3D12_HEAP_FLAGS m_HeapFlags;
+        D3D12_GPU_VIRTUAL_ADDRESS m_GpuVirtualAddress = 0;
+        ComPtr<NullHeap> m_Heap;
+        std::unique_ptr<uint8_t[]> m_OwnedMemory;
+        uint8_t* m_Memory;
+    };
+
+    class NullDescriptorHeap : public NullDeviceChild<ID3D12DescriptorHeap, ID3D12Pageable>
+    {
+    public:
+        NullDescriptorHeap(NullDevice* device, const D3D12_DESCRIPTOR_HEAP_DESC& desc)
+            : NullDeviceChild(device)
+            , m_Desc(desc)
+            , m_Descriptors(new uint8_t[std::max<UINT>(desc.NumDescriptors, 1) * g_NullDescriptorSize]())
+        {
+            if(desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE)
+            {
+                m_GpuStart = m_Device->AllocateGpuVirtualAddress(static_cast<UINT64>(desc.NumDescriptors) * g_NullDescriptorSize);
+            }
+        }
+
+        D3D12_DESCRIPTOR_HEAP_DESC STDMETHODCALLTYPE GetDesc() override
+        {
+            return m_Desc;
+        }
+
+        D3D12_CPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetCPUDescriptorHandleForHeapStart() override
+        {
+            return D3D12_CPU_DESCRIPTOR_HANDLE{reinterpret_cast<SIZE_T>(m_Descriptors.get())};
+        }
+
+        D3D12_GPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetGPUDescriptorHandleForHeapStart() override
+        {
+            return D3D12_GPU_DESCRIPTOR_HANDLE{m_GpuStart};
+        }
+
+    private:
+        D3D12_DESCRIPTOR_HEAP_DESC m_Desc;
+        std::unique_ptr<uint8_t[]> m_Descriptors;
+        UINT64 m_GpuStart = 0;
+    };
+
+    class NullGraphicsCommandList;
+
+    class NullCommandAllocator : public NullDeviceChild<ID3D12CommandAllocator, ID3D12Pageable>
+    {
+    public:
+        NullCommandAllocator(NullDevice* device, D3D12_COMMAND_LIST_TYPE type) : NullDeviceChild(device), m_Type(type)
+        {
+        }
+
+        HRESULT STDMETHODCALLTYPE Reset() override
+        {
+            if(m_RecordingList)
+            {
+                return E_FAIL;
+            }
+
+            m_Commands.clear();
+
+            return S_OK;
+        }
+
+        D3D12_COMMAND_LIST_TYPE GetType() const
+        {
+            return m_Type;
+        }
+
+        std::vector<NullCommand>& GetCommands()
+        {
+            return m_Commands;
+        }
+
+        NullGraphicsCommandList* GetRecordingList() const
+        {
+            return m_RecordingList;
+        }
+
+        void SetRecordingList(NullGraphicsCommandList* list)
+        {
+            m_RecordingList = list;
+        }
+
+    private:
+        D3D12_COMMAND_LIST_TYPE m_Type;
+        std::vector<NullCommand> m_Commands;
+        NullGraphicsCommandList* m_RecordingList = nullptr;
+    };
+
+    class NullGraphicsCommandList : public NullDeviceChild<ID3D12GraphicsCommandList, ID3D12CommandList>
+    {
+    public:
+        NullGraphicsCommandList(NullDevice* device, D3D12_COMMAND_LIST_TYPE type) : NullDeviceChild(device), m_Type(type)
+        {
+        }
+
+        HRESULT Begin(ID3D12CommandAllocator* pAllocator)
+        {
+            auto allocator = static_cast<NullCommandAllocator*>(pAllocator);
+            if(!allocator || allocator->GetType() != m_Type || allocator->GetRecordingList())
+            {
+                return E_INVALIDARG;
+            }
+
+            m_Allocator = allocator;
+            m_Allocator->SetRecordingList(this);
+            m_Begin = m_Allocator->GetCommands().size();
+            m_End = m_Begin;
+            m_IsRecording = true;
+
+            return S_OK;
+        }
+
+        const NullCommand* GetCommands(size_t* count) const
+        {
+            auto& commands = m_Allocator->GetCommands();
+            size_t end = std::min(m_End, commands.size());
+            *count = end > m_Begin ? end - m_Begin : 0;
+
+            return commands.data() + m_Begin;
+        }
+
+        bool IsRecording() const
+        {
+            return m_IsRecording;
+        }
+
+        D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE GetType() override
+        {
+            return m_Type;
+        }
+
+        HRESULT STDMETHODCALLTYPE Close() override
+        {
+            if(!m_IsRecording)
+            {
+                return E_FAIL;
+            }
+
+            m_End = m_Allocator->GetCommands().size();
+            m_Allocator->SetRecordingList(nullptr);
+            m_IsRecording = false;
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState) override
+        {
+            if(m_IsRecording)
+            {
+                return E_FAIL;
+            }
+
+            return Begin(pAllocator);
+        }
+
+        void STDMETHODCALLTYPE ClearState(ID3D12PipelineState* pPipelineState) override
+        {
+            Record(NullCommandType::ClearState);
+        }
+
+        void STDMETHODCALLTYPE DrawInstanced(
+            UINT VertexCountPerInstance,
+            UINT InstanceCount,
+            UINT StartVertexLocation,
+            UINT StartInstanceLocation) override
+        {
+            Record(NullCommandType::Draw);
+        }
+
+        void STDMETHODCALLTYPE DrawIndexedInstanced(
+            UINT IndexCountPerInstance,
+            UINT InstanceCount,
+            UINT StartIndexLocation,
+            INT BaseVertexLocation,
+            UINT StartInstanceLocation) override
+        {
+            Record(NullCommandType::Draw);
+        }
+
+        void STDMETHODCALLTYPE Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ) override
+        {
+            Record(NullCommandType::Dispatch);
+        }
+
+        void STDMETHODCALLTYPE CopyBufferRegion(
+            ID3D12Resource* pDstBuffer,
+            UINT64 DstOffset,
+            ID3D12Resource* pSrcBuffer,
+            UINT64 SrcOffset,
+            UINT64 NumBytes) override
+        {
+            Record(NullCommandType::Copy);
+        }
+
+        void STDMETHODCALLTYPE CopyTextureRegion(
+            const D3D12_TEXTURE_COPY_LOCATION* pDst,
+            UINT DstX,
+            UINT DstY,
+            UINT DstZ,
+            const D3D12_TEXTURE_COPY_LOCATION* pSrc,
+            const D3D12_BOX* pSrcBox) override
+        {
+            Record(NullCommandType::Copy);
+        }
+
+        void STDMETHODCALLTYPE CopyResource(ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource) override
+        {
+            Record(NullCommandType::Copy);
+        }
+
+        void STDMETHODCALLTYPE CopyTiles(
+            ID3D12Resource* pTiledResource,
+            const D3D12_TILED_RESOURCE_COORDINATE* pTileRegionStartCoordinate,
+            const D3D12_TILE_REGION_SIZE* pTileRegionSize,
+            ID3D12Resource* pBuffer,
+            UINT64 BufferStartOffsetInBytes,
+            D3D12_TILE_COPY_FLAGS Flags) override
+        {
+            Record(NullCommandType::Copy);
+        }
+
+        void STDMETHODCALLTYPE ResolveSubresource(
+            ID3D12Resource* pDstResource,
+            UINT DstSubresource,
+            ID3D12Resource* pSrcResource,
+            UINT SrcSubresource,
+            DXGI_FORMAT Format) override
+        {
+            Record(NullCommandType::Copy);
+        }
+
+        void STDMETHODCALLTYPE IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE RSSetViewports(UINT NumViewports, const D3D12_VIEWPORT* pViewports) override
+        {
+            Record(NullCommandType::SetState, NumViewports);
+        }
+
+        void STDMETHODCALLTYPE RSSetScissorRects(UINT NumRects, const D3D12_RECT* pRects) override
+        {
+            Record(NullCommandType::SetState, NumRects);
+        }
+
+        void STDMETHODCALLTYPE OMSetBlendFactor(const FLOAT BlendFactor[4]) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE OMSetStencilRef(UINT StencilRef) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetPipelineState(ID3D12PipelineState* pPipelineState) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE ResourceBarrier(UINT NumBarriers, const D3D12_RESOURCE_BARRIER* pBarriers) override
+        {
+            Record(NullCommandType::ResourceBarrier, NumBarriers);
+        }
+
+        void STDMETHODCALLTYPE ExecuteBundle(ID3D12GraphicsCommandList* pCommandList) override
+        {
+            Record(NullCommandType::ExecuteBundle);
+        }
+
+        void STDMETHODCALLTYPE SetDescriptorHeaps(UINT NumDescriptorHeaps, ID3D12DescriptorHeap* const* ppDescriptorHeaps) override
+        {
+            Record(NullCommandType::SetState, NumDescriptorHeaps);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootSignature(ID3D12RootSignature* pRootSignature) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootSignature(ID3D12RootSignature* pRootSignature) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRoot32BitConstant(UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRoot32BitConstant(UINT RootParameterIndex, UINT SrcData, UINT DestOffsetIn32BitValues) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRoot32BitConstants(
+            UINT RootParameterIndex,
+            UINT Num32BitValuesToSet,
+            const void* pSrcData,
+            UINT DestOffsetIn32BitValues) override
+        {
+            Record(NullCommandType::SetState, Num32BitValuesToSet);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRoot32BitConstants(
+            UINT RootParameterIndex,
+            UINT Num32BitValuesToSet,
+            const void* pSrcData,
+            UINT DestOffsetIn32BitValues) override
+        {
+            Record(NullCommandType::SetState, Num32BitValuesToSet);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetComputeRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetGraphicsRootUnorderedAccessView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS BufferLocation) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE IASetVertexBuffers(UINT StartSlot, UINT NumViews, const D3D12_VERTEX_BUFFER_VIEW* pViews) override
+        {
+            Record(NullCommandType::SetState, NumViews);
+        }
+
+        void STDMETHODCALLTYPE SOSetTargets(UINT StartSlot, UINT NumViews, const D3D12_STREAM_OUTPUT_BUFFER_VIEW* pViews) override
+        {
+            Record(NullCommandType::SetState, NumViews);
+        }
+
+        void STDMETHODCALLTYPE OMSetRenderTargets(
+            UINT NumRenderTargetDescriptors,
+            const D3D12_CPU_DESCRIPTOR_HANDLE* pRenderTargetDescriptors,
+            BOOL RTsSingleHandleToDescriptorRange,
+            const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor) override
+        {
+            Record(NullCommandType::SetState, NumRenderTargetDescriptors);
+        }
+
+        void STDMETHODCALLTYPE ClearDepthStencilView(
+            D3D12_CPU_DESCRIPTOR_HANDLE DepthStencilView,
+            D3D12_CLEAR_FLAGS ClearFlags,
+            FLOAT Depth,
+            UINT8 Stencil,
+            UINT NumRects,
+            const D3D12_RECT* pRects) override
+        {
+            Record(NullCommandType::Clear);
+        }
+
+        void STDMETHODCALLTYPE ClearRenderTargetView(
+            D3D12_CPU_DESCRIPTOR_HANDLE RenderTargetView,
+            const FLOAT ColorRGBA[4],
+            UINT NumRects,
+            const D3D12_RECT* pRects) override
+        {
+            Record(NullCommandType::Clear);
+        }
+
+        void STDMETHODCALLTYPE ClearUnorderedAccessViewUint(
+            D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap,
+            D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle,
+            ID3D12Resource* pResource,
+            const UINT Values[4],
+            UINT NumRects,
+            const D3D12_RECT* pRects) override
+        {
+            Record(NullCommandType::Clear);
+        }
+
+        void STDMETHODCALLTYPE ClearUnorderedAccessViewFloat(
+            D3D12_GPU_DESCRIPTOR_HANDLE ViewGPUHandleInCurrentHeap,
+            D3D12_CPU_DESCRIPTOR_HANDLE ViewCPUHandle,
+            ID3D12Resource* pResource,
+            const FLOAT Values[4],
+            UINT NumRects,
+            const D3D12_RECT* pRects) override
+        {
+            Record(NullCommandType::Clear);
+        }
+
+        void STDMETHODCALLTYPE DiscardResource(ID3D12Resource* pResource, const D3D12_DISCARD_REGION* pRegion) override
+        {
+            Record(NullCommandType::Clear);
+        }
+
+        void STDMETHODCALLTYPE BeginQuery(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index) override
+        {
+            Record(NullCommandType::Query);
+        }
+
+        void STDMETHODCALLTYPE EndQuery(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE Type, UINT Index) override
+        {
+            Record(NullCommandType::Query);
+        }
+
+        void STDMETHODCALLTYPE ResolveQueryData(
+            ID3D12QueryHeap* pQueryHeap,
+            D3D12_QUERY_TYPE Type,
+            UINT StartIndex,
+            UINT NumQueries,
+            ID3D12Resource* pDestinationBuffer,
+            UINT64 AlignedDestinationBufferOffset) override
+        {
+            Record(NullCommandType::Query, NumQueries);
+        }
+
+        void STDMETHODCALLTYPE SetPredication(ID3D12Resource* pBuffer, UINT64 AlignedBufferOffset, D3D12_PREDICATION_OP Operation) override
+        {
+            Record(NullCommandType::SetState);
+        }
+
+        void STDMETHODCALLTYPE SetMarker(UINT Metadata, const void* pData, UINT Size) override
+        {
+            Record(NullCommandType::Marker);
+        }
+
+        void STDMETHODCALLTYPE BeginEvent(UINT Metadata, const void* pData, UINT Size) override
+        {
+            Record(NullCommandType::Marker);
+        }
+
+        void STDMETHODCALLTYPE EndEvent() override
+        {
+            Record(NullCommandType::Marker);
+        }
+
+        void STDMETHODCALLTYPE ExecuteIndirect(
+            ID3D12CommandSignature* pCommandSignature,
+            UINT MaxCommandCount,
+            ID3D12Resource* pArgumentBuffer,
+            UINT64 ArgumentBufferOffset,
+            ID3D12Resource* pCountBuffer,
+            UINT64 CountBufferOffset) override
+        {
+            Record(NullCommandType::ExecuteIndirect, MaxCommandCount);
+        }
+
+    private:
+        void Record(NullCommandType type, UINT count = 1)
+        {
+            assert(m_IsRecording && "Command recorded into a closed command list");
+            m_Allocator->GetCommands().push_back({type, count});
+        }
+
+        D3D12_COMMAND_LIST_TYPE m_Type;
+        ComPtr<NullCommandAllocator> m_Allocator;
+        size_t m_Begin = 0;
+        size_t m_End = 0;
+        bool m_IsRecording = false;
+    };
+
+    class NullCommandQueue : public NullDeviceChild<ID3D12CommandQueue, ID3D12Pageable>
+    {
+    public:
+        NullCommandQueue(NullDevice* device, const D3D12_COMMAND_QUEUE_DESC& desc) : NullDeviceChild(device), m_Desc(desc)
+        {
+            if(m_Device->GetGpuLatency().count() > 0)
+            {
+                m_Thread = std::thread(&NullCommandQueue::Run, this);
+            }
+        }
+
+        ~NullCommandQueue() override
+        {
+            if(m_Thread.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    m_Stop = true;
+                }
+                m_Condition.notify_all();
+                m_Thread.join();
+            }
+        }
+
+        void STDMETHODCALLTYPE UpdateTileMappings(
+            ID3D12Resource* pResource,
+            UINT NumResourceRegions,
+            const D3D12_TILED_RESOURCE_COORDINATE* pResourceRegionStartCoordinates,
+            const D3D12_TILE_REGION_SIZE* pResourceRegionSizes,
+            ID3D12Heap* pHeap,
+            UINT NumRanges,
+            const D3D12_TILE_RANGE_FLAGS* pRangeFlags,
+            const UINT* pHeapRangeStartOffsets,
+            const UINT* pRangeTileCounts,
+            D3D12_TILE_MAPPING_FLAGS Flags) override
+        {
+        }
+
+        void STDMETHODCALLTYPE CopyTileMappings(
+            ID3D12Resource* pDstResource,
+            const D3D12_TILED_RESOURCE_COORDINATE* pDstRegionStartCoordinate,
+            ID3D12Resource* pSrcResource,
+            const D3D12_TILED_RESOURCE_COORDINATE* pSrcRegionStartCoordinate,
+            const D3D12_TILE_REGION_SIZE* pRegionSize,
+            D3D12_TILE_MAPPING_FLAGS Flags) override
+        {
+        }
+
+        void STDMETHODCALLTYPE ExecuteCommandLists(UINT NumCommandLists, ID3D12CommandList* const* ppCommandLists) override
+        {
+            for (UINT i = 0; i < NumCommandLists; ++i)
+            {
+                auto list = static_cast<NullGraphicsCommandList*>(static_cast<ID3D12GraphicsCommandList*>(ppCommandLists[i]));
+                assert(!list->IsRecording() && "Executed a command list that was not closed");
+
+                size_t count = 0;
+                const NullCommand* commands = list->GetCommands(&count);
+                m_Device->CountCommands(commands, count);
+            }
+
+            Enqueue({NullQueueOperationType::Execute, nullptr, 0});
+        }
+
+        void STDMETHODCALLTYPE SetMarker(UINT Metadata, const void* pData, UINT Size) override
+        {
+        }
+
+        void STDMETHODCALLTYPE BeginEvent(UINT Metadata, const void* pData, UINT Size) override
+        {
+        }
+
+        void STDMETHODCALLTYPE EndEvent() override
+        {
+        }
+
+        HRESULT STDMETHODCALLTYPE Signal(ID3D12Fence* pFence, UINT64 Value) override
+        {
+            Enqueue({NullQueueOperationType::Signal, static_cast<NullFence*>(pFence), Value});
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE Wait(ID3D12Fence* pFence, UINT64 Value) override
+        {
+            Enqueue({NullQueueOperationType::Wait, static_cast<NullFence*>(pFence), Value});
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetTimestampFrequency(UINT64* pFrequency) override
+        {
+            *pFrequency = 1000000000ull;
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetClockCalibration(UINT64* pGpuTimestamp, UINT64* pCpuTimestamp) override
+        {
+            auto now = std::chrono::steady_clock::now().time_since_epoch();
+            *pGpuTimestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+            *pCpuTimestamp = *pGpuTimestamp;
+
+            return S_OK;
+        }
+
+        D3D12_COMMAND_QUEUE_DESC STDMETHODCALLTYPE GetDesc() override
+        {
+            return m_Desc;
+        }
+
+    private:
+        void Enqueue(NullQueueOperation operation)
+        {
+            // Without simulated latency the GPU is infinitely fast: work completes as it is submitted,
+            // and cross-queue waits are already satisfied.
+            if(!m_Thread.joinable())
+            {
+                if(operation.Type == NullQueueOperationType::Signal)
+                {
+                    operation.Fence->Signal(operation.Value);
+                }
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Operations.push_back(std::move(operation));
+            }
+            m_Condition.notify_one();
+        }
+
+        void Run()
+        {
+            while (true)
+            {
+                NullQueueOperation operation;
+                {
+                    std::unique_lock<std::mutex> lock(m_Mutex);
+                    m_Condition.wait(lock, [this] { return m_Stop || !m_Operations.empty(); });
+                    if(m_Stop)
+                    {
+                        return;
+                    }
+
+                    operation = std::move(m_Operations.front());
+                    m_Operations.pop_front();
+                }
+
+                switch (operation.Type)
+                {
+                case NullQueueOperationType::Execute:
+                    std::this_thread::sleep_for(m_Device->GetGpuLatency());
+                    break;
+                case NullQueueOperationType::Signal:
+                    operation.Fence->Signal(operation.Value);
+                    break;
+                case NullQueueOperationType::Wait:
+                    operation.Fence->SetEventOnCompletion(operation.Value, nullptr);
+                    break;
+                }
+            }
+        }
+
+        D3D12_COMMAND_QUEUE_DESC m_Desc;
+        std::thread m_Thread;
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        std::deque<NullQueueOperation> m_Operations;
+        bool m_Stop = false;
+    };
+
+    class NullSwapChain : public Microsoft::WRL::Base<IDXGISwapChain4>
+    {
+    public:
+        NullSwapChain(NullDevice* device, const DXGI_SWAP_CHAIN_DESC1& desc) : m_Device(device), m_Desc(desc)
+        {
+            m_VBlankEpoch = std::chrono::steady_clock::now();
+            CreateBuffers();
+
+            if(m_Desc.Flags & DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT)
+            {
+                // Waitable swap chains start with a maximum latency of one frame.
+                m_MaximumFrameLatency = 1;
+                m_FrameLatencyWaitable = ::CreateSemaphore(nullptr, 1, g_NullMaximumFrameLatency, nullptr);
+            }
+        }
+
+        ~NullSwapChain()
+        {
+            if(m_FrameLatencyWaitable)
+            {
+                ::CloseHandle(m_FrameLatencyWaitable);
+            }
+        }
+
+        HRESULT STDMETHODCALLTYPE Present(UINT SyncInterval, UINT Flags) override
+        {
+            auto now = std::chrono::steady_clock::now();
+            auto refreshCount = (now - m_VBlankEpoch) / g_NullRefreshPeriod;
+            if(SyncInterval > 0)
+            {
+                // Block until the next simulated vertical blank, as a vsynced flip would.
+                refreshCount += SyncInterval;
+                std::this_thread::sleep_until(m_VBlankEpoch + refreshCount * g_NullRefreshPeriod);
+            }
+
+            // Nothing is queued for display, so the frame counts as shown as soon as Present returns
+            // and its slot in the latency queue is released straight away.
+            ++m_PresentCount;
+            m_LastSyncRefreshCount = static_cast<UINT>(refreshCount);
+            ::QueryPerformanceCounter(&m_LastSyncTime);
+            if(m_FrameLatencyWaitable)
+            {
+                ::ReleaseSemaphore(m_FrameLatencyWaitable, 1, nullptr);
+            }
+
+            m_CurrentBackBufferIndex = (m_CurrentBackBufferIndex + 1) % m_Desc.BufferCount;
+            m_Device->CountPresent();
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetBuffer(UINT Buffer, REFIID riid, void** ppSurface) override
+        {
+            if(Buffer >= m_Buffers.size())
+            {
+                return DXGI_ERROR_INVALID_CALL;
+            }
+
+            return m_Buffers[Buffer]->QueryInterface(riid, ppSurface);
+        }
+
+        HRESULT STDMETHODCALLTYPE GetDesc(DXGI_SWAP_CHAIN_DESC* pDesc) override
+        {
+            *pDesc = {};
+            pDesc->BufferDesc.Width = m_Desc.Width;
+            pDesc->BufferDesc.Height = m_Desc.Height;
+            pDesc->BufferDesc.RefreshRate = {1000000, static_cast<UINT>(g_NullRefreshPeriod.count())};
+            pDesc->BufferDesc.Format = m_Desc.Format;
+            pDesc->SampleDesc = m_Desc.SampleDesc;
+            pDesc->BufferUsage = m_Desc.BufferUsage;
+            pDesc->BufferCount = m_Desc.BufferCount;
+            pDesc->Windowed = TRUE;
+            pDesc->SwapEffect = m_Desc.SwapEffect;
+            pDesc->Flags = m_Desc.Flags;
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE ResizeBuffers(UINT BufferCount, UINT Width, UINT Height, DXGI_FORMAT NewFormat, UINT SwapChainFlags) override
+        {
+            // Like DXGI, refuse while the application still holds references to the old buffers.
+            for (auto& buffer : m_Buffers)
+            {
+                buffer->AddRef();
+                if(buffer->Release() > 1)
+                {
+                    return DXGI_ERROR_INVALID_CALL;
+                }
+            }
+
+            m_Desc.BufferCount = BufferCount ? BufferCount : m_Desc.BufferCount;
+            m_Desc.Width = Width;
+            m_Desc.Height = Height;
+            m_Desc.Format = NewFormat != DXGI_FORMAT_UNKNOWN ? NewFormat : m_Desc.Format;
+            m_Desc.Flags = SwapChainFlags;
+            CreateBuffers();
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetFrameStatistics(DXGI_FRAME_STATISTICS* pStats) override
+        {
+            if(m_PresentCount == 0)
+            {
+                return DXGI_ERROR_FRAME_STATISTICS_DISJOINT;
+            }
+
+            pStats->PresentCount = m_PresentCount;
+            pStats->PresentRefreshCount = m_LastSyncRefreshCount;
+            pStats->SyncRefreshCount = m_LastSyncRefreshCount;
+            pStats->SyncQPCTime = m_LastSyncTime;
+            pStats->SyncGPUTime = {};
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetLastPresentCount(UINT* pLastPresentCount) override
+        {
+            *pLastPresentCount = m_PresentCount;
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetMaximumFrameLatency(UINT MaxLatency) override
+        {
+            if(!m_FrameLatencyWaitable || MaxLatency == 0 || MaxLatency > g_NullMaximumFrameLatency)
+            {
+                return DXGI_ERROR_INVALID_CALL;
+            }
+
+            if(MaxLatency > m_MaximumFrameLatency)
+            {
+                ::ReleaseSemaphore(m_FrameLatencyWaitable, MaxLatency - m_MaximumFrameLatency, nullptr);
+            }
+            m_MaximumFrameLatency = MaxLatency;
+
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetMaximumFrameLatency(UINT* pMaxLatency) override
+        {
+            if(!m_FrameLatencyWaitable)
+            {
+                return DXGI_ERROR_INVALID_CALL;
+            }
+
+            *pMaxLatency = m_MaximumFrameLatency;
+
+            return S_OK;
+        }
+
+        HANDLE STDMETHODCALLTYPE GetFrameLatencyWaitableObject() override
+        {
+            HANDLE waitable = nullptr;
+            if(m_FrameLatencyWaitable)
+            {
+                ::DuplicateHandle(::GetCurrentProcess(), m_FrameLatencyWaitable, ::GetCurrentProcess(), &waitable, 0, FALSE, DUPLICATE_SAME_ACCESS);
+            }
+
+            return waitable;
+        }
+
+        UINT STDMETHODCALLTYPE GetCurrentBackBufferIndex() override
+        {
+            return m_CurrentBackBufferIndex;
+        }
+
+    private:
+        void CreateBuffers()
+        {
+            D3D12_HEAP_PROPERTIES heapProperties = {};
+            heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+            D3D12_RESOURCE_DESC desc = {};
+            desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+            desc.Width = m_Desc.Width;
+            desc.Height = m_Desc.Height;
+            desc.DepthOrArraySize = 1;
+            desc.MipLevels = 1;
+            desc.Format = m_Desc.Format;
+            desc.SampleDesc = m_Desc.SampleDesc;
+            desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+
+            m_Buffers.clear();
+            for (UINT i = 0; i < m_Desc.BufferCount; ++i)
+            {
+                m_Buffers.push_back(Microsoft::WRL::Make<NullResource>(m_Device.Get(), heapProperties, D3D12_HEAP_FLAG_NONE, desc));
+            }
+
+            m_CurrentBackBufferIndex = 0;
+        }
+
+        ComPtr<NullDevice> m_Device;
+        DXGI_SWAP_CHAIN_DESC1 m_Desc;
+        std::vector<ComPtr<NullResource>> m_Buffers;
+        UINT m_CurrentBackBufferIndex = 0;
+        std::chrono::steady_clock::time_point m_VBlankEpoch;
+
+        UINT m_PresentCount = 0;
+        UINT m_LastSyncRefreshCount = 0;
+        LARGE_INTEGER m_LastSyncTime = {};
+
+        HANDLE m_FrameLatencyWaitable = nullptr;
+        UINT m_MaximumFrameLatency = 3;
+    };
+
+    HRESULT NullDevice::CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* pDesc, REFIID riid, void** ppCommandQueue)
+    {
+        return Microsoft::WRL::Make<NullCommandQueue>(this, *pDesc)->QueryInterface(riid, ppCommandQueue);
+    }
+
+    HRESULT NullDevice::CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** ppCommandAllocator)
+    {
+        return Microsoft::WRL::Make<NullCommandAllocator>(this, type)->QueryInterface(riid, ppCommandAllocator);
+    }
+
+    HRESULT NullDevice::CreateCommandList(
+        UINT nodeMask,
+        D3D12_COMMAND_LIST_TYPE type,
+        ID3D12CommandAllocator* pCommandAllocator,
+        ID3D12PipelineState* pInitialState,
+        REFIID riid,
+        void** ppCommandList)
+    {
+        auto commandList = Microsoft::WRL::Make<NullGraphicsCommandList>(this, type);
+
+        HRESULT hr = commandList->Begin(pCommandAllocator);
+        if(FAILED(hr))
+        {
+            return hr;
+        }
+
+        return commandList->QueryInterface(riid, ppCommandList);
+    }
+
+    HRESULT NullDevice::CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDescriptorHeapDesc, REFIID riid, void** ppvHeap)
+    {
+        return Microsoft::WRL::Make<NullDescriptorHeap>(this, *pDescriptorHeapDesc)->QueryInterface(riid, ppvHeap);
+    }
+
+    HRESULT NullDevice::CreateCommittedResource(
+        const D3D12_HEAP_PROPERTIES* pHeapProperties,
+        D3D12_HEAP_FLAGS HeapFlags,
+        const D3D12_RESOURCE_DESC* pDesc,
+        D3D12_RESOURCE_STATES InitialResourceState,
+        const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+        REFIID riidResource,
+        void** ppvResource)
+    {
+        auto resource = Microsoft::WRL::Make<NullResource>(this, *pHeapProperties, HeapFlags, *pDesc);
+
+        return ppvResource ? resource->QueryInterface(riidResource, ppvResource) : S_FALSE;
+    }
+
+    HRESULT NullDevice::CreateHeap(const D3D12_HEAP_DESC* pDesc, REFIID riid, void** ppvHeap)
+    {
+        auto heap = Microsoft::WRL::Make<NullHeap>(this, *pDesc);
+
+        return ppvHeap ? heap->QueryInterface(riid, ppvHeap) : S_FALSE;
+    }
+
+    HRESULT NullDevice::CreatePlacedResource(
+        ID3D12Heap* pHeap,
+        UINT64 HeapOffset,
+        const D3D12_RESOURCE_DESC* pDesc,
+        D3D12_RESOURCE_STATES InitialState,
+        const D3D12_CLEAR_VALUE* pOptimizedClearValue,
+        REFIID riid,
+        void** ppvResource)
+    {
+        auto heap = static_cast<NullHeap*>(pHeap);
+        if(HeapOffset + GetResourceAllocationInfo(0, 1, pDesc).SizeInBytes > heap->GetDesc().SizeInBytes)
+        {
+            return E_INVALIDARG;
+        }
+
+        auto resource = Microsoft::WRL::Make<NullResource>(this, heap, HeapOffset, *pDesc);
+
+        return ppvResource ? resource->QueryInterface(riid, ppvResource) : S_FALSE;
+    }
+
+    HRESULT NullDevice::CreateFence(UINT64 InitialValue, D3D12_FENCE_FLAGS Flags, REFIID riid, void** ppFence)
+    {
+        return Microsoft::WRL::Make<NullFence>(this, InitialValue)->QueryInterface(riid, ppFence);
+    }
+
+    HRESULT NullDevice::CreateRootSignature(
+        UINT nodeMask,
+        const void* pBlobWithRootSignature,
+        SIZE_T blobLengthInBytes,
+        REFIID riid,
+        void** ppvRootSignature)
+    {
+        if(!pBlobWithRootSignature || blobLengthInBytes == 0)
+        {
+            return E_INVALIDARG;
+        }
+
+        return Microsoft::WRL::Make<NullRootSignature>(this)->QueryInterface(riid, ppvRootSignature);
+    }
+
+    HRESULT NullDevice::CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc, REFIID riid, void** ppPipelineState)
+    {
+        if(!pDesc->pRootSignature || !pDesc->VS.pShaderBytecode)
+        {
+            return E_INVALIDARG;
+        }
+
+        CompilePipeline();
+
+        auto pipelineState = Microsoft::WRL::Make<NullPipelineState>(this, std::initializer_list<D3D12_SHADER_BYTECODE>{pDesc->VS, pDesc->PS, pDesc->DS, pDesc->HS, pDesc->GS});
+
+        return pipelineState->QueryInterface(riid, ppPipelineState);
+    }
+
+    HRESULT NullDevice::CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* pDesc, REFIID riid, void** ppPipelineState)
+    {
+        if(!pDesc->pRootSignature || !pDesc->CS.pShaderBytecode)
+        {
+            return E_INVALIDARG;
+        }
+
+        CompilePipeline();
+
+        auto pipelineState = Microsoft::WRL::Make<NullPipelineState>(this, std::initializer_list<D3D12_SHADER_BYTECODE>{pDesc->CS});
+
+        return pipelineState->QueryInterface(riid, ppPipelineState);
+    }
+
+    HRESULT NullDevice::CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc, REFIID riid, void** ppPipelineState)
+    {
+        NullPipelineStream stream;
+        if(FAILED(D3DX12ParsePipelineStream(*pDesc, &stream)) || !stream.IsValid())
+        {
+            return E_INVALIDARG;
+        }
+
+        CompilePipeline();
+
+        auto pipelineState = Microsoft::WRL::Make<NullPipelineState>(this, stream.GetShaders());
+
+        return pipelineState->QueryInterface(riid, ppPipelineState);
+    }
+
+    HRESULT NullDevice::CreatePipelineLibrary(const void* pLibraryBlob, SIZE_T BlobLength, REFIID riid, void** ppPipelineLibrary)
+    {
+        auto pipelineLibrary = Microsoft::WRL::Make<NullPipelineLibrary>(this);
+        if(BlobLength > 0)
+        {
+            HRESULT hr = pipelineLibrary->Deserialize(pLibraryBlob, BlobLength);
+            if(FAILED(hr))
+            {
+                return hr;
+            }
+        }
+
+        return pipelineLibrary->QueryInterface(riid, ppPipelineLibrary);
+    }
+}
+
+HRESULT WINAPI D3D12SerializeRootSignature(
+    const D3D12_ROOT_SIGNATURE_DESC* pRootSignature,
+    D3D_ROOT_SIGNATURE_VERSION Version,
+    ID3DBlob** ppBlob,
+    ID3DBlob** ppErrorBlob)
+{
+    if(ppErrorBlob)
+    {
+        *ppErrorBlob = nullptr;
+    }
+
+    // The null device doesn't interpret root signatures; the blob only has to be non-empty.
+    const UINT header[] = {0x4E525330, pRootSignature->NumParameters, pRootSignature->NumStaticSamplers, static_cast<UINT>(pRootSignature->Flags)};
+    *ppBlob = Microsoft::WRL::Make<NullBlob>(header, sizeof(header)).Detach();
+
+    return S_OK;
+}
+
+HRESULT WINAPI D3DCompile(
+    LPCVOID pSrcData,
+    SIZE_T SrcDataSize,
+    LPCSTR pSourceName,
+    const D3D_SHADER_MACRO* pDefines,
+    ID3DInclude* pInclude,
+    LPCSTR pEntrypoint,
+    LPCSTR pTarget,
+    UINT Flags1,
+    UINT Flags2,
+    ID3DBlob** ppCode,
+    ID3DBlob** ppErrorMsgs)
+{
+    if(ppErrorMsgs)
+    {
+        *ppErrorMsgs = nullptr;
+    }
+
+    std::string bytecode(static_cast<const char*>(pSrcData), SrcDataSize);
+    bytecode += '\0';
+    bytecode += pEntrypoint;
+    bytecode += '\0';
+    bytecode += pTarget;
+    *ppCode = Microsoft::WRL::Make<NullBlob>(bytecode.data(), bytecode.size()).Detach();
+
+    return S_OK;
+}
+
+ComPtr<ID3D12Device2> CreateNullDevice(std::chrono::microseconds gpuLatency, std::chrono::microseconds pipelineLatency)
+{
+    return Microsoft::WRL::Make<NullDevice>(gpuLatency, pipelineLatency);
+}
+
+ComPtr<IDXGISwapChain4> CreateNullSwapChain(const ComPtr<ID3D12CommandQueue>& commandQueue, const DXGI_SWAP_CHAIN_DESC1& desc)
+{
+    ComPtr<ID3D12Device2> device;
+    ThrowIfFailed(commandQueue->GetDevice(IID_PPV_ARGS(&device)));
+
+    return Microsoft::WRL::Make<NullSwapChain>(static_cast<NullDevice*>(device.Get()), desc);
+}
+
+NullDeviceStatistics GetNullDeviceStatistics(const ComPtr<ID3D12Device2>& device)
+{
+    return static_cast<NullDevice*>(device.Get())->GetStatistics();
+}
+
+void RemoveNullDevice(const ComPtr<ID3D12Device2>& device)
+{
+    static_cast<NullDevice*>(device.Get())->Remove();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "NullPlatform.h"
+#include "directXHeaders/directx/d3dx12.h"
+#include "directXHeaders/dxguids/dxguids.h"
+
+WINADAPTER_IID(ID3D10Blob, 0x8ba5fb08, 0x5195, 0x40e2, 0xac, 0x58, 0x0d, 0x98, 0x9c, 0x3a, 0x01, 0x02);
+
+#include <chrono>
+#include <cstdint>
+
+// Software implementation of the D3D12 objects the frame loop uses. Command lists only record,
+// queues complete fences instantly or after gpuLatency per ExecuteCommandLists call, and the swap
+// chain flips between buffers without displaying anything. Creating a pipeline state takes
+// pipelineLatency, as if a driver compiled it; loading one from a pipeline library doesn't.
+
+struct NullDeviceStatistics
+{
+    uint64_t CommandListsExecuted;
+    uint64_t CommandsExecuted;
+    uint64_t DrawsExecuted;
+    uint64_t BarriersExecuted;
+    uint64_t FencesSignaled;
+    uint64_t Presents;
+};
+
+Microsoft::WRL::ComPtr<ID3D12Device2> CreateNullDevice(
+    std::chrono::microseconds gpuLatency,
+    std::chrono::microseconds pipelineLatency = std::chrono::microseconds(0));
+
+Microsoft::WRL::ComPtr<IDXGISwapChain4> CreateNullSwapChain(
+    const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue,
+    const DXGI_SWAP_CHAIN_DESC1& desc);
+
+NullDeviceStatistics GetNullDeviceStatistics(const Microsoft::WRL::ComPtr<ID3D12Device2>& device);
+
+// Acts as if the device was lost, for testing what callers do then: GetDeviceRemovedReason and Map
+// return DXGI_ERROR_DEVICE_REMOVED from now on. Nothing else changes.
+void RemoveNullDevice(const Microsoft::WRL::ComPtr<ID3D12Device2>& device);
+
+#define D3DCOMPILE_OPTIMIZATION_LEVEL3 (1 << 15)
+
+// Stands in for the d3dcompiler entry point. The null device never runs shaders, so the "bytecode" is
+// the source followed by the entry point and target, which still changes whenever any of them does.
+HRESULT WINAPI D3DCompile(
+    LPCVOID pSrcData,
+    SIZE_T SrcDataSize,
+    LPCSTR pSourceName,
+    const D3D_SHADER_MACRO* pDefines,
+    ID3DInclude* pInclude,
+    LPCSTR pEntrypoint,
+    LPCSTR pTarget,
+    UINT Flags1,
+    UINT Flags2,
+    ID3DBlob** ppCode,
+    ID3DBlob** ppErrorMsgs);
@@ -0,0 +1,213 @@
+#include "NullPlatform.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Backs both events and semaphores: an event is a semaphore with a maximum count of one, and a
+// manual-reset event keeps its count when a wait is satisfied.
+struct NullEvent
+{
+    std::mutex Mutex;
+    std::condition_variable Condition;
+    bool ManualReset;
+    LONG Count;
+    LONG MaximumCount;
+    std::atomic<int> References;
+};
+
+std::vector<std::wstring> g_CommandLineArguments;
+std::wstring g_CommandLine;
+
+HANDLE CreateEvent(SECURITY_ATTRIBUTES* attributes, BOOL manualReset, BOOL initialState, LPCSTR name)
+{
+    NullEvent* event = new NullEvent();
+    event->ManualReset = manualReset != FALSE;
+    event->Count = initialState != FALSE ? 1 : 0;
+    event->MaximumCount = 1;
+    event->References = 1;
+
+    return event;
+}
+
+HANDLE CreateSemaphore(SECURITY_ATTRIBUTES* attributes, LONG initialCount, LONG maximumCount, LPCSTR name)
+{
+    NullEvent* semaphore = new NullEvent();
+    semaphore->ManualReset = false;
+    semaphore->Count = initialCount;
+    semaphore->MaximumCount = maximumCount;
+    semaphore->References = 1;
+
+    return semaphore;
+}
+
+BOOL SetEvent(HANDLE handle)
+{
+    NullEvent* event = static_cast<NullEvent*>(handle);
+    if(!event)
+    {
+        return FALSE;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(event->Mutex);
+        event->Count = 1;
+    }
+    event->Condition.notify_all();
+
+    return TRUE;
+}
+
+BOOL ReleaseSemaphore(HANDLE handle, LONG releaseCount, LONG* previousCount)
+{
+    NullEvent* semaphore = static_cast<NullEvent*>(handle);
+    if(!semaphore)
+    {
+        return FALSE;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(semaphore->Mutex);
+        if(releaseCount <= 0 || semaphore->Count + releaseCount > semaphore->MaximumCount)
+        {
+            return FALSE;
+        }
+
+        if(previousCount)
+        {
+            *previousCount = semaphore->Count;
+        }
+        semaphore->Count += releaseCount;
+    }
+    semaphore->Condition.notify_all();
+
+    return TRUE;
+}
+
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds)
+{
+    NullEvent* event = static_cast<NullEvent*>(handle);
+
+    std::unique_lock<std::mutex> lock(event->Mutex);
+    if(milliseconds == INFINITE)
+    {
+        event->Condition.wait(lock, [event] { return event->Count > 0; });
+    }
+    else if(!event->Condition.wait_for(lock, std::chrono::milliseconds(milliseconds), [event] { return event->Count > 0; }))
+    {
+        return WAIT_TIMEOUT;
+    }
+
+    if(!event->ManualReset)
+    {
+        --event->Count;
+    }
+
+    return WAIT_OBJECT_0;
+}
+
+BOOL CloseHandle(HANDLE handle)
+{
+    NullEvent* event = static_cast<NullEvent*>(handle);
+    if(event && --event->References == 0)
+    {
+        delete event;
+    }
+
+    return TRUE;
+}
+
+HANDLE GetCurrentProcess()
+{
+    return reinterpret_cast<HANDLE>(-1);
+}
+
+BOOL DuplicateHandle(
+    HANDLE sourceProcess,
+    HANDLE sourceHandle,
+    HANDLE targetProcess,
+    HANDLE* targetHandle,
+    DWORD desiredAccess,
+    BOOL inheritHandle,
+    DWORD options)
+{
+    // Only same-process duplication exists here, so the duplicate is the same object with one more reference.
+    NullEvent* event = static_cast<NullEvent*>(sourceHandle);
+    if(!event)
+    {
+        return FALSE;
+    }
+
+    ++event->References;
+    *targetHandle = event;
+
+    return TRUE;
+}
+
+BOOL QueryPerformanceCounter(LARGE_INTEGER* performanceCount)
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    performanceCount->QuadPart = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+
+    return TRUE;
+}
+
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency)
+{
+    frequency->QuadPart = 1000000000;
+
+    return TRUE;
+}
+
+void SetCommandLineArguments(int argc, char** argv)
+{
+    g_CommandLineArguments.clear();
+    g_CommandLine.clear();
+
+    for (int i = 0; i < argc; ++i)
+    {
+        std::wstring argument(argv[i], argv[i] + strlen(argv[i]));
+        g_CommandLine += (i == 0 ? L"" : L" ") + argument;
+        g_CommandLineArguments.push_back(argument);
+    }
+}
+
+LPWSTR GetCommandLineW()
+{
+    return &g_CommandLine[0];
+}
+
+LPWSTR* CommandLineToArgvW(LPCWSTR commandLine, int* numArgs)
+{
+    // Hands back the arguments given to SetCommandLineArguments in a single block, so LocalFree can release it.
+    size_t size = g_CommandLineArguments.size() * sizeof(LPWSTR);
+    for (const std::wstring& argument : g_CommandLineArguments)
+    {
+        size += (argument.size() + 1) * sizeof(wchar_t);
+    }
+
+    LPWSTR* argv = static_cast<LPWSTR*>(malloc(size));
+    wchar_t* strings = reinterpret_cast<wchar_t*>(argv + g_CommandLineArguments.size());
+    for (size_t i = 0; i < g_CommandLineArguments.size(); ++i)
+    {
+        const std::wstring& argument = g_CommandLineArguments[i];
+        wmemcpy(strings, argument.c_str(), argument.size() + 1);
+        argv[i] = strings;
+        strings += argument.size() + 1;
+    }
+
+    *numArgs = static_cast<int>(g_CommandLineArguments.size());
+
+    return argv;
+}
+
+void* LocalFree(void* memory)
+{
+    free(memory);
+
+    return nullptr;
+}
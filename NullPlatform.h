@@ -0,0 +1,175 @@
+#pragma once
+
+// The subset of Win32 and DXGI that DX12Test.cpp uses, for builds without the Windows SDK.
+// Built on the vendored WSL adapter; on Linux:
+//   g++ -std=c++17 -pthread -IdirectXHeaders/wsl/stubs -IdirectXHeaders *.cpp
+
+#include "directXHeaders/wsl/winadapter.h"
+#include "directXHeaders/wsl/wrladapter.h"
+#include "directXHeaders/directx/dxgiformat.h"
+#include "directXHeaders/directx/dxgicommon.h"
+
+#include <cstdio>
+#include <cwchar>
+
+#define INFINITE 0xFFFFFFFF
+#define WAIT_OBJECT_0 0x00000000L
+#define WAIT_TIMEOUT 0x00000102L
+#define DUPLICATE_SAME_ACCESS 0x00000002
+
+#define sprintf_s snprintf
+
+HANDLE CreateEvent(SECURITY_ATTRIBUTES* attributes, BOOL manualReset, BOOL initialState, LPCSTR name);
+BOOL SetEvent(HANDLE event);
+HANDLE CreateSemaphore(SECURITY_ATTRIBUTES* attributes, LONG initialCount, LONG maximumCount, LPCSTR name);
+BOOL ReleaseSemaphore(HANDLE semaphore, LONG releaseCount, LONG* previousCount);
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds);
+BOOL CloseHandle(HANDLE handle);
+HANDLE GetCurrentProcess();
+BOOL DuplicateHandle(
+    HANDLE sourceProcess,
+    HANDLE sourceHandle,
+    HANDLE targetProcess,
+    HANDLE* targetHandle,
+    DWORD desiredAccess,
+    BOOL inheritHandle,
+    DWORD options);
+
+BOOL QueryPerformanceCounter(LARGE_INTEGER* performanceCount);
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency);
+
+void SetCommandLineArguments(int argc, char** argv);
+LPWSTR GetCommandLineW();
+LPWSTR* CommandLineToArgvW(LPCWSTR commandLine, int* numArgs);
+void* LocalFree(void* memory);
+
+typedef UINT DXGI_USAGE;
+#define DXGI_USAGE_RENDER_TARGET_OUTPUT 0x00000020UL
+
+#define DXGI_PRESENT_ALLOW_TEARING 0x00000200UL
+
+#define DXGI_ERROR_FRAME_STATISTICS_DISJOINT ((HRESULT)0x887A000BL)
+#define D3D12_ERROR_ADAPTER_NOT_FOUND ((HRESULT)0x887E0001L)
+#define D3D12_ERROR_DRIVER_VERSION_MISMATCH ((HRESULT)0x887E0002L)
+
+enum DXGI_FEATURE
+{
+    DXGI_FEATURE_PRESENT_ALLOW_TEARING = 0
+};
+
+enum DXGI_SWAP_EFFECT
+{
+    DXGI_SWAP_EFFECT_DISCARD = 0,
+    DXGI_SWAP_EFFECT_SEQUENTIAL = 1,
+    DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL = 3,
+    DXGI_SWAP_EFFECT_FLIP_DISCARD = 4
+};
+
+enum DXGI_SCALING
+{
+    DXGI_SCALING_STRETCH = 0,
+    DXGI_SCALING_NONE = 1,
+    DXGI_SCALING_ASPECT_RATIO_STRETCH = 2
+};
+
+enum DXGI_ALPHA_MODE
+{
+    DXGI_ALPHA_MODE_UNSPECIFIED = 0,
+    DXGI_ALPHA_MODE_PREMULTIPLIED = 1,
+    DXGI_ALPHA_MODE_STRAIGHT = 2,
+    DXGI_ALPHA_MODE_IGNORE = 3
+};
+
+enum DXGI_SWAP_CHAIN_FLAG
+{
+    DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH = 2,
+    DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT = 64,
+    DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING = 2048
+};
+
+enum DXGI_MODE_SCANLINE_ORDER
+{
+    DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED = 0
+};
+
+enum DXGI_MODE_SCALING
+{
+    DXGI_MODE_SCALING_UNSPECIFIED = 0
+};
+
+struct DXGI_MODE_DESC
+{
+    UINT Width;
+    UINT Height;
+    DXGI_RATIONAL RefreshRate;
+    DXGI_FORMAT Format;
+    DXGI_MODE_SCANLINE_ORDER ScanlineOrdering;
+    DXGI_MODE_SCALING Scaling;
+};
+
+struct DXGI_SWAP_CHAIN_DESC
+{
+    DXGI_MODE_DESC BufferDesc;
+    DXGI_SAMPLE_DESC SampleDesc;
+    DXGI_USAGE BufferUsage;
+    UINT BufferCount;
+    HWND OutputWindow;
+    BOOL Windowed;
+    DXGI_SWAP_EFFECT SwapEffect;
+    UINT Flags;
+};
+
+struct DXGI_FRAME_STATISTICS
+{
+    UINT PresentCount;
+    UINT PresentRefreshCount;
+    UINT SyncRefreshCount;
+    LARGE_INTEGER SyncQPCTime;
+    LARGE_INTEGER SyncGPUTime;
+};
+
+struct DXGI_SWAP_CHAIN_DESC1
+{
+    UINT Width;
+    UINT Height;
+    DXGI_FORMAT Format;
+    BOOL Stereo;
+    DXGI_SAMPLE_DESC SampleDesc;
+    DXGI_USAGE BufferUsage;
+    UINT BufferCount;
+    DXGI_SCALING Scaling;
+    DXGI_SWAP_EFFECT SwapEffect;
+    DXGI_ALPHA_MODE AlphaMode;
+    UINT Flags;
+};
+
+MIDL_INTERFACE("3D585D5A-BD4A-489E-B1F4-3315FC05F1C9")
+IDXGISwapChain4 : public IUnknown
+{
+public:
+    virtual HRESULT STDMETHODCALLTYPE Present(UINT SyncInterval, UINT Flags) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE GetBuffer(UINT Buffer, REFIID riid, void** ppSurface) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE GetDesc(DXGI_SWAP_CHAIN_DESC* pDesc) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE ResizeBuffers(
+        UINT BufferCount,
+        UINT Width,
+        UINT Height,
+        DXGI_FORMAT NewFormat,
+        UINT SwapChainFlags) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE GetFrameStatistics(DXGI_FRAME_STATISTICS* pStats) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE GetLastPresentCount(UINT* pLastPresentCount) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE SetMaximumFrameLatency(UINT MaxLatency) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE GetMaximumFrameLatency(UINT* pMaxLatency) = 0;
+
+    virtual HANDLE STDMETHODCALLTYPE GetFrameLatencyWaitableObject() = 0;
+
+    virtual UINT STDMETHODCALLTYPE GetCurrentBackBufferIndex() = 0;
+};
+__CRT_UUID_DECL(IDXGISwapChain4, 0x3D585D5A, 0xBD4A, 0x489E, 0xB1, 0xF4, 0x33, 0x15, 0xFC, 0x05, 0xF1, 0xC9)
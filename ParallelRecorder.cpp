@@ -0,0 +1,74 @@
+#include "ParallelRecorder.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <algorithm>
+
+ParallelRecorder::ParallelRecorder(
+    const Microsoft::WRL::ComPtr<ID3D12Device2>& device,
+    CommandAllocatorPool& allocatorPool,
+    uint32_t threadCount)
+    : m_Device(device)
+    , m_AllocatorPool(allocatorPool)
+    , m_Workers(threadCount)
+    , m_CommandLists(m_Workers.GetThreadCount())
+    , m_Allocators(m_Workers.GetThreadCount())
+    , m_RecordedCount(0)
+{
+}
+
+uint32_t ParallelRecorder::GetThreadCount() const
+{
+    return m_Workers.GetThreadCount();
+}
+
+void ParallelRecorder::Record(uint32_t count, const RecordFunction& record)
+{
+    // No more ranges than items, and sizes differing by at most one, so no range is ever empty and no
+    // empty list gets recorded or submitted.
+    uint32_t rangeCount = std::min(count, GetThreadCount());
+
+    m_Workers.ParallelFor(rangeCount, [&](uint32_t range)
+    {
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator>& allocator = m_Allocators[range];
+        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList = m_CommandLists[range];
+
+        allocator = m_AllocatorPool.Acquire(D3D12_COMMAND_LIST_TYPE_DIRECT);
+        if(commandList)
+        {
+            ThrowIfFailed(commandList->Reset(allocator.Get(), nullptr));
+        }
+        else
+        {
+            ThrowIfFailed(m_Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&commandList)));
+        }
+
+        uint32_t begin = static_cast<uint32_t>(uint64_t(range) * count / rangeCount);
+        uint32_t end = static_cast<uint32_t>(uint64_t(range + 1) * count / rangeCount);
+        record(commandList.Get(), begin, end);
+
+        ThrowIfFailed(commandList->Close());
+    });
+
+    m_RecordedCount = rangeCount;
+}
+
+void ParallelRecorder::GetCommandLists(std::vector<ID3D12CommandList*>& commandLists) const
+{
+    for (uint32_t i = 0; i < m_RecordedCount; ++i)
+    {
+        commandLists.push_back(m_CommandLists[i].Get());
+    }
+}
+
+void ParallelRecorder::Release(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue)
+{
+    for (uint32_t i = 0; i < m_RecordedCount; ++i)
+    {
+        m_AllocatorPool.Release(D3D12_COMMAND_LIST_TYPE_DIRECT, std::move(m_Allocators[i]), fence, fenceValue);
+    }
+
+    m_RecordedCount = 0;
+}
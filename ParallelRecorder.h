@@ -0,0 +1,42 @@
+#pragma once
+
+#include "CommandAllocatorPool.h"
+#include "WorkerPool.h"
+
+#include <functional>
+#include <vector>
+
+// Records one range of a frame's work per thread, each into its own command list and allocator.
+// The lists keep the order of the ranges, so submitting them in one ExecuteCommandLists call
+// behaves as if everything had been recorded into a single list.
+class ParallelRecorder
+{
+public:
+    typedef std::function<void(ID3D12GraphicsCommandList* commandList, uint32_t begin, uint32_t end)> RecordFunction;
+
+    ParallelRecorder(
+        const Microsoft::WRL::ComPtr<ID3D12Device2>& device,
+        CommandAllocatorPool& allocatorPool,
+        uint32_t threadCount);
+
+    uint32_t GetThreadCount() const;
+
+    // Splits [0, count) into contiguous ranges and records them in parallel. The lists are closed when
+    // this returns.
+    void Record(uint32_t count, const RecordFunction& record);
+
+    // Appends the lists of the last Record, in range order.
+    void GetCommandLists(std::vector<ID3D12CommandList*>& commandLists) const;
+
+    // Hands the allocators of the last Record back to the pool once the GPU has passed fenceValue.
+    void Release(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue);
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    CommandAllocatorPool& m_AllocatorPool;
+    WorkerPool m_Workers;
+
+    std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>> m_CommandLists;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> m_Allocators;
+    uint32_t m_RecordedCount;
+};
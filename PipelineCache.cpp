@@ -0,0 +1,714 @@
+#include "PipelineCache.h"
+#include "HashHelpers.h"
+
+#if defined(_WIN32)
+#include <dxgi1_6.h>
+#else
+#include "directXHeaders/dxguids/dxguids.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cwchar>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+    constexpr uint32_t g_FileMagic = 0x43505844;
+    constexpr uint32_t g_FileVersion = 1;
+
+    // Tags root signatures from CreateRootSignature with the hash of their blob.
+    const GUID g_RootSignatureHashGuid = {0x6f0b5a1c, 0x3d2e, 0x4b87, {0x9a, 0x41, 0x0c, 0x5e, 0x7d, 0x92, 0xb3, 0x18}};
+
+    // The file starts with this, followed by EntryCount FileEntry and then LibrarySize bytes of library.
+    struct FileHeader
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t VendorId;
+        uint32_t DeviceId;
+        uint32_t SubSysId;
+        uint32_t Revision;
+        uint64_t DriverVersion;
+        uint32_t EntryCount;
+        uint32_t Reserved;
+        uint64_t LibrarySize;
+    };
+
+    struct FileEntry
+    {
+        uint64_t Hash;
+        uint64_t CompileMicroseconds;
+    };
+
+    // Hashes every subobject of a stream a field at a time, so the padding inside the descriptions
+    // never enters it. Each subobject starts with its type, so e.g. the same bytecode as VS and as PS
+    // hash differently. Cached blobs are left out; they don't change what the pipeline is.
+    class PipelineHasher : public ID3DX12PipelineParserCallbacks
+    {
+    public:
+        uint64_t GetHash() const
+        {
+            return m_Hash;
+        }
+
+        // False when the root signature has no hash to stand for it.
+        bool IsCacheable() const
+        {
+            return m_Cacheable;
+        }
+
+        void FlagsCb(D3D12_PIPELINE_STATE_FLAGS flags) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_FLAGS);
+            Add(flags);
+        }
+
+        void NodeMaskCb(UINT nodeMask) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_NODE_MASK);
+            Add(nodeMask);
+        }
+
+        void RootSignatureCb(ID3D12RootSignature* rootSignature) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE);
+
+            uint64_t hash = 0;
+            UINT size = sizeof(hash);
+            if(rootSignature &&
+                (FAILED(rootSignature->GetPrivateData(g_RootSignatureHashGuid, &size, &hash)) || size != sizeof(hash)))
+            {
+                m_Cacheable = false;
+            }
+            Add(hash);
+        }
+
+        void InputLayoutCb(const D3D12_INPUT_LAYOUT_DESC& inputLayout) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_INPUT_LAYOUT);
+            Add(inputLayout.NumElements);
+            for (UINT i = 0; i < inputLayout.NumElements; ++i)
+            {
+                const D3D12_INPUT_ELEMENT_DESC& element = inputLayout.pInputElementDescs[i];
+                AddString(element.SemanticName);
+                Add(element.SemanticIndex);
+                Add(element.Format);
+                Add(element.InputSlot);
+                Add(element.AlignedByteOffset);
+                Add(element.InputSlotClass);
+                Add(element.InstanceDataStepRate);
+            }
+        }
+
+        void IBStripCutValueCb(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE value) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_IB_STRIP_CUT_VALUE);
+            Add(value);
+        }
+
+        void PrimitiveTopologyTypeCb(D3D12_PRIMITIVE_TOPOLOGY_TYPE topologyType) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PRIMITIVE_TOPOLOGY);
+            Add(topologyType);
+        }
+
+        void VSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VS, shader);
+        }
+
+        void GSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_GS, shader);
+        }
+
+        void StreamOutputCb(const D3D12_STREAM_OUTPUT_DESC& streamOutput) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_STREAM_OUTPUT);
+            Add(streamOutput.NumEntries);
+            for (UINT i = 0; i < streamOutput.NumEntries; ++i)
+            {
+                const D3D12_SO_DECLARATION_ENTRY& entry = streamOutput.pSODeclaration[i];
+                Add(entry.Stream);
+                AddString(entry.SemanticName);
+                Add(entry.SemanticIndex);
+                Add(entry.StartComponent);
+                Add(entry.ComponentCount);
+                Add(entry.OutputSlot);
+            }
+            Add(streamOutput.NumStrides);
+            for (UINT i = 0; i < streamOutput.NumStrides; ++i)
+            {
+                Add(streamOutput.pBufferStrides[i]);
+            }
+            Add(streamOutput.RasterizedStream);
+        }
+
+        void HSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_HS, shader);
+        }
+
+        void DSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DS, shader);
+        }
+
+        void PSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS, shader);
+        }
+
+        void CSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_CS, shader);
+        }
+
+        void ASCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS, shader);
+        }
+
+        void MSCb(const D3D12_SHADER_BYTECODE& shader) override
+        {
+            AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS, shader);
+        }
+
+        void BlendStateCb(const D3D12_BLEND_DESC& blend) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND);
+            Add(blend.AlphaToCoverageEnable);
+            Add(blend.IndependentBlendEnable);
+            for (const D3D12_RENDER_TARGET_BLEND_DESC& renderTarget : blend.RenderTarget)
+            {
+                Add(renderTarget.BlendEnable);
+                Add(renderTarget.LogicOpEnable);
+                Add(renderTarget.SrcBlend);
+                Add(renderTarget.DestBlend);
+                Add(renderTarget.BlendOp);
+                Add(renderTarget.SrcBlendAlpha);
+                Add(renderTarget.DestBlendAlpha);
+                Add(renderTarget.BlendOpAlpha);
+                Add(renderTarget.LogicOp);
+                Add(renderTarget.RenderTargetWriteMask);
+            }
+        }
+
+        void DepthStencilStateCb(const D3D12_DEPTH_STENCIL_DESC& depthStencil) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL);
+            Add(depthStencil.DepthEnable);
+            Add(depthStencil.DepthWriteMask);
+            Add(depthStencil.DepthFunc);
+            Add(depthStencil.StencilEnable);
+            Add(depthStencil.StencilReadMask);
+            Add(depthStencil.StencilWriteMask);
+            AddStencilOp(depthStencil.FrontFace);
+            AddStencilOp(depthStencil.BackFace);
+        }
+
+        void DepthStencilState1Cb(const D3D12_DEPTH_STENCIL_DESC1& depthStencil) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL1);
+            Add(depthStencil.DepthEnable);
+            Add(depthStencil.DepthWriteMask);
+            Add(depthStencil.DepthFunc);
+            Add(depthStencil.StencilEnable);
+            Add(depthStencil.StencilReadMask);
+            Add(depthStencil.StencilWriteMask);
+            AddStencilOp(depthStencil.FrontFace);
+            AddStencilOp(depthStencil.BackFace);
+            Add(depthStencil.DepthBoundsTestEnable);
+        }
+
+#if defined(D3D12_SDK_VERSION) && (D3D12_SDK_VERSION >= 606)
+        void DepthStencilState2Cb(const D3D12_DEPTH_STENCIL_DESC2& depthStencil) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL2);
+            Add(depthStencil.DepthEnable);
+            Add(depthStencil.DepthWriteMask);
+            Add(depthStencil.DepthFunc);
+            Add(depthStencil.StencilEnable);
+            for (const D3D12_DEPTH_STENCILOP_DESC1* face : {&depthStencil.FrontFace, &depthStencil.BackFace})
+            {
+                Add(face->StencilFailOp);
+                Add(face->StencilDepthFailOp);
+                Add(face->StencilPassOp);
+                Add(face->StencilFunc);
+                Add(face->StencilReadMask);
+                Add(face->StencilWriteMask);
+            }
+            Add(depthStencil.DepthBoundsTestEnable);
+        }
+#endif
+
+        void DSVFormatCb(DXGI_FORMAT format) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT);
+            Add(format);
+        }
+
+        void RasterizerStateCb(const D3D12_RASTERIZER_DESC& rasterizer) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER);
+            Add(rasterizer.FillMode);
+            Add(rasterizer.CullMode);
+            Add(rasterizer.FrontCounterClockwise);
+            Add(rasterizer.DepthBias);
+            Add(rasterizer.DepthBiasClamp);
+            Add(rasterizer.SlopeScaledDepthBias);
+            Add(rasterizer.DepthClipEnable);
+            Add(rasterizer.MultisampleEnable);
+            Add(rasterizer.AntialiasedLineEnable);
+            Add(rasterizer.ForcedSampleCount);
+            Add(rasterizer.ConservativeRaster);
+        }
+
+#if defined(D3D12_SDK_VERSION) && (D3D12_SDK_VERSION >= 608)
+        void RasterizerState1Cb(const D3D12_RASTERIZER_DESC1& rasterizer) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER1);
+            Add(rasterizer.FillMode);
+            Add(rasterizer.CullMode);
+            Add(rasterizer.FrontCounterClockwise);
+            Add(rasterizer.DepthBias);
+            Add(rasterizer.DepthBiasClamp);
+            Add(rasterizer.SlopeScaledDepthBias);
+            Add(rasterizer.DepthClipEnable);
+            Add(rasterizer.MultisampleEnable);
+            Add(rasterizer.AntialiasedLineEnable);
+            Add(rasterizer.ForcedSampleCount);
+            Add(rasterizer.ConservativeRaster);
+        }
+#endif
+
+#if defined(D3D12_SDK_VERSION) && (D3D12_SDK_VERSION >= 610)
+        void RasterizerState2Cb(const D3D12_RASTERIZER_DESC2& rasterizer) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER2);
+            Add(rasterizer.FillMode);
+            Add(rasterizer.CullMode);
+            Add(rasterizer.FrontCounterClockwise);
+            Add(rasterizer.DepthBias);
+            Add(rasterizer.DepthBiasClamp);
+            Add(rasterizer.SlopeScaledDepthBias);
+            Add(rasterizer.DepthClipEnable);
+            Add(rasterizer.LineRasterizationMode);
+            Add(rasterizer.ForcedSampleCount);
+            Add(rasterizer.ConservativeRaster);
+        }
+#endif
+
+        void RTVFormatsCb(const D3D12_RT_FORMAT_ARRAY& formats) override
+        {
+            // Formats past NumRenderTargets are ignored by the driver, so they may hold anything.
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS);
+            Add(formats.NumRenderTargets);
+            for (UINT i = 0; i < std::min<UINT>(formats.NumRenderTargets, D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT); ++i)
+            {
+                Add(formats.RTFormats[i]);
+            }
+        }
+
+        void SampleDescCb(const DXGI_SAMPLE_DESC& sampleDesc) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC);
+            Add(sampleDesc.Count);
+            Add(sampleDesc.Quality);
+        }
+
+        void SampleMaskCb(UINT sampleMask) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK);
+            Add(sampleMask);
+        }
+
+        void ViewInstancingCb(const D3D12_VIEW_INSTANCING_DESC& viewInstancing) override
+        {
+            Add(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_VIEW_INSTANCING);
+            Add(viewInstancing.ViewInstanceCount);
+            for (UINT i = 0; i < viewInstancing.ViewInstanceCount; ++i)
+            {
+                Add(viewInstancing.pViewInstanceLocations[i].ViewportArrayIndex);
+                Add(viewInstancing.pViewInstanceLocations[i].RenderTargetArrayIndex);
+            }
+            Add(viewInstancing.Flags);
+        }
+
+    private:
+        // Only for scalars, which have no padding.
+        template<typename T>
+        void Add(T value)
+        {
+            Hash(m_Hash, &value, sizeof(value));
+        }
+
+        void AddString(LPCSTR string)
+        {
+            size_t length = string ? strlen(string) : 0;
+            Add(static_cast<uint64_t>(length));
+            Hash(m_Hash, string, length);
+        }
+
+        void AddShader(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type, const D3D12_SHADER_BYTECODE& shader)
+        {
+            size_t length = shader.pShaderBytecode ? shader.BytecodeLength : 0;
+            Add(type);
+            Add(static_cast<uint64_t>(length));
+            Hash(m_Hash, shader.pShaderBytecode, length);
+        }
+
+        void AddStencilOp(const D3D12_DEPTH_STENCILOP_DESC& stencilOp)
+        {
+            Add(stencilOp.StencilFailOp);
+            Add(stencilOp.StencilDepthFailOp);
+            Add(stencilOp.StencilPassOp);
+            Add(stencilOp.StencilFunc);
+        }
+
+        uint64_t m_Hash = g_FnvOffsetBasis;
+        bool m_Cacheable = true;
+    };
+
+    double ToMilliseconds(std::chrono::high_resolution_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+// The whole file, mapped read-only. Data is null when the file doesn't exist or is empty.
+class PipelineCache::FileMapping
+{
+public:
+    explicit FileMapping(const std::filesystem::path& path)
+        : m_Data(nullptr)
+        , m_Size(0)
+    {
+#if defined(_WIN32)
+        m_File = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        m_Mapping = nullptr;
+
+        LARGE_INTEGER size;
+        if(m_File == INVALID_HANDLE_VALUE || !::GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+        {
+            return;
+        }
+
+        m_Mapping = ::CreateFileMappingW(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(m_Mapping)
+        {
+            m_Data = static_cast<const uint8_t*>(::MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+            m_Size = m_Data ? static_cast<size_t>(size.QuadPart) : 0;
+        }
+#else
+        int file = ::open(path.c_str(), O_RDONLY);
+        if(file < 0)
+        {
+            return;
+        }
+
+        // The mapping keeps the file open by itself.
+        struct stat status;
+        if(::fstat(file, &status) == 0 && status.st_size > 0)
+        {
+            void* data = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            if(data != MAP_FAILED)
+            {
+                m_Data = static_cast<const uint8_t*>(data);
+                m_Size = static_cast<size_t>(status.st_size);
+            }
+        }
+        ::close(file);
+#endif
+    }
+
+    ~FileMapping()
+    {
+#if defined(_WIN32)
+        if(m_Data)
+        {
+            ::UnmapViewOfFile(m_Data);
+        }
+        if(m_Mapping)
+        {
+            ::CloseHandle(m_Mapping);
+        }
+        if(m_File != INVALID_HANDLE_VALUE)
+        {
+            ::CloseHandle(m_File);
+        }
+#else
+        if(m_Data)
+        {
+            ::munmap(const_cast<uint8_t*>(m_Data), m_Size);
+        }
+#endif
+    }
+
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+
+    const uint8_t* GetData() const
+    {
+        return m_Data;
+    }
+
+    size_t GetSize() const
+    {
+        return m_Size;
+    }
+
+private:
+    const uint8_t* m_Data;
+    size_t m_Size;
+#if defined(_WIN32)
+    HANDLE m_File;
+    HANDLE m_Mapping;
+#endif
+};
+
+PipelineCache::PipelineCache(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, const std::filesystem::path& path)
+    : m_Device(device)
+    , m_Path(path)
+    , m_Dirty(false)
+    , m_Statistics()
+{
+    m_Identity = GetAdapterIdentity();
+    m_Mapping = std::make_unique<FileMapping>(m_Path);
+
+    const uint8_t* data = m_Mapping->GetData();
+    size_t size = m_Mapping->GetSize();
+    bool loaded = false;
+
+    FileHeader header;
+    if(size >= sizeof(header))
+    {
+        memcpy(&header, data, sizeof(header));
+
+        size_t maxEntryCount = (size - sizeof(header)) / sizeof(FileEntry);
+        size_t libraryOffset = sizeof(header) + static_cast<size_t>(header.EntryCount) * sizeof(FileEntry);
+        bool valid = header.Magic == g_FileMagic &&
+            header.Version == g_FileVersion &&
+            header.EntryCount <= maxEntryCount &&
+            header.LibrarySize == size - libraryOffset;
+        bool sameAdapter = header.VendorId == m_Identity.VendorId &&
+            header.DeviceId == m_Identity.DeviceId &&
+            header.SubSysId == m_Identity.SubSysId &&
+            header.Revision == m_Identity.Revision &&
+            header.DriverVersion == m_Identity.DriverVersion;
+
+        // The library reads the pipelines straight out of the mapping, which stays until it is gone.
+        if(valid && sameAdapter && CreateLibrary(data + libraryOffset, static_cast<SIZE_T>(header.LibrarySize)))
+        {
+            for (uint32_t i = 0; i < header.EntryCount; ++i)
+            {
+                FileEntry entry;
+                memcpy(&entry, data + sizeof(header) + i * sizeof(FileEntry), sizeof(entry));
+                m_CompileTimes[entry.Hash] = entry.CompileMicroseconds;
+            }
+            loaded = true;
+        }
+
+        // Written again on Save even if nothing is added, so the next run doesn't find it stale too.
+        m_Statistics.Invalidated = !loaded;
+        m_Dirty = !loaded;
+    }
+
+    if(!loaded)
+    {
+        m_Mapping.reset();
+        CreateLibrary(nullptr, 0);
+    }
+}
+
+PipelineCache::~PipelineCache()
+{
+    // The library must go before the memory it was created from.
+    m_Library.Reset();
+}
+
+Microsoft::WRL::ComPtr<ID3D12RootSignature> PipelineCache::CreateRootSignature(const void* blob, SIZE_T size)
+{
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+    ThrowIfFailed(m_Device->CreateRootSignature(0, blob, size, IID_PPV_ARGS(&rootSignature)));
+
+    uint64_t hash = g_FnvOffsetBasis;
+    Hash(hash, blob, size);
+    ThrowIfFailed(rootSignature->SetPrivateData(g_RootSignatureHashGuid, sizeof(hash), &hash));
+
+    return rootSignature;
+}
+
+Microsoft::WRL::ComPtr<ID3D12PipelineState> PipelineCache::GetOrCreate(const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+{
+    std::chrono::high_resolution_clock clock;
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+
+    PipelineHasher hasher;
+    if(!m_Library || FAILED(D3DX12ParsePipelineStream(desc, &hasher)) || !hasher.IsCacheable())
+    {
+        ThrowIfFailed(m_Device->CreatePipelineState(&desc, IID_PPV_ARGS(&pipelineState)));
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ++m_Statistics.Uncached;
+
+        return pipelineState;
+    }
+
+    uint64_t hash = hasher.GetHash();
+    wchar_t name[17];
+    swprintf(name, std::size(name), L"%016llx", static_cast<unsigned long long>(hash));
+
+    // The library is only used under the lock, which also keeps two threads from loading the same
+    // pipeline at once, as it requires.
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        auto start = clock.now();
+        if(SUCCEEDED(m_Library->LoadPipeline(name, &desc, IID_PPV_ARGS(&pipelineState))))
+        {
+            double loadMilliseconds = ToMilliseconds(clock.now() - start);
+
+            ++m_Statistics.Hits;
+            m_Statistics.LoadMilliseconds += loadMilliseconds;
+
+            auto compileTime = m_CompileTimes.find(hash);
+            if(compileTime != m_CompileTimes.end())
+            {
+                m_Statistics.SavedMilliseconds += std::max(0.0, compileTime->second / 1000.0 - loadMilliseconds);
+            }
+
+            return pipelineState;
+        }
+    }
+
+    auto start = clock.now();
+    ThrowIfFailed(m_Device->CreatePipelineState(&desc, IID_PPV_ARGS(&pipelineState)));
+    auto compileTime = clock.now() - start;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    ++m_Statistics.Misses;
+    m_Statistics.CompileMilliseconds += ToMilliseconds(compileTime);
+
+    // Fails when another thread stored the same pipeline first, which is as good.
+    if(SUCCEEDED(m_Library->StorePipeline(name, pipelineState.Get())))
+    {
+        m_CompileTimes[hash] = std::chrono::duration_cast<std::chrono::microseconds>(compileTime).count();
+        m_Dirty = true;
+    }
+
+    return pipelineState;
+}
+
+void PipelineCache::Save()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if(!m_Library || !m_Dirty)
+    {
+        return;
+    }
+
+    SIZE_T librarySize = m_Library->GetSerializedSize();
+    size_t libraryOffset = sizeof(FileHeader) + m_CompileTimes.size() * sizeof(FileEntry);
+
+    FileHeader header = {};
+    header.Magic = g_FileMagic;
+    header.Version = g_FileVersion;
+    header.VendorId = m_Identity.VendorId;
+    header.DeviceId = m_Identity.DeviceId;
+    header.SubSysId = m_Identity.SubSysId;
+    header.Revision = m_Identity.Revision;
+    header.DriverVersion = m_Identity.DriverVersion;
+    header.EntryCount = static_cast<uint32_t>(m_CompileTimes.size());
+    header.LibrarySize = librarySize;
+
+    std::vector<uint8_t> contents(libraryOffset + librarySize);
+    memcpy(contents.data(), &header, sizeof(header));
+
+    uint8_t* entries = contents.data() + sizeof(header);
+    for (const auto& compileTime : m_CompileTimes)
+    {
+        FileEntry entry = {compileTime.first, compileTime.second};
+        memcpy(entries, &entry, sizeof(entry));
+        entries += sizeof(entry);
+    }
+    ThrowIfFailed(m_Library->Serialize(contents.data() + libraryOffset, librarySize));
+
+    std::filesystem::path temporaryPath = m_Path;
+    temporaryPath += L".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+        if(!file)
+        {
+            return;
+        }
+    }
+
+    // The library may still read from the mapped file, and a mapped file can't be replaced on Windows.
+    m_Library.Reset();
+    m_Mapping.reset();
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, m_Path, error);
+
+    m_Mapping = std::make_unique<FileMapping>(m_Path);
+    if(error || m_Mapping->GetSize() != contents.size() || !CreateLibrary(m_Mapping->GetData() + libraryOffset, librarySize))
+    {
+        m_Mapping.reset();
+        m_CompileTimes.clear();
+        CreateLibrary(nullptr, 0);
+        return;
+    }
+
+    m_Dirty = false;
+}
+
+PipelineCacheStatistics PipelineCache::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return m_Statistics;
+}
+
+PipelineCache::AdapterIdentity PipelineCache::GetAdapterIdentity() const
+{
+    AdapterIdentity identity = {};
+
+#if defined(_WIN32)
+    // The user mode driver version changes with every driver update, even when the adapter stays.
+    Microsoft::WRL::ComPtr<IDXGIFactory4> factory;
+    Microsoft::WRL::ComPtr<IDXGIAdapter1> adapter;
+    DXGI_ADAPTER_DESC1 desc;
+    LARGE_INTEGER driverVersion;
+    if(SUCCEEDED(::CreateDXGIFactory1(IID_PPV_ARGS(&factory))) &&
+        SUCCEEDED(factory->EnumAdapterByLuid(m_Device->GetAdapterLuid(), IID_PPV_ARGS(&adapter))) &&
+        SUCCEEDED(adapter->GetDesc1(&desc)) &&
+        SUCCEEDED(adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion)))
+    {
+        identity.VendorId = desc.VendorId;
+        identity.DeviceId = desc.DeviceId;
+        identity.SubSysId = desc.SubSysId;
+        identity.Revision = desc.Revision;
+        identity.DriverVersion = static_cast<uint64_t>(driverVersion.QuadPart);
+    }
+#endif
+
+    return identity;
+}
+
+bool PipelineCache::CreateLibrary(const void* blob, SIZE_T size)
+{
+    m_Library.Reset();
+
+    return SUCCEEDED(m_Device->CreatePipelineLibrary(blob, size, IID_PPV_ARGS(&m_Library)));
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct PipelineCacheStatistics
+{
+    // Pipelines loaded from the library, and those compiled and added to it.
+    uint64_t Hits;
+    uint64_t Misses;
+    // Pipelines created without the cache, because their root signature didn't come from it.
+    uint64_t Uncached;
+    double CompileMilliseconds;
+    double LoadMilliseconds;
+    // What the hits took to compile when they were stored, less what loading them took now.
+    double SavedMilliseconds;
+    // The file was written for another adapter or driver, or the driver refused it, and was ignored.
+    bool Invalidated;
+};
+
+// Pipeline states kept across runs in an ID3D12PipelineLibrary, which the file at path is mapped into
+// rather than read. Each pipeline is named by a hash of its stream's subobjects, shaders included, so
+// any change to its description finds a different entry. Root signatures only enter the hash through
+// a hash of their serialized blob, so those a cached pipeline uses must come from CreateRootSignature.
+// The file also records the adapter and driver it was written with; when either changes it starts out
+// empty. Without pipeline library support every pipeline is simply created. GetOrCreate is safe to
+// call from several threads; Save isn't, with it or with itself.
+class PipelineCache
+{
+public:
+    PipelineCache(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, const std::filesystem::path& path);
+    ~PipelineCache();
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> CreateRootSignature(const void* blob, SIZE_T size);
+
+    // Loads the pipeline from the library, or creates it and stores it there.
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> GetOrCreate(const D3D12_PIPELINE_STATE_STREAM_DESC& desc);
+
+    // Writes the library back to the file if anything was added. The file is replaced in one step, so
+    // a failed write leaves the previous one.
+    void Save();
+
+    PipelineCacheStatistics GetStatistics() const;
+
+private:
+    class FileMapping;
+
+    struct AdapterIdentity
+    {
+        uint32_t VendorId;
+        uint32_t DeviceId;
+        uint32_t SubSysId;
+        uint32_t Revision;
+        uint64_t DriverVersion;
+    };
+
+    AdapterIdentity GetAdapterIdentity() const;
+
+    // Returns false when the driver doesn't support pipeline libraries at all.
+    bool CreateLibrary(const void* blob, SIZE_T size);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    std::filesystem::path m_Path;
+    AdapterIdentity m_Identity;
+    std::unique_ptr<FileMapping> m_Mapping;
+    Microsoft::WRL::ComPtr<ID3D12PipelineLibrary1> m_Library;
+
+    // Guards the library and everything below, but not the compiles.
+    mutable std::mutex m_Mutex;
+    // Compile times in microseconds, by pipeline hash, of the pipelines in the library.
+    std::unordered_map<uint64_t, uint64_t> m_CompileTimes;
+    bool m_Dirty;
+    PipelineCacheStatistics m_Statistics;
+};
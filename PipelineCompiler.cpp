@@ -0,0 +1,260 @@
+#include "PipelineCompiler.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // A copy of a pipeline stream that owns everything it points to. The parser hands each callback
+    // a reference into the copied stream, which it points at copies of its own.
+    class PipelineStreamCopy : public ID3DX12PipelineParserCallbacks
+    {
+    public:
+        explicit PipelineStreamCopy(const D3D12_PIPELINE_STATE_STREAM_DESC& desc)
+            : m_Stream((desc.SizeInBytes + sizeof(void*) - 1) / sizeof(void*))
+        {
+            memcpy(m_Stream.data(), desc.pPipelineStateSubobjectStream, desc.SizeInBytes);
+            m_Desc = {desc.SizeInBytes, m_Stream.data()};
+
+            ThrowIfFailed(D3DX12ParsePipelineStream(m_Desc, this));
+        }
+
+        PipelineStreamCopy(const PipelineStreamCopy&) = delete;
+        PipelineStreamCopy& operator=(const PipelineStreamCopy&) = delete;
+
+        const D3D12_PIPELINE_STATE_STREAM_DESC& GetDesc() const
+        {
+            return m_Desc;
+        }
+
+        void RootSignatureCb(ID3D12RootSignature* rootSignature) override
+        {
+            m_RootSignature = rootSignature;
+        }
+
+        void InputLayoutCb(const D3D12_INPUT_LAYOUT_DESC& inputLayout) override
+        {
+            auto& copy = const_cast<D3D12_INPUT_LAYOUT_DESC&>(inputLayout);
+            auto elements = Keep(inputLayout.pInputElementDescs, inputLayout.NumElements);
+            for (UINT i = 0; i < inputLayout.NumElements; ++i)
+            {
+                elements[i].SemanticName = KeepString(elements[i].SemanticName);
+            }
+            copy.pInputElementDescs = elements;
+        }
+
+        void StreamOutputCb(const D3D12_STREAM_OUTPUT_DESC& streamOutput) override
+        {
+            auto& copy = const_cast<D3D12_STREAM_OUTPUT_DESC&>(streamOutput);
+            auto entries = Keep(streamOutput.pSODeclaration, streamOutput.NumEntries);
+            for (UINT i = 0; i < streamOutput.NumEntries; ++i)
+            {
+                entries[i].SemanticName = KeepString(entries[i].SemanticName);
+            }
+            copy.pSODeclaration = entries;
+            copy.pBufferStrides = Keep(streamOutput.pBufferStrides, streamOutput.NumStrides);
+        }
+
+        void VSCb(const D3D12_SHADER_BYTECODE& shader) override { KeepShader(shader); }
+        void GSCb(const D3D12_SHADER_BYTECODE& shader) override { KeepShader(shader); }
+        void HSCb(const D3D12_SHADER_BYTECODE& shader) override { KeepShader(shader); }
+        void DSCb(const D3D12_SHADER_BYTECODE& shader) override { KeepShader(shader); }
+        void PSCb(const D3D12_SHADER_BYTECODE& shader) override { KeepShader(shader); }
+        void CSCb(const D3D12_SHADER_BYTECODE& shader) override { KeepShader(shader); }
+        void ASCb(const D3D12_SHADER_BYTECODE& shader) override { KeepShader(shader); }
+        void MSCb(const D3D12_SHADER_BYTECODE& shader) override { KeepShader(shader); }
+
+        void ViewInstancingCb(const D3D12_VIEW_INSTANCING_DESC& viewInstancing) override
+        {
+            auto& copy = const_cast<D3D12_VIEW_INSTANCING_DESC&>(viewInstancing);
+            copy.pViewInstanceLocations = Keep(viewInstancing.pViewInstanceLocations, viewInstancing.ViewInstanceCount);
+        }
+
+        void CachedPSOCb(const D3D12_CACHED_PIPELINE_STATE& cachedPipeline) override
+        {
+            auto& copy = const_cast<D3D12_CACHED_PIPELINE_STATE&>(cachedPipeline);
+            copy.pCachedBlob = Keep(static_cast<const uint8_t*>(cachedPipeline.pCachedBlob), cachedPipeline.CachedBlobSizeInBytes);
+        }
+
+    private:
+        template<typename T>
+        T* Keep(const T* data, size_t count)
+        {
+            if(!data || count == 0)
+            {
+                return const_cast<T*>(data);
+            }
+
+            m_Storage.emplace_back(count * sizeof(T));
+            memcpy(m_Storage.back().data(), data, count * sizeof(T));
+
+            return reinterpret_cast<T*>(m_Storage.back().data());
+        }
+
+        LPCSTR KeepString(LPCSTR string)
+        {
+            return string ? Keep(string, strlen(string) + 1) : nullptr;
+        }
+
+        void KeepShader(const D3D12_SHADER_BYTECODE& shader)
+        {
+            auto& copy = const_cast<D3D12_SHADER_BYTECODE&>(shader);
+            copy.pShaderBytecode = Keep(static_cast<const uint8_t*>(shader.pShaderBytecode), shader.BytecodeLength);
+        }
+
+        // Subobjects are aligned to pointers.
+        std::vector<void*> m_Stream;
+        D3D12_PIPELINE_STATE_STREAM_DESC m_Desc;
+        std::vector<std::vector<uint8_t>> m_Storage;
+        Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSignature;
+    };
+
+    double ToMilliseconds(std::chrono::high_resolution_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+struct PipelineCompiler::Request
+{
+    explicit Request(const D3D12_PIPELINE_STATE_STREAM_DESC& desc) : Stream(desc)
+    {
+    }
+
+    PipelineStreamCopy Stream;
+    PipelineHandle Handle;
+    std::chrono::high_resolution_clock::time_point Queued;
+};
+
+bool PipelineHandle::IsReady() const
+{
+    return m_State && m_State->Ready.load(std::memory_order_acquire);
+}
+
+ID3D12PipelineState* PipelineHandle::Get() const
+{
+    if(!m_State)
+    {
+        return nullptr;
+    }
+
+    if(m_State->Ready.load(std::memory_order_acquire) && m_State->Pipeline)
+    {
+        return m_State->Pipeline.Get();
+    }
+
+    return m_State->Fallback.Get();
+}
+
+PipelineCompiler::PipelineCompiler(PipelineCache& pipelineCache, uint32_t threadCount)
+    : m_PipelineCache(pipelineCache)
+    , m_Busy(0)
+    , m_Stop(false)
+    , m_Statistics()
+{
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_Threads.emplace_back(&PipelineCompiler::Run, this);
+    }
+}
+
+PipelineCompiler::~PipelineCompiler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_WorkAvailable.notify_all();
+
+    for (std::thread& thread : m_Threads)
+    {
+        thread.join();
+    }
+}
+
+PipelineHandle PipelineCompiler::Compile(
+    const D3D12_PIPELINE_STATE_STREAM_DESC& desc,
+    const Microsoft::WRL::ComPtr<ID3D12PipelineState>& fallback)
+{
+    std::chrono::high_resolution_clock clock;
+
+    auto request = std::make_unique<Request>(desc);
+    request->Handle.m_State = std::make_shared<PipelineHandle::State>();
+    request->Handle.m_State->Fallback = fallback;
+    request->Queued = clock.now();
+
+    PipelineHandle handle = request->Handle;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Requests.push_back(std::move(request));
+    }
+    m_WorkAvailable.notify_one();
+
+    return handle;
+}
+
+void PipelineCompiler::Drain()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Idle.wait(lock, [this] { return m_Requests.empty() && m_Busy == 0; });
+}
+
+PipelineCompilerStatistics PipelineCompiler::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    PipelineCompilerStatistics statistics = m_Statistics;
+    statistics.Pending = m_Requests.size() + m_Busy;
+
+    return statistics;
+}
+
+void PipelineCompiler::Run()
+{
+    std::chrono::high_resolution_clock clock;
+
+    while (true)
+    {
+        std::unique_ptr<Request> request;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkAvailable.wait(lock, [this] { return m_Stop || !m_Requests.empty(); });
+
+            if(m_Stop)
+            {
+                return;
+            }
+
+            request = std::move(m_Requests.front());
+            m_Requests.pop_front();
+            ++m_Busy;
+        }
+
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> pipeline;
+        try
+        {
+            pipeline = m_PipelineCache.GetOrCreate(request->Stream.GetDesc());
+        }
+        catch (const std::exception&)
+        {
+        }
+
+        request->Handle.m_State->Pipeline = pipeline;
+        request->Handle.m_State->Ready.store(true, std::memory_order_release);
+        double latency = ToMilliseconds(clock.now() - request->Queued);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            --m_Busy;
+            ++(pipeline ? m_Statistics.Compiled : m_Statistics.Failed);
+            m_Statistics.MaxLatencyMilliseconds = std::max(m_Statistics.MaxLatencyMilliseconds, latency);
+
+            if(m_Requests.empty() && m_Busy == 0)
+            {
+                m_Idle.notify_all();
+            }
+        }
+    }
+}
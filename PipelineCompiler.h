@@ -0,0 +1,87 @@
+#pragma once
+
+#include "PipelineCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct PipelineCompilerStatistics
+{
+    uint64_t Compiled;
+    uint64_t Failed;
+    // Queued or being compiled.
+    uint64_t Pending;
+    // The longest any request took from Compile until it was ready.
+    double MaxLatencyMilliseconds;
+};
+
+// A pipeline requested from PipelineCompiler. Until it is ready, Get returns the fallback given with
+// the request, which may be null; then the compiled pipeline, or the fallback still if compiling
+// failed. Copies share the request. Safe to read from any thread.
+class PipelineHandle
+{
+public:
+    bool IsReady() const;
+
+    ID3D12PipelineState* Get() const;
+
+private:
+    friend class PipelineCompiler;
+
+    struct State
+    {
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> Fallback;
+        // Written once, before Ready is set.
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> Pipeline;
+        std::atomic<bool> Ready{false};
+    };
+
+    std::shared_ptr<State> m_State;
+};
+
+// Creates pipeline states through pipelineCache on background threads, so the thread asking for one
+// never waits on the driver. The stream is copied along with everything it points to, shaders
+// included, so the caller's description can go as soon as Compile returns. Requests not started when
+// the compiler is destroyed are dropped, and their handles never become ready.
+class PipelineCompiler
+{
+public:
+    PipelineCompiler(PipelineCache& pipelineCache, uint32_t threadCount);
+    ~PipelineCompiler();
+
+    PipelineCompiler(const PipelineCompiler&) = delete;
+    PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+
+    PipelineHandle Compile(
+        const D3D12_PIPELINE_STATE_STREAM_DESC& desc,
+        const Microsoft::WRL::ComPtr<ID3D12PipelineState>& fallback = nullptr);
+
+    // Blocks until every request made so far is ready.
+    void Drain();
+
+    PipelineCompilerStatistics GetStatistics() const;
+
+private:
+    struct Request;
+
+    void Run();
+
+    PipelineCache& m_PipelineCache;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_WorkAvailable;
+    std::condition_variable m_Idle;
+    std::deque<std::unique_ptr<Request>> m_Requests;
+    uint32_t m_Busy;
+    bool m_Stop;
+    PipelineCompilerStatistics m_Statistics;
+
+    std::vector<std::thread> m_Threads;
+};
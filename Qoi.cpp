@@ -0,0 +1,102 @@
+#include "Qoi.h"
+
+namespace
+{
+    void WriteBigEndian(std::vector<uint8_t>& output, uint32_t value)
+    {
+        output.push_back(static_cast<uint8_t>(value >> 24));
+        output.push_back(static_cast<uint8_t>(value >> 16));
+        output.push_back(static_cast<uint8_t>(value >> 8));
+        output.push_back(static_cast<uint8_t>(value));
+    }
+}
+
+// The swap chain's alpha means nothing on screen, so it is not stored.
+void EncodeQoi(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& output)
+{
+    constexpr uint8_t opIndex = 0x00;
+    constexpr uint8_t opDiff = 0x40;
+    constexpr uint8_t opLuma = 0x80;
+    constexpr uint8_t opRun = 0xc0;
+    constexpr uint8_t opRgb = 0xfe;
+
+    output.clear();
+    output.reserve(14 + pixels.size() + 8);
+
+    const char magic[] = "qoif";
+    output.insert(output.end(), magic, magic + 4);
+    WriteBigEndian(output, width);
+    WriteBigEndian(output, height);
+    output.push_back(3);
+    output.push_back(0);
+
+    // The decoder's index starts out as transparent black, so it keeps alpha: an empty slot then
+    // never matches a pixel, whose alpha is always 255.
+    uint8_t index[64][4] = {};
+    uint8_t previous[3] = {0, 0, 0};
+    uint32_t run = 0;
+
+    size_t end = pixels.size();
+    for (size_t i = 0; i < end; i += 3)
+    {
+        const uint8_t* pixel = &pixels[i];
+
+        if(pixel[0] == previous[0] && pixel[1] == previous[1] && pixel[2] == previous[2])
+        {
+            ++run;
+            if(run == 62 || i + 3 == end)
+            {
+                output.push_back(static_cast<uint8_t>(opRun | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+
+        if(run > 0)
+        {
+            output.push_back(static_cast<uint8_t>(opRun | (run - 1)));
+            run = 0;
+        }
+
+        uint32_t hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + 255 * 11) % 64;
+        if(index[hash][0] == pixel[0] && index[hash][1] == pixel[1] && index[hash][2] == pixel[2] && index[hash][3] == 255)
+        {
+            output.push_back(static_cast<uint8_t>(opIndex | hash));
+        }
+        else
+        {
+            index[hash][0] = pixel[0];
+            index[hash][1] = pixel[1];
+            index[hash][2] = pixel[2];
+            index[hash][3] = 255;
+
+            int8_t dr = static_cast<int8_t>(pixel[0] - previous[0]);
+            int8_t dg = static_cast<int8_t>(pixel[1] - previous[1]);
+            int8_t db = static_cast<int8_t>(pixel[2] - previous[2]);
+            int8_t dgr = static_cast<int8_t>(dr - dg);
+            int8_t dgb = static_cast<int8_t>(db - dg);
+
+            if(dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+            {
+                output.push_back(static_cast<uint8_t>(opDiff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+            }
+            else if(dgr >= -8 && dgr <= 7 && dg >= -32 && dg <= 31 && dgb >= -8 && dgb <= 7)
+            {
+                output.push_back(static_cast<uint8_t>(opLuma | (dg + 32)));
+                output.push_back(static_cast<uint8_t>((dgr + 8) << 4 | (dgb + 8)));
+            }
+            else
+            {
+                output.push_back(opRgb);
+                output.insert(output.end(), pixel, pixel + 3);
+            }
+        }
+
+        previous[0] = pixel[0];
+        previous[1] = pixel[1];
+        previous[2] = pixel[2];
+    }
+
+    const uint8_t endMarker[] = {0, 0, 0, 0, 0, 0, 0, 1};
+    output.insert(output.end(), endMarker, endMarker + sizeof(endMarker));
+}
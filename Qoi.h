@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Encodes tightly packed RGB pixels as a three channel QOI image, following the specification at
+// qoiformat.org. Alpha is taken as 255 throughout. output is replaced, keeping its capacity.
+void EncodeQoi(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, std::vector<uint8_t>& output);
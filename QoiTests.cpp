@@ -0,0 +1,193 @@
+#include "Qoi.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    uint32_t ReadBigEndian(const uint8_t* data)
+    {
+        return uint32_t(data[0]) << 24 | uint32_t(data[1]) << 16 | uint32_t(data[2]) << 8 | data[3];
+    }
+
+    // A decoder written from the specification alone, independent of the encoder, returning RGBA.
+    // Returns false when the stream is malformed.
+    bool DecodeQoi(const std::vector<uint8_t>& input, uint32_t& width, uint32_t& height, std::vector<uint8_t>& pixels)
+    {
+        if(input.size() < 14 + 8 || input[0] != 'q' || input[1] != 'o' || input[2] != 'i' || input[3] != 'f')
+        {
+            return false;
+        }
+
+        width = ReadBigEndian(&input[4]);
+        height = ReadBigEndian(&input[8]);
+        size_t pixelCount = static_cast<size_t>(width) * height;
+
+        uint8_t index[64][4] = {};
+        uint8_t pixel[4] = {0, 0, 0, 255};
+        size_t position = 14;
+        size_t end = input.size() - 8;
+
+        pixels.clear();
+        while (pixels.size() < pixelCount * 4)
+        {
+            if(position >= end)
+            {
+                return false;
+            }
+
+            uint8_t op = input[position++];
+            uint32_t run = 1;
+            if(op == 0xfe)
+            {
+                pixel[0] = input[position];
+                pixel[1] = input[position + 1];
+                pixel[2] = input[position + 2];
+                position += 3;
+            }
+            else if(op == 0xff)
+            {
+                pixel[0] = input[position];
+                pixel[1] = input[position + 1];
+                pixel[2] = input[position + 2];
+                pixel[3] = input[position + 3];
+                position += 4;
+            }
+            else if((op & 0xc0) == 0x00)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    pixel[c] = index[op][c];
+                }
+            }
+            else if((op & 0xc0) == 0x40)
+            {
+                pixel[0] = static_cast<uint8_t>(pixel[0] + ((op >> 4) & 3) - 2);
+                pixel[1] = static_cast<uint8_t>(pixel[1] + ((op >> 2) & 3) - 2);
+                pixel[2] = static_cast<uint8_t>(pixel[2] + (op & 3) - 2);
+            }
+            else if((op & 0xc0) == 0x80)
+            {
+                uint8_t second = input[position++];
+                int dg = (op & 0x3f) - 32;
+                pixel[0] = static_cast<uint8_t>(pixel[0] + dg + (second >> 4) - 8);
+                pixel[1] = static_cast<uint8_t>(pixel[1] + dg);
+                pixel[2] = static_cast<uint8_t>(pixel[2] + dg + (second & 0x0f) - 8);
+            }
+            else
+            {
+                run = (op & 0x3f) + 1;
+            }
+
+            uint32_t hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+            for (int c = 0; c < 4; ++c)
+            {
+                index[hash][c] = pixel[c];
+            }
+
+            for (uint32_t i = 0; i < run; ++i)
+            {
+                pixels.insert(pixels.end(), pixel, pixel + 4);
+            }
+        }
+
+        const uint8_t endMarker[] = {0, 0, 0, 0, 0, 0, 0, 1};
+        return pixels.size() == pixelCount * 4 && position == end && std::equal(endMarker, endMarker + 8, &input[end]);
+    }
+
+    // Checks that pixels survive encoding and decoding, with alpha decoded as 255.
+    void CheckRoundTrip(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height)
+    {
+        std::vector<uint8_t> encoded;
+        EncodeQoi(pixels, width, height, encoded);
+
+        uint32_t decodedWidth = 0;
+        uint32_t decodedHeight = 0;
+        std::vector<uint8_t> decoded;
+        if(!CHECK(DecodeQoi(encoded, decodedWidth, decodedHeight, decoded)))
+        {
+            return;
+        }
+
+        CHECK(decodedWidth == width);
+        CHECK(decodedHeight == height);
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < pixels.size() / 3; ++i)
+        {
+            const uint8_t* expected = &pixels[i * 3];
+            const uint8_t* actual = &decoded[i * 4];
+            if(actual[0] != expected[0] || actual[1] != expected[1] || actual[2] != expected[2] || actual[3] != 255)
+            {
+                ++mismatches;
+            }
+        }
+        CHECK(mismatches == 0);
+    }
+}
+
+TEST(QoiDoesNotIndexBlackBeforeItIsSeen)
+{
+    // Black hashes to a slot that starts out as transparent black in the decoder, so a black pixel
+    // that isn't the previous one must not be written as an index.
+    std::vector<uint8_t> pixels =
+    {
+        255, 0, 0,
+        0, 0, 0,
+        0, 255, 0,
+        0, 0, 255,
+        255, 0, 0,
+        0, 255, 0,
+        0, 0, 0,
+        255, 0, 0
+    };
+
+    CheckRoundTrip(pixels, 8, 1);
+    CheckRoundTrip(std::vector<uint8_t>(pixels.begin() + 6, pixels.end()), 6, 1);
+}
+
+TEST(QoiRoundTripsEveryOperation)
+{
+    const uint32_t width = 97;
+    const uint32_t height = 61;
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 3);
+
+    // Runs longer than one op holds, small and medium steps for the diff and luma ops, repeats of
+    // earlier colours for the index, and noise for full pixels.
+    std::mt19937 random(19);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            uint8_t* pixel = &pixels[(static_cast<size_t>(y) * width + x) * 3];
+            uint32_t band = y % 4;
+            if(band == 0)
+            {
+                pixel[0] = pixel[1] = pixel[2] = 0;
+            }
+            else if(band == 1)
+            {
+                pixel[0] = static_cast<uint8_t>(x);
+                pixel[1] = static_cast<uint8_t>(x * 3);
+                pixel[2] = static_cast<uint8_t>(x * 5);
+            }
+            else if(band == 2)
+            {
+                uint8_t palette[4][3] = {{0, 0, 0}, {255, 255, 255}, {200, 10, 30}, {5, 5, 5}};
+                uint32_t colour = random() % 4;
+                pixel[0] = palette[colour][0];
+                pixel[1] = palette[colour][1];
+                pixel[2] = palette[colour][2];
+            }
+            else
+            {
+                pixel[0] = static_cast<uint8_t>(random());
+                pixel[1] = static_cast<uint8_t>(random());
+                pixel[2] = static_cast<uint8_t>(random());
+            }
+        }
+    }
+
+    CheckRoundTrip(pixels, width, height);
+}
@@ -0,0 +1,263 @@
+#include "ReadbackRing.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <algorithm>
+#include <utility>
+
+ReadbackResult::ReadbackResult()
+    : m_Ring(nullptr)
+    , m_Slot(0)
+    , m_Data(nullptr)
+    , m_Footprint()
+{
+}
+
+ReadbackResult::ReadbackResult(ReadbackRing* ring, uint32_t slot, const uint8_t* data, const D3D12_SUBRESOURCE_FOOTPRINT& footprint)
+    : m_Ring(ring)
+    , m_Slot(slot)
+    , m_Data(data)
+    , m_Footprint(footprint)
+{
+}
+
+ReadbackResult::ReadbackResult(ReadbackResult&& other)
+    : m_Ring(std::exchange(other.m_Ring, nullptr))
+    , m_Slot(other.m_Slot)
+    , m_Data(std::exchange(other.m_Data, nullptr))
+    , m_Footprint(other.m_Footprint)
+{
+}
+
+ReadbackResult& ReadbackResult::operator=(ReadbackResult&& other)
+{
+    if(this != &other)
+    {
+        Reset();
+        m_Ring = std::exchange(other.m_Ring, nullptr);
+        m_Slot = other.m_Slot;
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Footprint = other.m_Footprint;
+    }
+
+    return *this;
+}
+
+ReadbackResult::~ReadbackResult()
+{
+    Reset();
+}
+
+const uint8_t* ReadbackResult::GetData() const
+{
+    return m_Data;
+}
+
+const D3D12_SUBRESOURCE_FOOTPRINT& ReadbackResult::GetFootprint() const
+{
+    return m_Footprint;
+}
+
+void ReadbackResult::Reset()
+{
+    if(m_Ring)
+    {
+        m_Ring->ReleaseSlot(m_Slot);
+        m_Ring = nullptr;
+        m_Data = nullptr;
+    }
+}
+
+ReadbackRing::ReadbackRing(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, FenceWaiter& fenceWaiter, uint32_t slotCount)
+    : m_Device(device)
+    , m_FenceWaiter(fenceWaiter)
+    , m_Slots(slotCount)
+    , m_NextSlot(0)
+    , m_Completed(0)
+    , m_Dropped(0)
+{
+    for (Slot& slot : m_Slots)
+    {
+        slot.Capacity = 0;
+        slot.Size = 0;
+        slot.Footprint = {};
+        slot.State = SlotState_Free;
+    }
+}
+
+std::future<ReadbackResult> ReadbackRing::ReadbackTexture(ID3D12GraphicsCommandList* commandList, ID3D12Resource* texture, UINT subresource)
+{
+    D3D12_RESOURCE_DESC desc = texture->GetDesc();
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout;
+    UINT64 size;
+    m_Device->GetCopyableFootprints(&desc, subresource, 1, 0, &layout, nullptr, nullptr, &size);
+
+    uint32_t slotIndex;
+    if(!AcquireSlot(size, slotIndex))
+    {
+        return {};
+    }
+
+    Slot& slot = m_Slots[slotIndex];
+    slot.Footprint = layout.Footprint;
+
+    CD3DX12_TEXTURE_COPY_LOCATION destination(slot.Buffer.Get(), layout);
+    CD3DX12_TEXTURE_COPY_LOCATION source(texture, subresource);
+    commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+
+    return slot.Promise.get_future();
+}
+
+std::future<ReadbackResult> ReadbackRing::ReadbackBuffer(ID3D12GraphicsCommandList* commandList, ID3D12Resource* buffer, uint64_t offset, uint64_t size)
+{
+    uint32_t slotIndex;
+    if(!AcquireSlot(size, slotIndex))
+    {
+        return {};
+    }
+
+    Slot& slot = m_Slots[slotIndex];
+    slot.Footprint = {DXGI_FORMAT_UNKNOWN, static_cast<UINT>(size), 1, 1, static_cast<UINT>(size)};
+
+    commandList->CopyBufferRegion(slot.Buffer.Get(), 0, buffer, offset, size);
+
+    return slot.Promise.get_future();
+}
+
+void ReadbackRing::FinishFrame(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue)
+{
+    std::vector<uint32_t> recordedSlots;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        for (uint32_t slotIndex : m_RecordedSlots)
+        {
+            m_Slots[slotIndex].State = SlotState_InFlight;
+        }
+        recordedSlots.swap(m_RecordedSlots);
+    }
+
+    for (uint32_t slotIndex : recordedSlots)
+    {
+        m_FenceWaiter.Enqueue(fence, fenceValue, [this, slotIndex] { Complete(slotIndex); });
+    }
+}
+
+ReadbackRingStatistics ReadbackRing::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    ReadbackRingStatistics statistics = {};
+    statistics.Slots = static_cast<uint32_t>(m_Slots.size());
+    for (const Slot& slot : m_Slots)
+    {
+        statistics.InFlight += slot.State == SlotState_Recorded || slot.State == SlotState_InFlight ? 1 : 0;
+        statistics.Held += slot.State == SlotState_Held ? 1 : 0;
+    }
+    statistics.Completed = m_Completed;
+    statistics.Dropped = m_Dropped;
+
+    return statistics;
+}
+
+bool ReadbackRing::AcquireSlot(uint64_t size, uint32_t& slotIndex)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        // Round robin rather than first free, so a slot whose buffer was just unmapped is the last to be reused.
+        uint32_t slotCount = static_cast<uint32_t>(m_Slots.size());
+        uint32_t i = 0;
+        while (i < slotCount && m_Slots[(m_NextSlot + i) % slotCount].State != SlotState_Free)
+        {
+            ++i;
+        }
+
+        if(i == slotCount)
+        {
+            ++m_Dropped;
+            return false;
+        }
+
+        slotIndex = (m_NextSlot + i) % slotCount;
+        m_NextSlot = (slotIndex + 1) % slotCount;
+        m_Slots[slotIndex].State = SlotState_Recorded;
+        m_RecordedSlots.push_back(slotIndex);
+    }
+
+    // The slot is ours alone until FinishFrame, so its buffer can be replaced without the lock.
+    Slot& slot = m_Slots[slotIndex];
+    if(slot.Capacity < size)
+    {
+        slot.Buffer.Reset();
+        slot.Capacity = 0;
+
+        CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_READBACK);
+        CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+        HRESULT hr = m_Device->CreateCommittedResource(
+            &heapProperties,
+            D3D12_HEAP_FLAG_NONE,
+            &bufferDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(&slot.Buffer));
+
+        // Handed back before FinishFrame can queue it, as it has no buffer to map and no promise.
+        if(FAILED(hr))
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            slot.State = SlotState_Free;
+            m_RecordedSlots.erase(std::find(m_RecordedSlots.begin(), m_RecordedSlots.end(), slotIndex));
+            ThrowIfFailed(hr);
+        }
+
+        slot.Capacity = size;
+    }
+
+    slot.Size = size;
+    slot.Promise = std::promise<ReadbackResult>();
+
+    return true;
+}
+
+void ReadbackRing::Complete(uint32_t slotIndex)
+{
+    Slot& slot = m_Slots[slotIndex];
+
+    // Taken out of the slot so the shared state, and the result in it, doesn't outlive an abandoned future.
+    std::promise<ReadbackResult> promise = std::move(slot.Promise);
+
+    void* data;
+    CD3DX12_RANGE readRange(0, static_cast<SIZE_T>(slot.Size));
+    HRESULT hr = slot.Buffer->Map(0, &readRange, &data);
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        slot.State = SUCCEEDED(hr) ? SlotState_Held : SlotState_Free;
+        ++m_Completed;
+    }
+
+    if(FAILED(hr))
+    {
+        promise.set_exception(std::make_exception_ptr(HResultException(hr)));
+        return;
+    }
+
+    promise.set_value(ReadbackResult(this, slotIndex, static_cast<const uint8_t*>(data), slot.Footprint));
+}
+
+void ReadbackRing::ReleaseSlot(uint32_t slotIndex)
+{
+    Slot& slot = m_Slots[slotIndex];
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    CD3DX12_RANGE writtenRange(0, 0);
+    slot.Buffer->Unmap(0, &writtenRange);
+
+    slot.State = SlotState_Free;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+#include "FenceWaiter.h"
+
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <vector>
+
+class ReadbackRing;
+
+// The copied data of one readback, mapped for reading. Keeps its slot busy until destroyed, so drop
+// results once they are consumed or the ring runs out of slots.
+class ReadbackResult
+{
+public:
+    ReadbackResult();
+    ReadbackResult(ReadbackResult&& other);
+    ReadbackResult& operator=(ReadbackResult&& other);
+    ~ReadbackResult();
+
+    ReadbackResult(const ReadbackResult&) = delete;
+    ReadbackResult& operator=(const ReadbackResult&) = delete;
+
+    const uint8_t* GetData() const;
+
+    // Rows of a texture readback are RowPitch bytes apart; a buffer readback is a single row of Width bytes.
+    const D3D12_SUBRESOURCE_FOOTPRINT& GetFootprint() const;
+
+private:
+    friend class ReadbackRing;
+
+    ReadbackResult(ReadbackRing* ring, uint32_t slot, const uint8_t* data, const D3D12_SUBRESOURCE_FOOTPRINT& footprint);
+
+    void Reset();
+
+    ReadbackRing* m_Ring;
+    uint32_t m_Slot;
+    const uint8_t* m_Data;
+    D3D12_SUBRESOURCE_FOOTPRINT m_Footprint;
+};
+
+struct ReadbackRingStatistics
+{
+    uint32_t Slots;
+    // Slots recorded into that the GPU has not finished, and slots whose results have not been dropped yet.
+    uint32_t InFlight;
+    uint32_t Held;
+    uint64_t Completed;
+    // Readbacks refused because every slot was busy.
+    uint64_t Dropped;
+};
+
+// A fixed number of READBACK buffers that copies out of the frame are recorded into. Each readback
+// returns a future that the fence waiter fulfils once the frame it was submitted with completes, and
+// only then is the slot mapped, so nothing ever waits on the GPU: with a slot per frame in flight,
+// earlier frames keep streaming out while the current one renders. Slot buffers grow to the largest
+// copy they have taken. Safe to use from several threads.
+class ReadbackRing
+{
+public:
+    // Every result must have been dropped, and the fence waiter drained, before the ring is destroyed.
+    ReadbackRing(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, FenceWaiter& fenceWaiter, uint32_t slotCount);
+
+    ReadbackRing(const ReadbackRing&) = delete;
+    ReadbackRing& operator=(const ReadbackRing&) = delete;
+
+    // Records a copy of one subresource, which must be in COPY_SOURCE. When every slot is busy nothing
+    // is recorded and the returned future has no shared state; the caller decides whether to skip.
+    // A slot that fails to map makes get() throw an HResultException with the failure.
+    std::future<ReadbackResult> ReadbackTexture(ID3D12GraphicsCommandList* commandList, ID3D12Resource* texture, UINT subresource = 0);
+
+    std::future<ReadbackResult> ReadbackBuffer(ID3D12GraphicsCommandList* commandList, ID3D12Resource* buffer, uint64_t offset, uint64_t size);
+
+    // Everything recorded since the previous call completes with fenceValue.
+    void FinishFrame(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue);
+
+    ReadbackRingStatistics GetStatistics() const;
+
+private:
+    friend class ReadbackResult;
+
+    enum SlotState
+    {
+        SlotState_Free,
+        SlotState_Recorded,
+        SlotState_InFlight,
+        SlotState_Held
+    };
+
+    struct Slot
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> Buffer;
+        uint64_t Capacity;
+        uint64_t Size;
+        D3D12_SUBRESOURCE_FOOTPRINT Footprint;
+        std::promise<ReadbackResult> Promise;
+        SlotState State;
+    };
+
+    // Claims the next free slot and makes sure its buffer holds size bytes. Returns false when none is free,
+    // and throws with the slot free again when its buffer can't be created.
+    bool AcquireSlot(uint64_t size, uint32_t& slotIndex);
+
+    // Runs on the fence waiter's thread.
+    void Complete(uint32_t slotIndex);
+
+    void ReleaseSlot(uint32_t slotIndex);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    FenceWaiter& m_FenceWaiter;
+
+    mutable std::mutex m_Mutex;
+    std::vector<Slot> m_Slots;
+    uint32_t m_NextSlot;
+    std::vector<uint32_t> m_RecordedSlots;
+    uint64_t m_Completed;
+    uint64_t m_Dropped;
+};
@@ -0,0 +1,170 @@
+#include "FakeFence.h"
+#include "ReadbackRing.h"
+#include "Tests.h"
+
+#if !defined(_WIN32)
+#include "NullDevice.h"
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <chrono>
+#include <future>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // A list to record readbacks into and a buffer to read back. Nothing is submitted; the fake fence
+    // stands in for the GPU finishing, so the data read back is whatever the buffer held.
+    struct ReadbackFixture
+    {
+        explicit ReadbackFixture(ID3D12Device2* device)
+        {
+            ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&Allocator)));
+            ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, Allocator.Get(), nullptr, IID_PPV_ARGS(&CommandList)));
+
+            CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+            CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(65536);
+            ThrowIfFailed(device->CreateCommittedResource(
+                &heapProperties,
+                D3D12_HEAP_FLAG_NONE,
+                &desc,
+                D3D12_RESOURCE_STATE_COPY_SOURCE,
+                nullptr,
+                IID_PPV_ARGS(&Source)));
+
+            Fence = Microsoft::WRL::Make<FakeFence>();
+        }
+
+        ~ReadbackFixture()
+        {
+            CommandList->Close();
+        }
+
+        std::future<ReadbackResult> Readback(ReadbackRing& ring, uint64_t size)
+        {
+            return ring.ReadbackBuffer(CommandList.Get(), Source.Get(), 0, size);
+        }
+
+        ComPtr<ID3D12CommandAllocator> Allocator;
+        ComPtr<ID3D12GraphicsCommandList> CommandList;
+        ComPtr<ID3D12Resource> Source;
+        ComPtr<FakeFence> Fence;
+    };
+
+    bool IsReady(const std::future<ReadbackResult>& future, std::chrono::milliseconds timeout = std::chrono::milliseconds(0))
+    {
+        return future.wait_for(timeout) == std::future_status::ready;
+    }
+}
+
+TEST(ReadbackRingFulfilsFuturesOnceTheFenceCompletes)
+{
+    ReadbackFixture fixture(device);
+    FenceWaiter waiter;
+
+    {
+        ReadbackRing ring(device, waiter, 2);
+        std::future<ReadbackResult> future = fixture.Readback(ring, 256);
+        CHECK(future.valid());
+
+        // Nothing happens until the frame is finished, and then not before its fence completes.
+        ring.FinishFrame(fixture.Fence, 1);
+        CHECK(waiter.GetPendingCount() == 1);
+        CHECK(!IsReady(future));
+        CHECK(ring.GetStatistics().InFlight == 1);
+
+        fixture.Fence->Complete(1);
+        if(CHECK(IsReady(future, std::chrono::seconds(5))))
+        {
+            ReadbackResult result = future.get();
+            CHECK(result.GetData() != nullptr);
+            CHECK(result.GetFootprint().Width == 256);
+
+            ReadbackRingStatistics statistics = ring.GetStatistics();
+            CHECK(statistics.InFlight == 0);
+            CHECK(statistics.Held == 1);
+            CHECK(statistics.Completed == 1);
+        }
+
+        CHECK(ring.GetStatistics().Held == 0);
+        waiter.Drain();
+    }
+}
+
+TEST(ReadbackRingKeepsSlotsBusyUntilResultsAreDropped)
+{
+    ReadbackFixture fixture(device);
+    FenceWaiter waiter;
+
+    {
+        ReadbackRing ring(device, waiter, 2);
+        std::future<ReadbackResult> first = fixture.Readback(ring, 256);
+        std::future<ReadbackResult> second = fixture.Readback(ring, 1024);
+
+        // Every slot is recorded into, so the third readback is refused.
+        std::future<ReadbackResult> refused = fixture.Readback(ring, 256);
+        CHECK(first.valid() && second.valid());
+        CHECK(!refused.valid());
+        CHECK(ring.GetStatistics().Dropped == 1);
+
+        ring.FinishFrame(fixture.Fence, 1);
+        fixture.Fence->Complete(1);
+        waiter.Drain();
+
+        // Completed but still held by the results in the futures.
+        CHECK(ring.GetStatistics().Held == 2);
+        CHECK(!fixture.Readback(ring, 256).valid());
+        CHECK(ring.GetStatistics().Dropped == 2);
+
+        {
+            ReadbackResult result = first.get();
+        }
+        CHECK(ring.GetStatistics().Held == 1);
+
+        std::future<ReadbackResult> third = fixture.Readback(ring, 512);
+        CHECK(third.valid());
+        CHECK(ring.GetStatistics().Dropped == 2);
+
+        ring.FinishFrame(fixture.Fence, 2);
+        fixture.Fence->Complete(2);
+        waiter.Drain();
+    }
+}
+
+#if !defined(_WIN32)
+// Needs a device that fails Map on demand, which only the null device does.
+TEST(ReadbackRingFailsFuturesWithTheMapResult)
+{
+    ComPtr<ID3D12Device2> nullDevice = CreateNullDevice(std::chrono::microseconds(0));
+    ReadbackFixture fixture(nullDevice.Get());
+    FenceWaiter waiter;
+
+    {
+        ReadbackRing ring(nullDevice, waiter, 1);
+        std::future<ReadbackResult> future = fixture.Readback(ring, 256);
+        ring.FinishFrame(fixture.Fence, 1);
+
+        RemoveNullDevice(nullDevice);
+        fixture.Fence->Complete(1);
+        waiter.Drain();
+
+        HRESULT result = S_OK;
+        try
+        {
+            future.get();
+        }
+        catch (const HResultException& exception)
+        {
+            result = exception.GetResult();
+        }
+        CHECK(result == DXGI_ERROR_DEVICE_REMOVED);
+
+        // The slot is free again rather than held by a result that never came.
+        ReadbackRingStatistics statistics = ring.GetStatistics();
+        CHECK(statistics.InFlight == 0);
+        CHECK(statistics.Held == 0);
+        CHECK(statistics.Completed == 1);
+    }
+}
+#endif
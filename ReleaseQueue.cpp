@@ -0,0 +1,87 @@
+#include "ReleaseQueue.h"
+
+#include <algorithm>
+
+ReleaseQueue::ReleaseQueue()
+    : m_Statistics()
+{
+}
+
+ReleaseQueue::~ReleaseQueue()
+{
+    for (Batch& batch : m_Batches)
+    {
+        Finish(batch);
+    }
+}
+
+void ReleaseQueue::Release(Microsoft::WRL::ComPtr<IUnknown> object, const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    GetBatch(fence, fenceValue).Objects.push_back(std::move(object));
+}
+
+void ReleaseQueue::Release(std::function<void()> release, const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    GetBatch(fence, fenceValue).Callbacks.push_back(std::move(release));
+}
+
+void ReleaseQueue::Collect()
+{
+    std::vector<Batch> completed;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        while (!m_Batches.empty() && m_Batches.front().Fence->GetCompletedValue() >= m_Batches.front().FenceValue)
+        {
+            size_t count = m_Batches.front().Objects.size() + m_Batches.front().Callbacks.size();
+            m_Statistics.Pending -= count;
+            m_Statistics.Released += count;
+
+            completed.push_back(std::move(m_Batches.front()));
+            m_Batches.pop_front();
+        }
+
+        m_Statistics.Batches = m_Batches.size();
+    }
+
+    for (Batch& batch : completed)
+    {
+        Finish(batch);
+    }
+}
+
+ReleaseQueueStatistics ReleaseQueue::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return m_Statistics;
+}
+
+ReleaseQueue::Batch& ReleaseQueue::GetBatch(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue)
+{
+    if(m_Batches.empty() || m_Batches.back().Fence.Get() != fence.Get() || m_Batches.back().FenceValue != fenceValue)
+    {
+        m_Batches.push_back({fence, fenceValue, {}, {}});
+        m_Statistics.Batches = m_Batches.size();
+    }
+
+    ++m_Statistics.Pending;
+    m_Statistics.PeakPending = std::max(m_Statistics.PeakPending, m_Statistics.Pending);
+
+    return m_Batches.back();
+}
+
+void ReleaseQueue::Finish(Batch& batch)
+{
+    for (std::function<void()>& callback : batch.Callbacks)
+    {
+        callback();
+    }
+
+    batch.Objects.clear();
+}
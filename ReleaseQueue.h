@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+struct ReleaseQueueStatistics
+{
+    // Releases waiting for their fence, the batches they are in, and the most that ever waited at once.
+    size_t Pending;
+    size_t Batches;
+    size_t PeakPending;
+    // Releases carried out so far.
+    uint64_t Released;
+};
+
+// Keeps what the GPU may still be using alive until a fence passes the value it was released with, so
+// dropping a resource mid-run costs no Flush. Releases with the same fence value share a batch, and
+// Collect carries out whole batches, oldest first; they are expected in submission order. Safe to use
+// from several threads.
+class ReleaseQueue
+{
+public:
+    ReleaseQueue();
+    // Carries out everything still queued, so the GPU must be idle by then.
+    ~ReleaseQueue();
+
+    ReleaseQueue(const ReleaseQueue&) = delete;
+    ReleaseQueue& operator=(const ReleaseQueue&) = delete;
+
+    // Resources, heaps, pipeline states or anything else COM.
+    void Release(Microsoft::WRL::ComPtr<IUnknown> object, const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue);
+
+    // For what isn't a COM object, such as a range of a suballocator.
+    void Release(std::function<void()> release, const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue);
+
+    // Carries out the batches whose fence has passed, outside the lock. One GetCompletedValue when none
+    // has, so it can be called every frame.
+    void Collect();
+
+    ReleaseQueueStatistics GetStatistics() const;
+
+private:
+    struct Batch
+    {
+        Microsoft::WRL::ComPtr<ID3D12Fence> Fence;
+        uint64_t FenceValue;
+        std::vector<Microsoft::WRL::ComPtr<IUnknown>> Objects;
+        std::vector<std::function<void()>> Callbacks;
+    };
+
+    // Call with m_Mutex held.
+    Batch& GetBatch(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue);
+
+    static void Finish(Batch& batch);
+
+    mutable std::mutex m_Mutex;
+    std::deque<Batch> m_Batches;
+    ReleaseQueueStatistics m_Statistics;
+};
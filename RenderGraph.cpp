@@ -0,0 +1,607 @@
+#include "RenderGraph.h"
+#include "MemoryHelpers.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <algorithm>
+
+namespace
+{
+    // States that only read, which can be combined into one.
+    const D3D12_RESOURCE_STATES g_ReadStates =
+        D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER |
+        D3D12_RESOURCE_STATE_INDEX_BUFFER |
+        D3D12_RESOURCE_STATE_DEPTH_READ |
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE |
+        D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE |
+        D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT |
+        D3D12_RESOURCE_STATE_COPY_SOURCE |
+        D3D12_RESOURCE_STATE_RESOLVE_SOURCE;
+
+    bool IsReadState(D3D12_RESOURCE_STATES state)
+    {
+        return state != D3D12_RESOURCE_STATE_COMMON && (state & ~g_ReadStates) == 0;
+    }
+
+    void AppendAccesses(std::vector<uint32_t>& signature, const std::vector<RenderGraphAccess>& accesses)
+    {
+        signature.push_back(static_cast<uint32_t>(accesses.size()));
+        for (const RenderGraphAccess& access : accesses)
+        {
+            signature.push_back(access.Resource);
+            signature.push_back(static_cast<uint32_t>(access.State));
+        }
+    }
+}
+
+RenderGraph::RenderGraph(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, CommandAllocatorPool& allocatorPool, ReleaseQueue& releaseQueue)
+    : m_Device(device)
+    , m_AllocatorPool(allocatorPool)
+    , m_ReleaseQueue(releaseQueue)
+    , m_ResourceHeapTier(D3D12_RESOURCE_HEAP_TIER_1)
+    , m_Statistics()
+{
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+    if(SUCCEEDED(m_Device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))))
+    {
+        m_ResourceHeapTier = options.ResourceHeapTier;
+    }
+}
+
+RenderGraph::~RenderGraph()
+{
+    RetireTransientResources();
+}
+
+void RenderGraph::Reset()
+{
+    m_Passes.clear();
+    m_Resources.clear();
+    m_Outputs.clear();
+    m_Transients.clear();
+}
+
+RenderGraphResource RenderGraph::ImportResource(ID3D12Resource* resource)
+{
+    m_Resources.push_back(resource);
+
+    return static_cast<RenderGraphResource>(m_Resources.size() - 1);
+}
+
+RenderGraphResource RenderGraph::CreateTransientResource(const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* clearValue)
+{
+    RenderGraphResource resource = ImportResource(nullptr);
+
+    TransientResource transient = {resource, desc, clearValue != nullptr, {}};
+    if(clearValue)
+    {
+        transient.ClearValue = *clearValue;
+    }
+    m_Transients.push_back(transient);
+
+    return resource;
+}
+
+ID3D12Resource* RenderGraph::GetResource(RenderGraphResource resource) const
+{
+    return m_Resources[resource];
+}
+
+void RenderGraph::AddPass(
+    const char* name,
+    std::vector<RenderGraphAccess> reads,
+    std::vector<RenderGraphAccess> writes,
+    ExecuteFunction execute,
+    RenderGraphPassFlags flags)
+{
+    m_Passes.push_back({name, std::move(reads), std::move(writes), std::move(execute), nullptr, flags});
+}
+
+void RenderGraph::AddExternalPass(
+    const char* name,
+    std::vector<RenderGraphAccess> reads,
+    std::vector<RenderGraphAccess> writes,
+    ExecuteExternalFunction execute,
+    RenderGraphPassFlags flags)
+{
+    m_Passes.push_back({name, std::move(reads), std::move(writes), nullptr, std::move(execute), flags});
+}
+
+void RenderGraph::SetOutput(RenderGraphResource resource, D3D12_RESOURCE_STATES state)
+{
+    m_Outputs.push_back({resource, state});
+}
+
+void RenderGraph::Execute(std::vector<TrackedCommandList>& commandLists)
+{
+    std::vector<uint32_t> signature;
+    BuildSignature(signature);
+    if(signature != m_Signature)
+    {
+        m_Signature = std::move(signature);
+        Compile();
+        ++m_Statistics.Compiles;
+    }
+    else
+    {
+        ++m_Statistics.Reuses;
+    }
+
+    for (size_t i = 0; i < m_Transients.size(); ++i)
+    {
+        m_Resources[m_Transients[i].Resource] = m_TransientResources[i].Get();
+    }
+
+    ID3D12GraphicsCommandList* commandList = nullptr;
+    std::vector<AliasingBarrier> activations;
+
+    for (const RenderGraphCompiledPass& compiledPass : m_CompiledPasses)
+    {
+        if(!commandList)
+        {
+            commandList = BeginCommandList(commandLists);
+        }
+
+        ResourceStateTracker& tracker = *m_Trackers[m_Allocators.size() - 1];
+
+        // An inactive aliased resource must not be transitioned, so the activation is the first barrier
+        // to touch it. The enhanced backend's discard puts it in its first state; the legacy backend's
+        // aliasing barrier leaves it in the one the last frame ended it in, so a transition follows.
+        activations.clear();
+        for (const RenderGraphAccess& activation : compiledPass.Activations)
+        {
+            activations.push_back({m_Resources[activation.Resource], m_TransientStates[activation.Resource], activation.State});
+        }
+        tracker.Alias(commandList, activations.data(), static_cast<UINT>(activations.size()));
+
+        for (const RenderGraphAccess& transition : compiledPass.Transitions)
+        {
+            tracker.Transition(m_Resources[transition.Resource], transition.State);
+        }
+        tracker.FlushBarriers(commandList);
+
+        for (RenderGraphResource resource : compiledPass.Discards)
+        {
+            commandList->DiscardResource(m_Resources[resource], nullptr);
+        }
+
+        const Pass& pass = m_Passes[compiledPass.Pass];
+        if(pass.ExecuteExternal)
+        {
+            ThrowIfFailed(commandList->Close());
+            commandList = nullptr;
+
+            pass.ExecuteExternal(commandLists);
+        }
+        else
+        {
+            pass.Execute(commandList);
+        }
+    }
+
+    if(!m_FinalTransitions.empty())
+    {
+        if(!commandList)
+        {
+            commandList = BeginCommandList(commandLists);
+        }
+
+        ResourceStateTracker& tracker = *m_Trackers[m_Allocators.size() - 1];
+        for (const RenderGraphAccess& transition : m_FinalTransitions)
+        {
+            tracker.Transition(m_Resources[transition.Resource], transition.State);
+        }
+        tracker.FlushBarriers(commandList);
+    }
+
+    if(commandList)
+    {
+        ThrowIfFailed(commandList->Close());
+    }
+
+    m_TransientStates = m_TransientEndStates;
+}
+
+void RenderGraph::Release(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue)
+{
+    for (Microsoft::WRL::ComPtr<ID3D12CommandAllocator>& allocator : m_Allocators)
+    {
+        m_AllocatorPool.Release(D3D12_COMMAND_LIST_TYPE_DIRECT, std::move(allocator), fence, fenceValue);
+    }
+
+    m_Allocators.clear();
+
+    for (Microsoft::WRL::ComPtr<IUnknown>& memory : m_RetiredTransientMemory)
+    {
+        m_ReleaseQueue.Release(std::move(memory), fence, fenceValue);
+    }
+
+    m_RetiredTransientMemory.clear();
+}
+
+RenderGraphStatistics RenderGraph::GetStatistics() const
+{
+    return m_Statistics;
+}
+
+ResourceStateTrackerStatistics RenderGraph::GetBarrierStatistics() const
+{
+    ResourceStateTrackerStatistics statistics = {};
+
+    for (size_t i = 0; i < m_Allocators.size(); ++i)
+    {
+        ResourceStateTrackerStatistics trackerStatistics = m_Trackers[i]->GetStatistics();
+        statistics.Requested += trackerStatistics.Requested;
+        statistics.Recorded += trackerStatistics.Recorded;
+        statistics.Eliminated += trackerStatistics.Eliminated;
+    }
+
+    return statistics;
+}
+
+const std::vector<RenderGraphCompiledPass>& RenderGraph::GetCompiledPasses() const
+{
+    return m_CompiledPasses;
+}
+
+const std::vector<RenderGraphAccess>& RenderGraph::GetFinalTransitions() const
+{
+    return m_FinalTransitions;
+}
+
+RenderGraphPlacement RenderGraph::GetTransientPlacement(RenderGraphResource resource) const
+{
+    for (size_t i = 0; i < m_Transients.size() && i < m_TransientPlacements.size(); ++i)
+    {
+        if(m_Transients[i].Resource == resource)
+        {
+            return m_TransientPlacements[i];
+        }
+    }
+
+    return {nullptr, 0};
+}
+
+void RenderGraph::Compile()
+{
+    const uint32_t passCount = static_cast<uint32_t>(m_Passes.size());
+    const uint32_t resourceCount = static_cast<uint32_t>(m_Resources.size());
+
+    // Cull: walking backwards, a pass is live if it writes something a live pass or an output needs, or
+    // has side effects.
+    // Writes keep the earlier contents, so a resource stays needed above its writers.
+    std::vector<bool> needed(resourceCount, false);
+    for (const RenderGraphAccess& output : m_Outputs)
+    {
+        needed[output.Resource] = true;
+    }
+
+    std::vector<bool> live(passCount, false);
+    for (uint32_t i = passCount; i-- > 0;)
+    {
+        live[i] = (m_Passes[i].Flags & RenderGraphPassFlags_SideEffects) != 0;
+        for (const RenderGraphAccess& write : m_Passes[i].Writes)
+        {
+            live[i] = live[i] || needed[write.Resource];
+        }
+
+        if(live[i])
+        {
+            for (const RenderGraphAccess& read : m_Passes[i].Reads)
+            {
+                needed[read.Resource] = true;
+            }
+        }
+    }
+
+    // Live passes run in the order they were added.
+    std::vector<uint32_t> order;
+    for (uint32_t i = 0; i < passCount; ++i)
+    {
+        if(live[i])
+        {
+            order.push_back(i);
+        }
+    }
+
+    // Transitions: only where the state changes. A read in another read state, with no write since the
+    // last transition, is folded into that transition instead of getting one of its own.
+    constexpr size_t noTransition = SIZE_MAX;
+    std::vector<D3D12_RESOURCE_STATES> states(resourceCount, D3D12_RESOURCE_STATES(-1));
+    std::vector<std::pair<size_t, size_t>> lastTransition(resourceCount, {noTransition, noTransition});
+
+    m_CompiledPasses.clear();
+    m_FinalTransitions.clear();
+    m_Statistics.Transitions = 0;
+
+    std::vector<int64_t> transientIndices(resourceCount, -1);
+    for (size_t i = 0; i < m_Transients.size(); ++i)
+    {
+        transientIndices[m_Transients[i].Resource] = static_cast<int64_t>(i);
+    }
+
+    for (uint32_t pass : order)
+    {
+        m_CompiledPasses.push_back({pass, {}, {}, {}});
+        RenderGraphCompiledPass& compiledPass = m_CompiledPasses.back();
+
+        // A resource both read and written by the pass takes the write state.
+        std::vector<RenderGraphAccess> accesses = m_Passes[pass].Reads;
+        for (const RenderGraphAccess& write : m_Passes[pass].Writes)
+        {
+            auto read = std::find_if(accesses.begin(), accesses.end(), [&write](const RenderGraphAccess& access)
+            {
+                return access.Resource == write.Resource;
+            });
+            if(read != accesses.end())
+            {
+                read->State = write.State;
+            }
+            else
+            {
+                accesses.push_back(write);
+            }
+        }
+
+        for (const RenderGraphAccess& access : accesses)
+        {
+            D3D12_RESOURCE_STATES& state = states[access.Resource];
+            if(state == access.State)
+            {
+                continue;
+            }
+
+            const std::pair<size_t, size_t>& last = lastTransition[access.Resource];
+            if(IsReadState(access.State) && IsReadState(state) && last.first != noTransition)
+            {
+                state |= access.State;
+                m_CompiledPasses[last.first].Transitions[last.second].State = state;
+                continue;
+            }
+
+            int64_t transient = transientIndices[access.Resource];
+            if(transient >= 0 && last.first == noTransition && IsRenderTargetOrDepthStencil(m_Transients[transient].Desc) &&
+                (access.State == D3D12_RESOURCE_STATE_RENDER_TARGET || access.State == D3D12_RESOURCE_STATE_DEPTH_WRITE))
+            {
+                compiledPass.Discards.push_back(access.Resource);
+            }
+
+            state = access.State;
+            lastTransition[access.Resource] = {m_CompiledPasses.size() - 1, compiledPass.Transitions.size()};
+            compiledPass.Transitions.push_back(access);
+            ++m_Statistics.Transitions;
+        }
+    }
+
+    for (const RenderGraphAccess& output : m_Outputs)
+    {
+        if(states[output.Resource] != output.State)
+        {
+            m_FinalTransitions.push_back(output);
+            ++m_Statistics.Transitions;
+            states[output.Resource] = output.State;
+        }
+    }
+    m_TransientEndStates = std::move(states);
+
+    m_Statistics.Passes = passCount;
+    m_Statistics.CulledPasses = passCount - static_cast<uint32_t>(order.size());
+
+    RetireTransientResources();
+    AllocateTransientResources();
+}
+
+void RenderGraph::AllocateTransientResources()
+{
+    const uint32_t passCount = static_cast<uint32_t>(m_CompiledPasses.size());
+
+    // Lifetimes in compiled passes; outputs live until the end of the frame.
+    std::vector<TransientMemoryRequest> requests(m_Transients.size(), {0, 0, UINT32_MAX, 0});
+    std::vector<D3D12_RESOURCE_STATES> firstStates(m_Transients.size(), D3D12_RESOURCE_STATE_COMMON);
+    std::vector<int64_t> transientIndices(m_Resources.size(), -1);
+    for (size_t i = 0; i < m_Transients.size(); ++i)
+    {
+        transientIndices[m_Transients[i].Resource] = static_cast<int64_t>(i);
+    }
+
+    for (uint32_t i = 0; i < passCount; ++i)
+    {
+        for (const RenderGraphAccess& transition : m_CompiledPasses[i].Transitions)
+        {
+            int64_t transient = transientIndices[transition.Resource];
+            if(transient >= 0 && requests[transient].FirstPass == UINT32_MAX)
+            {
+                firstStates[transient] = transition.State;
+            }
+        }
+
+        const Pass& pass = m_Passes[m_CompiledPasses[i].Pass];
+        for (const std::vector<RenderGraphAccess>* accesses : {&pass.Reads, &pass.Writes})
+        {
+            for (const RenderGraphAccess& access : *accesses)
+            {
+                int64_t transient = transientIndices[access.Resource];
+                if(transient >= 0)
+                {
+                    requests[transient].FirstPass = std::min(requests[transient].FirstPass, i);
+                    requests[transient].LastPass = i;
+                }
+            }
+        }
+    }
+
+    for (const RenderGraphAccess& output : m_Outputs)
+    {
+        int64_t transient = transientIndices[output.Resource];
+        if(transient >= 0 && requests[transient].FirstPass != UINT32_MAX)
+        {
+            requests[transient].LastPass = passCount;
+        }
+    }
+
+    m_TransientResources.resize(m_Transients.size());
+    m_TransientPlacements.assign(m_Transients.size(), {nullptr, 0});
+    m_TransientStates.assign(m_Resources.size(), D3D12_RESOURCE_STATE_COMMON);
+    m_Statistics.TransientMemory = 0;
+    m_Statistics.TransientMemorySaved = 0;
+
+    // On heap tier 2 every transient resource can share one heap.
+    std::vector<D3D12_HEAP_FLAGS> categories = {D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES};
+    if(m_ResourceHeapTier == D3D12_RESOURCE_HEAP_TIER_1)
+    {
+        categories = {D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS, D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES, D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES};
+    }
+
+    for (D3D12_HEAP_FLAGS category : categories)
+    {
+        std::vector<size_t> members;
+        std::vector<TransientMemoryRequest> categoryRequests;
+        uint64_t heapAlignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        for (size_t i = 0; i < m_Transients.size(); ++i)
+        {
+            if(requests[i].FirstPass == UINT32_MAX ||
+                (category != D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES && GetHeapCategory(m_Transients[i].Desc) != category))
+            {
+                continue;
+            }
+
+            D3D12_RESOURCE_ALLOCATION_INFO info = m_Device->GetResourceAllocationInfo(0, 1, &m_Transients[i].Desc);
+            requests[i].Size = info.SizeInBytes;
+            requests[i].Alignment = info.Alignment;
+            heapAlignment = std::max<uint64_t>(heapAlignment, info.Alignment);
+
+            members.push_back(i);
+            categoryRequests.push_back(requests[i]);
+        }
+
+        if(members.empty())
+        {
+            continue;
+        }
+
+        TransientMemoryPlan plan = PlanTransientMemory(categoryRequests);
+
+        CD3DX12_HEAP_DESC heapDesc(AlignUp(plan.HeapSize, heapAlignment), D3D12_HEAP_TYPE_DEFAULT, heapAlignment, category);
+        Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+        ThrowIfFailed(m_Device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap)));
+
+        for (size_t j = 0; j < members.size(); ++j)
+        {
+            const TransientResource& transient = m_Transients[members[j]];
+
+            // Buffers are always created in the common state.
+            D3D12_RESOURCE_STATES initialState = transient.Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER
+                ? D3D12_RESOURCE_STATE_COMMON
+                : firstStates[members[j]];
+
+            Microsoft::WRL::ComPtr<ID3D12Resource>& resource = m_TransientResources[members[j]];
+            ThrowIfFailed(m_Device->CreatePlacedResource(
+                heap.Get(),
+                plan.Offsets[j],
+                &transient.Desc,
+                initialState,
+                transient.HasClearValue ? &transient.ClearValue : nullptr,
+                IID_PPV_ARGS(&resource)));
+            ResourceStateTracker::AddGlobalState(resource.Get(), initialState);
+            m_TransientStates[transient.Resource] = initialState;
+            m_TransientPlacements[members[j]] = {heap.Get(), plan.Offsets[j]};
+
+            if(plan.Aliased[j])
+            {
+                m_CompiledPasses[categoryRequests[j].FirstPass].Activations.push_back({transient.Resource, firstStates[members[j]]});
+            }
+        }
+
+        m_TransientHeaps.push_back(heap);
+        m_Statistics.TransientMemory += heapDesc.SizeInBytes;
+        m_Statistics.TransientMemorySaved += plan.SavedSize;
+    }
+}
+
+void RenderGraph::RetireTransientResources()
+{
+    for (Microsoft::WRL::ComPtr<ID3D12Resource>& resource : m_TransientResources)
+    {
+        if(resource)
+        {
+            ResourceStateTracker::RemoveGlobalState(resource.Get());
+            m_RetiredTransientMemory.push_back(std::move(resource));
+        }
+    }
+    m_TransientResources.clear();
+    m_TransientPlacements.clear();
+
+    for (Microsoft::WRL::ComPtr<ID3D12Heap>& heap : m_TransientHeaps)
+    {
+        m_RetiredTransientMemory.push_back(std::move(heap));
+    }
+    m_TransientHeaps.clear();
+}
+
+void RenderGraph::BuildSignature(std::vector<uint32_t>& signature) const
+{
+    signature.push_back(static_cast<uint32_t>(m_Resources.size()));
+    signature.push_back(static_cast<uint32_t>(m_Passes.size()));
+    for (const Pass& pass : m_Passes)
+    {
+        signature.push_back(pass.ExecuteExternal ? 1 : 0);
+        signature.push_back(static_cast<uint32_t>(pass.Flags));
+        AppendAccesses(signature, pass.Reads);
+        AppendAccesses(signature, pass.Writes);
+    }
+    AppendAccesses(signature, m_Outputs);
+
+    signature.push_back(static_cast<uint32_t>(m_Transients.size()));
+    for (const TransientResource& transient : m_Transients)
+    {
+        const D3D12_RESOURCE_DESC& desc = transient.Desc;
+        signature.insert(signature.end(), {
+            transient.Resource,
+            static_cast<uint32_t>(desc.Dimension),
+            static_cast<uint32_t>(desc.Alignment),
+            static_cast<uint32_t>(desc.Alignment >> 32),
+            static_cast<uint32_t>(desc.Width),
+            static_cast<uint32_t>(desc.Width >> 32),
+            desc.Height,
+            desc.DepthOrArraySize,
+            desc.MipLevels,
+            static_cast<uint32_t>(desc.Format),
+            desc.SampleDesc.Count,
+            desc.SampleDesc.Quality,
+            static_cast<uint32_t>(desc.Layout),
+            static_cast<uint32_t>(desc.Flags),
+            transient.HasClearValue ? 1u : 0u});
+
+        if(transient.HasClearValue)
+        {
+            const uint32_t* clearValue = reinterpret_cast<const uint32_t*>(&transient.ClearValue.Color);
+            signature.push_back(static_cast<uint32_t>(transient.ClearValue.Format));
+            signature.insert(signature.end(), clearValue, clearValue + 4);
+        }
+    }
+}
+
+ID3D12GraphicsCommandList* RenderGraph::BeginCommandList(std::vector<TrackedCommandList>& commandLists)
+{
+    size_t index = m_Allocators.size();
+
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator = m_AllocatorPool.Acquire(D3D12_COMMAND_LIST_TYPE_DIRECT);
+    if(index < m_CommandLists.size())
+    {
+        ThrowIfFailed(m_CommandLists[index]->Reset(allocator.Get(), nullptr));
+        m_Trackers[index]->Reset();
+    }
+    else
+    {
+        m_CommandLists.emplace_back();
+        ThrowIfFailed(m_Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&m_CommandLists.back())));
+        m_Trackers.push_back(std::make_unique<ResourceStateTracker>());
+    }
+    m_Allocators.push_back(std::move(allocator));
+
+    commandLists.push_back({m_CommandLists[index].Get(), m_Trackers[index].get()});
+
+    return m_CommandLists[index].Get();
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "CommandAllocatorPool.h"
+#include "ReleaseQueue.h"
+#include "ResourceStateTracker.h"
+#include "TransientMemoryPlanner.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef uint32_t RenderGraphResource;
+
+struct RenderGraphAccess
+{
+    RenderGraphResource Resource;
+    D3D12_RESOURCE_STATES State;
+};
+
+enum RenderGraphPassFlags
+{
+    RenderGraphPassFlags_None = 0,
+    // The pass has an effect outside the graph, e.g. it reads a resource back to the CPU, so it runs even
+    // when nothing reaching an output depends on it. It still only runs where it is declared.
+    RenderGraphPassFlags_SideEffects = 1
+};
+
+struct RenderGraphStatistics
+{
+    // Frames that had to compile the graph, and frames that reused the previous compile.
+    uint64_t Compiles;
+    uint64_t Reuses;
+    // Of the last frame.
+    uint32_t Passes;
+    uint32_t CulledPasses;
+    uint32_t Transitions;
+    // Heap memory behind the transient resources, and how much aliasing them saves.
+    uint64_t TransientMemory;
+    uint64_t TransientMemorySaved;
+};
+
+// What a compile decided for one live pass.
+struct RenderGraphCompiledPass
+{
+    // The pass's index in the order the passes were added.
+    uint32_t Pass;
+    // Transitions to record before the pass runs.
+    std::vector<RenderGraphAccess> Transitions;
+    // Transient resources first used by the pass, with the state they are first used in.
+    std::vector<RenderGraphAccess> Activations;
+    std::vector<RenderGraphResource> Discards;
+};
+
+// Where a compile placed a transient resource. Heap is null for those no live pass uses.
+struct RenderGraphPlacement
+{
+    ID3D12Heap* Heap;
+    uint64_t Offset;
+};
+
+// The frame as a list of passes that declare the state they need each resource in. Passes run in the
+// order they are added, so each has to come after the passes whose results it uses. Compiling drops
+// passes that nothing reaching an output depends on, and works out the fewest transitions between the
+// rest; consecutive reads share one combined read state.
+//
+// The graph is declared again every frame, but is only compiled again when its structure (passes,
+// accesses and outputs) differs from the previous frame. Which ID3D12Resource an imported resource
+// refers to may change without a compile.
+//
+// Transient resources belong to the graph and only live from their first to their last pass. They
+// are placed in heaps shared with each other, so those that are never alive at the same time share
+// memory. Their contents don't survive from one frame to the next.
+class RenderGraph
+{
+public:
+    typedef std::function<void(ID3D12GraphicsCommandList* commandList)> ExecuteFunction;
+    // Appends lists of its own, already closed, in the order they are to be submitted.
+    typedef std::function<void(std::vector<TrackedCommandList>& commandLists)> ExecuteExternalFunction;
+
+    // Transient memory a compile replaces goes to releaseQueue.
+    RenderGraph(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, CommandAllocatorPool& allocatorPool, ReleaseQueue& releaseQueue);
+    ~RenderGraph();
+
+    // Starts declaring the next frame.
+    void Reset();
+
+    // The resource must have a global state in ResourceStateTracker.
+    RenderGraphResource ImportResource(ID3D12Resource* resource);
+
+    // Render targets and depth stencils are discarded before their first pass, which has to write them
+    // as such. Other transient resources have to be fully written by their first pass.
+    RenderGraphResource CreateTransientResource(const D3D12_RESOURCE_DESC& desc, const D3D12_CLEAR_VALUE* clearValue = nullptr);
+
+    // For passes to create views with. Transient resources only exist once Execute has started.
+    ID3D12Resource* GetResource(RenderGraphResource resource) const;
+
+    // Writes keep what was in the resource before, so earlier writers are not culled.
+    void AddPass(
+        const char* name,
+        std::vector<RenderGraphAccess> reads,
+        std::vector<RenderGraphAccess> writes,
+        ExecuteFunction execute,
+        RenderGraphPassFlags flags = RenderGraphPassFlags_None);
+
+    // For passes that record into lists of their own, e.g. in parallel. Their transitions are recorded at
+    // the end of the graph's list before them.
+    void AddExternalPass(
+        const char* name,
+        std::vector<RenderGraphAccess> reads,
+        std::vector<RenderGraphAccess> writes,
+        ExecuteExternalFunction execute,
+        RenderGraphPassFlags flags = RenderGraphPassFlags_None);
+
+    // The state the resource is left in after the frame. Only passes that contribute to an output run.
+    void SetOutput(RenderGraphResource resource, D3D12_RESOURCE_STATES state);
+
+    // Compiles if needed and records the live passes. Appends the lists to submit, in order.
+    void Execute(std::vector<TrackedCommandList>& commandLists);
+
+    // Hands the allocators of the last Execute back to the pool once the GPU has passed fenceValue.
+    // Transient memory replaced by the last compile is queued for release behind the same value.
+    void Release(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue);
+
+    RenderGraphStatistics GetStatistics() const;
+
+    // Summed over the graph's own lists for the last Execute, once they have been resolved.
+    ResourceStateTrackerStatistics GetBarrierStatistics() const;
+
+    // The live passes of the last compile, in the order they run, and the transitions recorded after
+    // them to leave the outputs in their states. For tests and debugging.
+    const std::vector<RenderGraphCompiledPass>& GetCompiledPasses() const;
+    const std::vector<RenderGraphAccess>& GetFinalTransitions() const;
+    RenderGraphPlacement GetTransientPlacement(RenderGraphResource resource) const;
+
+private:
+    struct Pass
+    {
+        std::string Name;
+        std::vector<RenderGraphAccess> Reads;
+        std::vector<RenderGraphAccess> Writes;
+        ExecuteFunction Execute;
+        ExecuteExternalFunction ExecuteExternal;
+        RenderGraphPassFlags Flags;
+    };
+
+    struct TransientResource
+    {
+        RenderGraphResource Resource;
+        D3D12_RESOURCE_DESC Desc;
+        bool HasClearValue;
+        D3D12_CLEAR_VALUE ClearValue;
+    };
+
+    void Compile();
+    // Plans and creates the transient resources for the compiled passes. Textures are created in the
+    // state of their first transition, so that needs no barrier.
+    void AllocateTransientResources();
+    void RetireTransientResources();
+    void BuildSignature(std::vector<uint32_t>& signature) const;
+
+    // Resets the next of the graph's lists for recording.
+    ID3D12GraphicsCommandList* BeginCommandList(std::vector<TrackedCommandList>& commandLists);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    CommandAllocatorPool& m_AllocatorPool;
+    ReleaseQueue& m_ReleaseQueue;
+
+    // Declared this frame.
+    std::vector<Pass> m_Passes;
+    std::vector<ID3D12Resource*> m_Resources;
+    std::vector<RenderGraphAccess> m_Outputs;
+    std::vector<TransientResource> m_Transients;
+
+    // The last compile and the structure it was compiled from.
+    std::vector<uint32_t> m_Signature;
+    std::vector<RenderGraphCompiledPass> m_CompiledPasses;
+    std::vector<RenderGraphAccess> m_FinalTransitions;
+
+    // Heap tier 1 keeps buffers, render target and depth stencil textures, and other textures apart.
+    D3D12_RESOURCE_HEAP_TIER m_ResourceHeapTier;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Heap>> m_TransientHeaps;
+    // One per transient resource, null for those no live pass uses.
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_TransientResources;
+    std::vector<RenderGraphPlacement> m_TransientPlacements;
+    // By resource, of which only the transient ones count: the state each is in when a frame starts, the
+    // one it was created in until the first frame has run, and the state the compiled frame leaves it in.
+    std::vector<D3D12_RESOURCE_STATES> m_TransientStates;
+    std::vector<D3D12_RESOURCE_STATES> m_TransientEndStates;
+    // Replaced by the last compile, until Release knows the fence value to queue it behind.
+    std::vector<Microsoft::WRL::ComPtr<IUnknown>> m_RetiredTransientMemory;
+
+    std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>> m_CommandLists;
+    std::vector<std::unique_ptr<ResourceStateTracker>> m_Trackers;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> m_Allocators;
+
+    RenderGraphStatistics m_Statistics;
+};
@@ -0,0 +1,443 @@
+#include "ResourceAllocator.h"
+#include "HashHelpers.h"
+#include "MemoryHelpers.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <algorithm>
+
+namespace
+{
+    bool IsInUse(const Microsoft::WRL::ComPtr<ID3D12Heap>& heap, const ResourceAllocation& page)
+    {
+        return heap || page.Resource;
+    }
+}
+
+bool ResourceAllocator::TextureKey::operator==(const TextureKey& other) const
+{
+    return Desc.Dimension == other.Desc.Dimension &&
+        Desc.Alignment == other.Desc.Alignment &&
+        Desc.Width == other.Desc.Width &&
+        Desc.Height == other.Desc.Height &&
+        Desc.DepthOrArraySize == other.Desc.DepthOrArraySize &&
+        Desc.MipLevels == other.Desc.MipLevels &&
+        Desc.Format == other.Desc.Format &&
+        Desc.SampleDesc.Count == other.Desc.SampleDesc.Count &&
+        Desc.SampleDesc.Quality == other.Desc.SampleDesc.Quality &&
+        Desc.Layout == other.Desc.Layout &&
+        Desc.Flags == other.Desc.Flags;
+}
+
+size_t ResourceAllocator::TextureKeyHash::operator()(const TextureKey& key) const
+{
+    uint64_t hash = g_FnvOffsetBasis;
+    Hash(hash, key.Desc.Dimension);
+    Hash(hash, key.Desc.Alignment);
+    Hash(hash, key.Desc.Width);
+    Hash(hash, key.Desc.Height);
+    Hash(hash, key.Desc.DepthOrArraySize);
+    Hash(hash, key.Desc.MipLevels);
+    Hash(hash, key.Desc.Format);
+    Hash(hash, key.Desc.SampleDesc.Count);
+    Hash(hash, key.Desc.SampleDesc.Quality);
+    Hash(hash, key.Desc.Layout);
+    Hash(hash, key.Desc.Flags);
+
+    return static_cast<size_t>(hash);
+}
+
+ResourceAllocator::ResourceAllocator(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, uint64_t heapSize)
+    : m_Device(device)
+    , m_HeapSize(heapSize)
+    , m_ResourceHeapTier(D3D12_RESOURCE_HEAP_TIER_1)
+    , m_CommittedResources(0)
+    , m_CommittedSize(0)
+    , m_Allocations(0)
+    , m_Allocated(0)
+{
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+    if(SUCCEEDED(m_Device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))))
+    {
+        m_ResourceHeapTier = options.ResourceHeapTier;
+    }
+}
+
+ResourceAllocation ResourceAllocator::Allocate(
+    D3D12_HEAP_TYPE heapType,
+    const D3D12_RESOURCE_DESC& desc,
+    D3D12_RESOURCE_STATES initialState,
+    const D3D12_CLEAR_VALUE* clearValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    ResourceAllocation allocation;
+    if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER && desc.Width < SmallBufferSize)
+    {
+        allocation = AllocateSmallBuffer(heapType, desc, initialState);
+    }
+    else
+    {
+        allocation = AllocatePlaced(heapType, desc, initialState, clearValue);
+    }
+
+    ++m_Allocations;
+    m_Allocated += allocation.Size;
+
+    return allocation;
+}
+
+void ResourceAllocator::Free(ResourceAllocation& allocation)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    --m_Allocations;
+    m_Allocated -= allocation.Size;
+
+    allocation.Resource.Reset();
+    if(allocation.Pool == DedicatedPool)
+    {
+        --m_CommittedResources;
+        m_CommittedSize -= allocation.Size;
+    }
+    else
+    {
+        FreeRange(allocation);
+    }
+
+    allocation = {};
+}
+
+ResourceAllocatorStatistics ResourceAllocator::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    ResourceAllocatorStatistics statistics = {};
+    statistics.CommittedResources = m_CommittedResources;
+    statistics.CommittedSize = m_CommittedSize;
+    statistics.Allocations = m_Allocations;
+    statistics.Allocated = m_Allocated;
+
+    uint64_t free = 0;
+    uint64_t fragmented = 0;
+    for (const Pool& pool : m_Pools)
+    {
+        for (const Block& block : pool.Blocks)
+        {
+            if(!block.Heap)
+            {
+                continue;
+            }
+
+            uint64_t blockFree = block.Allocator.GetCapacity() - block.Allocator.GetAllocated();
+            free += blockFree;
+            fragmented += blockFree - block.Allocator.GetLargestFreeRange();
+
+            ++statistics.Heaps;
+            statistics.Reserved += block.Allocator.GetCapacity();
+        }
+    }
+
+    if(free > 0)
+    {
+        statistics.Fragmentation = static_cast<double>(fragmented) / free;
+    }
+
+    return statistics;
+}
+
+const ResourceAllocator::TexturePlacement& ResourceAllocator::GetTexturePlacement(const D3D12_RESOURCE_DESC& desc)
+{
+    auto entry = m_TexturePlacements.find({desc});
+    if(entry != m_TexturePlacements.end())
+    {
+        return entry->second;
+    }
+
+    D3D12_RESOURCE_DESC placedDesc = desc;
+    D3D12_RESOURCE_ALLOCATION_INFO info;
+
+    // Small textures may be placed at 4KB, if the device agrees they are small enough.
+    bool smallTexture = desc.Alignment == 0 && desc.SampleDesc.Count <= 1 && !IsRenderTargetOrDepthStencil(desc);
+    if(smallTexture)
+    {
+        placedDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        info = m_Device->GetResourceAllocationInfo(0, 1, &placedDesc);
+        if(info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+        {
+            placedDesc.Alignment = 0;
+            info = m_Device->GetResourceAllocationInfo(0, 1, &placedDesc);
+        }
+    }
+    else
+    {
+        info = m_Device->GetResourceAllocationInfo(0, 1, &placedDesc);
+    }
+
+    return m_TexturePlacements.emplace(TextureKey{desc}, TexturePlacement{placedDesc.Alignment, info}).first->second;
+}
+
+uint32_t ResourceAllocator::GetPool(
+    D3D12_HEAP_TYPE heapType,
+    D3D12_HEAP_FLAGS heapFlags,
+    bool smallBuffers,
+    D3D12_RESOURCE_FLAGS resourceFlags,
+    D3D12_RESOURCE_STATES state)
+{
+    for (size_t i = 0; i < m_Pools.size(); ++i)
+    {
+        const Pool& pool = m_Pools[i];
+        if(pool.HeapType == heapType && pool.HeapFlags == heapFlags && pool.SmallBuffers == smallBuffers &&
+            pool.ResourceFlags == resourceFlags && pool.State == state)
+        {
+            return static_cast<uint32_t>(i);
+        }
+    }
+
+    m_Pools.push_back({heapType, heapFlags, smallBuffers, resourceFlags, state, {}, {}, 0});
+
+    return static_cast<uint32_t>(m_Pools.size() - 1);
+}
+
+ResourceAllocation ResourceAllocator::AllocatePlaced(
+    D3D12_HEAP_TYPE heapType,
+    const D3D12_RESOURCE_DESC& desc,
+    D3D12_RESOURCE_STATES initialState,
+    const D3D12_CLEAR_VALUE* clearValue)
+{
+    D3D12_RESOURCE_DESC placedDesc = desc;
+    D3D12_RESOURCE_ALLOCATION_INFO info;
+
+    if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        // Buffers always take whole 64KB blocks, so there is no need to ask the device.
+        info.SizeInBytes = AlignUp(desc.Width, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+        info.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    }
+    else
+    {
+        const TexturePlacement& placement = GetTexturePlacement(desc);
+        placedDesc.Alignment = placement.Alignment;
+        info = placement.Info;
+    }
+
+    ResourceAllocation allocation = {};
+
+    // Resources that would take most of a heap are better off on their own than leaving the rest of it
+    // hard to fill, and those aligned so coarsely that a heap may not fit them can't go in one.
+    if(info.SizeInBytes > m_HeapSize / 2 || info.SizeInBytes + info.Alignment > m_HeapSize)
+    {
+        CD3DX12_HEAP_PROPERTIES heapProperties(heapType);
+        ThrowIfFailed(m_Device->CreateCommittedResource(
+            &heapProperties,
+            D3D12_HEAP_FLAG_NONE,
+            &desc,
+            initialState,
+            clearValue,
+            IID_PPV_ARGS(&allocation.Resource)));
+
+        allocation.Size = info.SizeInBytes;
+        allocation.Pool = DedicatedPool;
+        ++m_CommittedResources;
+        m_CommittedSize += info.SizeInBytes;
+    }
+    else
+    {
+        D3D12_HEAP_FLAGS heapFlags = m_ResourceHeapTier == D3D12_RESOURCE_HEAP_TIER_1
+            ? GetHeapCategory(desc)
+            : D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+        allocation.Pool = GetPool(heapType, heapFlags, false, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COMMON);
+        Pool& pool = m_Pools[allocation.Pool];
+
+        if(!AllocateFromBlocks(pool, info.SizeInBytes, info.Alignment, allocation))
+        {
+            auto unused = std::find_if(pool.Blocks.begin(), pool.Blocks.end(), [](const Block& block)
+            {
+                return !IsInUse(block.Heap, block.Page);
+            });
+            if(unused == pool.Blocks.end())
+            {
+                pool.Blocks.push_back({nullptr, {}, TlsfAllocator(0, D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)});
+                unused = pool.Blocks.end() - 1;
+            }
+
+            // Textures that may be multisampled need their heap at 4MB.
+            bool msaa = heapType == D3D12_HEAP_TYPE_DEFAULT && heapFlags != D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+            CD3DX12_HEAP_DESC heapDesc(
+                m_HeapSize,
+                heapType,
+                msaa ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+                heapFlags);
+            ThrowIfFailed(m_Device->CreateHeap(&heapDesc, IID_PPV_ARGS(&unused->Heap)));
+            unused->Allocator = TlsfAllocator(m_HeapSize, D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT);
+
+            allocation.Block = static_cast<uint32_t>(unused - pool.Blocks.begin());
+            allocation.Range = unused->Allocator.Allocate(info.SizeInBytes, info.Alignment);
+            if(allocation.Range == TlsfAllocator::InvalidAllocation)
+            {
+                // Not on any free level list yet, so the block would never be used or released again.
+                unused->Heap.Reset();
+                ThrowIfFailed(E_OUTOFMEMORY);
+            }
+            UpdateFreeLevel(pool, allocation.Block);
+        }
+
+        Block& block = pool.Blocks[allocation.Block];
+        allocation.Size = block.Allocator.GetSize(allocation.Range);
+
+        HRESULT result = m_Device->CreatePlacedResource(
+            block.Heap.Get(),
+            block.Allocator.GetOffset(allocation.Range),
+            &placedDesc,
+            initialState,
+            clearValue,
+            IID_PPV_ARGS(&allocation.Resource));
+        if(FAILED(result))
+        {
+            FreeRange(allocation);
+            ThrowIfFailed(result);
+        }
+    }
+
+    if(desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        allocation.GpuAddress = allocation.Resource->GetGPUVirtualAddress();
+    }
+
+    return allocation;
+}
+
+ResourceAllocation ResourceAllocator::AllocateSmallBuffer(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState)
+{
+    ResourceAllocation allocation = {};
+    allocation.Pool = GetPool(heapType, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS, true, desc.Flags, initialState);
+
+    if(!AllocateFromBlocks(m_Pools[allocation.Pool], desc.Width, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, allocation))
+    {
+        // Placing the page can add pools, so look this one up again afterwards.
+        ResourceAllocation page = AllocatePlaced(heapType, CD3DX12_RESOURCE_DESC::Buffer(SmallBufferPageSize, desc.Flags), initialState, nullptr);
+
+        std::vector<Block>& blocks = m_Pools[allocation.Pool].Blocks;
+        auto unused = std::find_if(blocks.begin(), blocks.end(), [](const Block& block)
+        {
+            return !IsInUse(block.Heap, block.Page);
+        });
+        if(unused == blocks.end())
+        {
+            blocks.push_back({nullptr, {}, TlsfAllocator(0, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT)});
+            unused = blocks.end() - 1;
+        }
+
+        unused->Page = std::move(page);
+        unused->Allocator = TlsfAllocator(SmallBufferPageSize, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+        allocation.Block = static_cast<uint32_t>(unused - blocks.begin());
+        allocation.Range = unused->Allocator.Allocate(desc.Width, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+        UpdateFreeLevel(m_Pools[allocation.Pool], allocation.Block);
+    }
+
+    const Block& block = m_Pools[allocation.Pool].Blocks[allocation.Block];
+    allocation.Resource = block.Page.Resource;
+    allocation.Offset = block.Allocator.GetOffset(allocation.Range);
+    allocation.Size = block.Allocator.GetSize(allocation.Range);
+    allocation.GpuAddress = block.Page.GpuAddress + allocation.Offset;
+
+    return allocation;
+}
+
+bool ResourceAllocator::AllocateFromBlocks(Pool& pool, uint64_t size, uint64_t alignment, ResourceAllocation& allocation)
+{
+    // A block whose largest free range is at least size + alignment - 1 has room for sure; one on a
+    // smaller level from size's up may still. One block per level is tried, smallest level first, so
+    // the search is bounded by the levels and not the blocks.
+    uint64_t levels = pool.FreeLevelBitmap & (~uint64_t(0) << FindHighestBit(std::max<uint64_t>(size, 1)));
+    while (levels != 0)
+    {
+        uint32_t level = FindLowestBit(levels);
+        levels &= levels - 1;
+
+        uint32_t blockIndex = pool.FreeLevels[level].back();
+        TlsfAllocator::Allocation range = pool.Blocks[blockIndex].Allocator.Allocate(size, alignment);
+        if(range != TlsfAllocator::InvalidAllocation)
+        {
+            allocation.Block = blockIndex;
+            allocation.Range = range;
+            UpdateFreeLevel(pool, blockIndex);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ResourceAllocator::UpdateFreeLevel(Pool& pool, uint32_t blockIndex)
+{
+    Block& block = pool.Blocks[blockIndex];
+    uint32_t level = IsInUse(block.Heap, block.Page) ? block.Allocator.GetLargestFreeLevel() : TlsfAllocator::NoFreeLevel;
+    if(level == block.FreeLevel)
+    {
+        return;
+    }
+
+    if(block.FreeLevel != TlsfAllocator::NoFreeLevel)
+    {
+        std::vector<uint32_t>& list = pool.FreeLevels[block.FreeLevel];
+        list[block.FreeLevelIndex] = list.back();
+        pool.Blocks[list.back()].FreeLevelIndex = block.FreeLevelIndex;
+        list.pop_back();
+        if(list.empty())
+        {
+            pool.FreeLevelBitmap &= ~(uint64_t(1) << block.FreeLevel);
+        }
+    }
+
+    if(level != TlsfAllocator::NoFreeLevel)
+    {
+        std::vector<uint32_t>& list = pool.FreeLevels[level];
+        block.FreeLevelIndex = static_cast<uint32_t>(list.size());
+        list.push_back(blockIndex);
+        pool.FreeLevelBitmap |= uint64_t(1) << level;
+    }
+
+    block.FreeLevel = level;
+}
+
+void ResourceAllocator::FreeRange(ResourceAllocation& allocation)
+{
+    Pool& pool = m_Pools[allocation.Pool];
+    Block& block = pool.Blocks[allocation.Block];
+    block.Allocator.Free(allocation.Range);
+
+    // Each pool keeps its first heap or page; any other goes once it is empty.
+    if(!block.Allocator.IsEmpty() || allocation.Block == 0)
+    {
+        UpdateFreeLevel(pool, allocation.Block);
+        return;
+    }
+
+    if(block.Page.Resource)
+    {
+        ResourceAllocation page = std::move(block.Page);
+        block.Page = {};
+        page.Resource.Reset();
+
+        // Pages are committed when they take more than half a heap.
+        if(page.Pool == DedicatedPool)
+        {
+            --m_CommittedResources;
+            m_CommittedSize -= page.Size;
+        }
+        else
+        {
+            FreeRange(page);
+        }
+    }
+    else
+    {
+        block.Heap.Reset();
+    }
+
+    UpdateFreeLevel(pool, allocation.Block);
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+#include "TlsfAllocator.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// A resource from a ResourceAllocator.
+struct ResourceAllocation
+{
+    Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+    // Where the allocation starts in Resource. Only pooled small buffers share a resource with others,
+    // everything else starts at 0.
+    uint64_t Offset;
+    uint64_t Size;
+    // Of the allocation's start, for buffers.
+    D3D12_GPU_VIRTUAL_ADDRESS GpuAddress;
+
+    // Where the memory came from, for Free.
+    uint32_t Pool;
+    uint32_t Block;
+    TlsfAllocator::Allocation Range;
+};
+
+struct ResourceAllocatorStatistics
+{
+    // Heaps and the bytes in them, and resources too large for a heap that were committed instead.
+    size_t Heaps;
+    uint64_t Reserved;
+    size_t CommittedResources;
+    uint64_t CommittedSize;
+    // Live allocations and the bytes they take, including committed ones.
+    size_t Allocations;
+    uint64_t Allocated;
+    // The share of free heap memory that is not in the largest free range of its heap.
+    double Fragmentation;
+};
+
+// Places resources in large heaps instead of creating a committed resource, and so a heap, for each.
+// Every heap type gets pools of heapSize heaps, and on resource heap tier 1 buffers, render target and
+// depth stencil textures, and other textures get pools of their own. Each heap is suballocated with a
+// TlsfAllocator. Pools index their heaps by the size of their largest free range and allocate from the
+// one with the smallest that fits, which keeps large ranges whole for large requests; so Allocate and
+// Free are O(1) once the heap exists, however many heaps there are.
+//
+// Small textures take 4KB alignment where the device allows it. Buffers below SmallBufferSize share
+// placed buffers of SmallBufferPageSize, per heap type, flags and initial state, at 256 byte alignment;
+// as they share one ID3D12Resource, they also share its state. Resources larger than half a heap,
+// or aligned too coarsely for a heap to be sure to fit them, are committed. Safe to use from several
+// threads.
+class ResourceAllocator
+{
+public:
+    static constexpr uint64_t SmallBufferSize = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    static constexpr uint64_t SmallBufferPageSize = 1 << 20;
+
+    ResourceAllocator(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, uint64_t heapSize = 64 << 20);
+
+    ResourceAllocator(const ResourceAllocator&) = delete;
+    ResourceAllocator& operator=(const ResourceAllocator&) = delete;
+
+    ResourceAllocation Allocate(
+        D3D12_HEAP_TYPE heapType,
+        const D3D12_RESOURCE_DESC& desc,
+        D3D12_RESOURCE_STATES initialState,
+        const D3D12_CLEAR_VALUE* clearValue = nullptr);
+
+    // The GPU must be done with the resource.
+    void Free(ResourceAllocation& allocation);
+
+    ResourceAllocatorStatistics GetStatistics() const;
+
+private:
+    static constexpr uint32_t DedicatedPool = UINT32_MAX;
+
+    struct Block
+    {
+        Microsoft::WRL::ComPtr<ID3D12Heap> Heap;
+        // For small buffer pools, the placed buffer the allocations come from, and its own allocation.
+        ResourceAllocation Page;
+        TlsfAllocator Allocator;
+        // The pool's free level list the block is on, and where in it.
+        uint32_t FreeLevel = TlsfAllocator::NoFreeLevel;
+        uint32_t FreeLevelIndex = 0;
+    };
+
+    struct Pool
+    {
+        D3D12_HEAP_TYPE HeapType;
+        D3D12_HEAP_FLAGS HeapFlags;
+        // Small buffer pools only.
+        bool SmallBuffers;
+        D3D12_RESOURCE_FLAGS ResourceFlags;
+        D3D12_RESOURCE_STATES State;
+        std::vector<Block> Blocks;
+        // The blocks in use with free memory, by the TlsfAllocator level of their largest free range,
+        // and a bit per level whose list isn't empty.
+        std::vector<uint32_t> FreeLevels[TlsfAllocator::LevelCount];
+        uint64_t FreeLevelBitmap = 0;
+    };
+
+    // A texture description, compared and hashed a field at a time.
+    struct TextureKey
+    {
+        D3D12_RESOURCE_DESC Desc;
+
+        bool operator==(const TextureKey& other) const;
+    };
+
+    struct TextureKeyHash
+    {
+        size_t operator()(const TextureKey& key) const;
+    };
+
+    // How a texture is placed: the alignment it is created with and what it then takes in a heap.
+    struct TexturePlacement
+    {
+        UINT64 Alignment;
+        D3D12_RESOURCE_ALLOCATION_INFO Info;
+    };
+
+    // Call with m_Mutex held. Asks the device once per description, which for textures refused small
+    // alignment takes two queries.
+    const TexturePlacement& GetTexturePlacement(const D3D12_RESOURCE_DESC& desc);
+
+    // Call with m_Mutex held.
+    uint32_t GetPool(D3D12_HEAP_TYPE heapType, D3D12_HEAP_FLAGS heapFlags, bool smallBuffers, D3D12_RESOURCE_FLAGS resourceFlags, D3D12_RESOURCE_STATES state);
+    ResourceAllocation AllocatePlaced(
+        D3D12_HEAP_TYPE heapType,
+        const D3D12_RESOURCE_DESC& desc,
+        D3D12_RESOURCE_STATES initialState,
+        const D3D12_CLEAR_VALUE* clearValue);
+    ResourceAllocation AllocateSmallBuffer(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initialState);
+    // Sets the allocation's Block and Range from a block already in use, or returns false when none has
+    // room.
+    bool AllocateFromBlocks(Pool& pool, uint64_t size, uint64_t alignment, ResourceAllocation& allocation);
+    // Moves the block to the free level list of its largest free range, after anything that changes it.
+    void UpdateFreeLevel(Pool& pool, uint32_t blockIndex);
+    void FreeRange(ResourceAllocation& allocation);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    uint64_t m_HeapSize;
+    D3D12_RESOURCE_HEAP_TIER m_ResourceHeapTier;
+
+    mutable std::mutex m_Mutex;
+    std::vector<Pool> m_Pools;
+    std::unordered_map<TextureKey, TexturePlacement, TextureKeyHash> m_TexturePlacements;
+    size_t m_CommittedResources;
+    uint64_t m_CommittedSize;
+    size_t m_Allocations;
+    uint64_t m_Allocated;
+};
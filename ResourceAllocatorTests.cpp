@@ -0,0 +1,108 @@
+#include "ResourceAllocator.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+TEST(ResourceAllocatorKeepsLiveBuffersApart)
+{
+    // Small heaps, so the allocations spread over many of them and heaps come and go.
+    ResourceAllocator allocator(device, 4 << 20);
+
+    std::mt19937 random(16);
+    std::vector<ResourceAllocation> live;
+    for (uint32_t i = 0; i < 4000; ++i)
+    {
+        if(!live.empty() && random() % 3 == 0)
+        {
+            size_t index = random() % live.size();
+            allocator.Free(live[index]);
+            live[index] = std::move(live.back());
+            live.pop_back();
+        }
+
+        // Pooled small buffers and placed ones.
+        uint64_t size = random() % 2 ? 256 * (1 + random() % 200) : (64 << 10) + random() % (1 << 20);
+        live.push_back(allocator.Allocate(D3D12_HEAP_TYPE_DEFAULT, CD3DX12_RESOURCE_DESC::Buffer(size), D3D12_RESOURCE_STATE_COMMON));
+    }
+
+    std::vector<std::pair<D3D12_GPU_VIRTUAL_ADDRESS, D3D12_GPU_VIRTUAL_ADDRESS>> ranges;
+    for (const ResourceAllocation& allocation : live)
+    {
+        ranges.emplace_back(allocation.GpuAddress, allocation.GpuAddress + allocation.Size);
+    }
+    std::sort(ranges.begin(), ranges.end());
+
+    bool apart = true;
+    for (size_t i = 1; i < ranges.size(); ++i)
+    {
+        apart = apart && ranges[i - 1].second <= ranges[i].first;
+    }
+    CHECK(apart);
+
+    ResourceAllocatorStatistics statistics = allocator.GetStatistics();
+    CHECK(statistics.Allocations == live.size());
+
+    for (ResourceAllocation& allocation : live)
+    {
+        allocator.Free(allocation);
+    }
+
+    // Each pool keeps only its first heap or page, and the small buffers' first page went into the
+    // placed buffers' first heap.
+    statistics = allocator.GetStatistics();
+    CHECK(statistics.Allocations == 0);
+    CHECK(statistics.Allocated == 0);
+    CHECK(statistics.Heaps == 1);
+}
+
+TEST(ResourceAllocatorFreesCommittedSmallBufferPages)
+{
+    // Heaps too small to place a small buffer page in, so every page is committed.
+    ResourceAllocator allocator(device, 1 << 20);
+
+    std::vector<ResourceAllocation> live;
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        live.push_back(allocator.Allocate(D3D12_HEAP_TYPE_UPLOAD, CD3DX12_RESOURCE_DESC::Buffer(60 << 10), D3D12_RESOURCE_STATE_GENERIC_READ));
+    }
+
+    ResourceAllocatorStatistics statistics = allocator.GetStatistics();
+    CHECK(statistics.Heaps == 0);
+    CHECK(statistics.CommittedResources > 1);
+    CHECK(statistics.CommittedSize == statistics.CommittedResources * ResourceAllocator::SmallBufferPageSize);
+
+    // Freed newest first, so the later pages empty while the first is still in use.
+    for (size_t i = live.size(); i-- > 0;)
+    {
+        allocator.Free(live[i]);
+    }
+
+    statistics = allocator.GetStatistics();
+    CHECK(statistics.Allocations == 0);
+    CHECK(statistics.CommittedResources == 1);
+    CHECK(statistics.CommittedSize == ResourceAllocator::SmallBufferPageSize);
+}
+
+TEST(ResourceAllocatorCommitsResourcesAlignedPastTheHeap)
+{
+    // Multisampled textures are placed at 4MB, more than these heaps hold.
+    ResourceAllocator allocator(device, 1 << 20);
+
+    D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 64, 64, 1, 1, 4, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+    ResourceAllocation texture = allocator.Allocate(D3D12_HEAP_TYPE_DEFAULT, desc, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    CHECK(texture.Resource != nullptr);
+
+    ResourceAllocatorStatistics statistics = allocator.GetStatistics();
+    CHECK(statistics.Heaps == 0);
+    CHECK(statistics.CommittedResources == 1);
+
+    allocator.Free(texture);
+
+    statistics = allocator.GetStatistics();
+    CHECK(statistics.Allocations == 0);
+    CHECK(statistics.CommittedResources == 0);
+    CHECK(statistics.Heaps == 0);
+}
@@ -0,0 +1,232 @@
+#include "ResourceStateTracker.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <algorithm>
+#include <mutex>
+
+namespace
+{
+    std::mutex g_GlobalStatesMutex;
+    std::unordered_map<ID3D12Resource*, D3D12_RESOURCE_STATES> g_GlobalStates;
+
+    BarrierBackend g_BarrierBackend = BarrierBackend_Legacy;
+}
+
+void ResourceStateTracker::AddGlobalState(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+    std::lock_guard<std::mutex> lock(g_GlobalStatesMutex);
+
+    g_GlobalStates[resource] = state;
+}
+
+void ResourceStateTracker::RemoveGlobalState(ID3D12Resource* resource)
+{
+    std::lock_guard<std::mutex> lock(g_GlobalStatesMutex);
+
+    g_GlobalStates.erase(resource);
+}
+
+void ResourceStateTracker::SetBarrierBackend(BarrierBackend backend)
+{
+    g_BarrierBackend = backend;
+}
+
+BarrierBackend ResourceStateTracker::GetBarrierBackend()
+{
+    return g_BarrierBackend;
+}
+
+void ResourceStateTracker::Transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+    ++m_Requested;
+
+    auto finalState = m_FinalStates.find(resource);
+    if(finalState == m_FinalStates.end())
+    {
+        m_Pending.push_back({resource, state});
+        m_FinalStates.emplace(resource, state);
+        return;
+    }
+
+    if(finalState->second == state)
+    {
+        return;
+    }
+
+    D3D12_RESOURCE_STATES stateBefore = finalState->second;
+    finalState->second = state;
+
+    // Nothing can have used the resource since its batched barrier, so the two become one, or none.
+    auto batched = std::find_if(m_Barriers.begin(), m_Barriers.end(), [resource](const D3D12_RESOURCE_BARRIER& barrier)
+    {
+        return barrier.Transition.pResource == resource;
+    });
+    if(batched == m_Barriers.end())
+    {
+        m_Barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, stateBefore, state));
+    }
+    else if(batched->Transition.StateBefore == state)
+    {
+        m_Barriers.erase(batched);
+    }
+    else
+    {
+        batched->Transition.StateAfter = state;
+    }
+}
+
+void ResourceStateTracker::FlushBarriers(ID3D12GraphicsCommandList* commandList)
+{
+    if(m_Barriers.empty())
+    {
+        return;
+    }
+
+    RecordTransitions(commandList, GetEnhancedList(commandList), m_Barriers.data(), static_cast<UINT>(m_Barriers.size()));
+    m_Recorded += m_Barriers.size();
+    m_Barriers.clear();
+}
+
+void ResourceStateTracker::Alias(ID3D12GraphicsCommandList* commandList, const AliasingBarrier* barriers, UINT count)
+{
+    if(count == 0)
+    {
+        return;
+    }
+
+    ID3D12GraphicsCommandList7* enhancedList = GetEnhancedList(commandList);
+    RecordAliasing(commandList, enhancedList, barriers, count);
+
+    for (UINT i = 0; i < count; ++i)
+    {
+        m_FinalStates[barriers[i].Resource] = barriers[i].State;
+
+        // Only legacy aliasing barriers are followed by a transition.
+        if(!enhancedList && barriers[i].StateBefore != barriers[i].State)
+        {
+            ++m_Requested;
+            ++m_Recorded;
+        }
+    }
+}
+
+void ResourceStateTracker::Reset()
+{
+    m_Pending.clear();
+    m_Barriers.clear();
+    m_FinalStates.clear();
+    m_CommandList = nullptr;
+    m_EnhancedList.Reset();
+    m_Requested = 0;
+    m_Recorded = 0;
+}
+
+ResourceStateTrackerStatistics ResourceStateTracker::GetStatistics() const
+{
+    ResourceStateTrackerStatistics statistics;
+    statistics.Requested = m_Requested;
+    statistics.Recorded = m_Recorded;
+    statistics.Eliminated = m_Requested - m_Recorded;
+
+    return statistics;
+}
+
+uint32_t ResourceStateTracker::ResolvePendingBarriers(ID3D12GraphicsCommandList* commandList)
+{
+    std::vector<D3D12_RESOURCE_BARRIER> barriers;
+
+    std::lock_guard<std::mutex> lock(g_GlobalStatesMutex);
+
+    for (const PendingTransition& pending : m_Pending)
+    {
+        auto globalState = g_GlobalStates.find(pending.Resource);
+        if(globalState == g_GlobalStates.end())
+        {
+            ThrowIfFailed(E_INVALIDARG);
+        }
+
+        if(globalState->second != pending.State)
+        {
+            barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(pending.Resource, globalState->second, pending.State));
+        }
+    }
+
+    for (const auto& finalState : m_FinalStates)
+    {
+        g_GlobalStates[finalState.first] = finalState.second;
+    }
+
+    if(!barriers.empty())
+    {
+        // The list only ever gets this one batch.
+        RecordTransitions(commandList, GetEnhancedBarrierList(commandList, g_BarrierBackend).Get(), barriers.data(), static_cast<UINT>(barriers.size()));
+        m_Recorded += barriers.size();
+    }
+
+    return static_cast<uint32_t>(barriers.size());
+}
+
+ID3D12GraphicsCommandList7* ResourceStateTracker::GetEnhancedList(ID3D12GraphicsCommandList* commandList)
+{
+    if(commandList != m_CommandList)
+    {
+        m_CommandList = commandList;
+        m_EnhancedList = GetEnhancedBarrierList(commandList, g_BarrierBackend);
+    }
+
+    return m_EnhancedList.Get();
+}
+
+PendingBarrierResolver::PendingBarrierResolver(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, CommandAllocatorPool& allocatorPool)
+    : m_Device(device)
+    , m_AllocatorPool(allocatorPool)
+{
+}
+
+void PendingBarrierResolver::Resolve(const std::vector<TrackedCommandList>& trackedLists, std::vector<ID3D12CommandList*>& commandLists)
+{
+    for (const TrackedCommandList& trackedList : trackedLists)
+    {
+        if(trackedList.Tracker && !trackedList.Tracker->m_Pending.empty())
+        {
+            size_t index = m_Allocators.size();
+
+            Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator = m_AllocatorPool.Acquire(D3D12_COMMAND_LIST_TYPE_DIRECT);
+            if(index < m_CommandLists.size())
+            {
+                ThrowIfFailed(m_CommandLists[index]->Reset(allocator.Get(), nullptr));
+            }
+            else
+            {
+                m_CommandLists.emplace_back();
+                ThrowIfFailed(m_Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&m_CommandLists.back())));
+            }
+            m_Allocators.push_back(std::move(allocator));
+
+            ID3D12GraphicsCommandList* commandList = m_CommandLists[index].Get();
+            uint32_t barrierCount = trackedList.Tracker->ResolvePendingBarriers(commandList);
+            ThrowIfFailed(commandList->Close());
+
+            // Everything resolved to the state it was already in, so there is nothing to submit.
+            if(barrierCount > 0)
+            {
+                commandLists.push_back(commandList);
+            }
+        }
+
+        commandLists.push_back(trackedList.CommandList);
+    }
+}
+
+void PendingBarrierResolver::Release(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue)
+{
+    for (Microsoft::WRL::ComPtr<ID3D12CommandAllocator>& allocator : m_Allocators)
+    {
+        m_AllocatorPool.Release(D3D12_COMMAND_LIST_TYPE_DIRECT, std::move(allocator), fence, fenceValue);
+    }
+
+    m_Allocators.clear();
+}
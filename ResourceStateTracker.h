@@ -0,0 +1,105 @@
+#pragma once
+
+#include "BarrierBackend.h"
+#include "CommandAllocatorPool.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct ResourceStateTrackerStatistics
+{
+    // Transitions asked for, barriers actually recorded for them, and the difference: transitions
+    // dropped because the resource was already in that state or a batched barrier could absorb them.
+    uint64_t Requested;
+    uint64_t Recorded;
+    uint64_t Eliminated;
+};
+
+// Tracks the state of every resource one command list touches. Callers declare the state they need
+// and the tracker batches the barriers. A resource's state before the list runs is resolved when the
+// list is submitted, from what the lists submitted before it leave behind. Whole resources only.
+class ResourceStateTracker
+{
+public:
+    // The state a resource is in once all submitted work has run. Every tracked resource needs one.
+    static void AddGlobalState(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+    static void RemoveGlobalState(ID3D12Resource* resource);
+
+    // How every tracker records its barriers. Legacy until set.
+    static void SetBarrierBackend(BarrierBackend backend);
+    static BarrierBackend GetBarrierBackend();
+
+    // Nothing is recorded until FlushBarriers.
+    void Transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+
+    // Records every batched barrier in one ResourceBarrier call. Call before each draw, dispatch, copy
+    // or clear that depends on them, and before closing the list.
+    void FlushBarriers(ID3D12GraphicsCommandList* commandList);
+
+    // Records aliasing barriers right away, ahead of anything batched. Each resource's State is the one
+    // it is in at that point, which for a resource the list hasn't used yet is the first one it needs.
+    // The list then knows the resources' states, so they get no pending barriers: none may be recorded
+    // while another resource holds the memory.
+    void Alias(ID3D12GraphicsCommandList* commandList, const AliasingBarrier* barriers, UINT count);
+
+    // Forgets everything, the list included, for the next recording of the list.
+    void Reset();
+
+    // Since the last Reset, including the barriers resolved at submission.
+    ResourceStateTrackerStatistics GetStatistics() const;
+
+private:
+    friend class PendingBarrierResolver;
+
+    // Records the barriers from the resources' global states into the states this list first needs,
+    // then makes the list's final states the global ones. Returns the number of barriers recorded.
+    uint32_t ResolvePendingBarriers(ID3D12GraphicsCommandList* commandList);
+
+    // Queries the list's enhanced barrier interface when it isn't the one last seen.
+    ID3D12GraphicsCommandList7* GetEnhancedList(ID3D12GraphicsCommandList* commandList);
+
+    struct PendingTransition
+    {
+        ID3D12Resource* Resource;
+        D3D12_RESOURCE_STATES State;
+    };
+
+    // First state needed for resources whose state before the list is unknown.
+    std::vector<PendingTransition> m_Pending;
+    std::vector<D3D12_RESOURCE_BARRIER> m_Barriers;
+    std::unordered_map<ID3D12Resource*, D3D12_RESOURCE_STATES> m_FinalStates;
+    // The list barriers were last flushed to, and its enhanced barrier interface, if any.
+    ID3D12GraphicsCommandList* m_CommandList = nullptr;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList7> m_EnhancedList;
+    uint64_t m_Requested = 0;
+    uint64_t m_Recorded = 0;
+};
+
+struct TrackedCommandList
+{
+    ID3D12CommandList* CommandList;
+    // Null for lists that don't transition anything.
+    ResourceStateTracker* Tracker;
+};
+
+// Turns a sequence of tracked lists into what to submit: each list is preceded by a short list holding
+// its resolved pending barriers, when it has any. Global states are updated in that order, so the
+// result must be submitted in that order, before anything else is resolved.
+class PendingBarrierResolver
+{
+public:
+    PendingBarrierResolver(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, CommandAllocatorPool& allocatorPool);
+
+    void Resolve(const std::vector<TrackedCommandList>& trackedLists, std::vector<ID3D12CommandList*>& commandLists);
+
+    // Hands the allocators of the last Resolve back to the pool once the GPU has passed fenceValue.
+    void Release(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue);
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    CommandAllocatorPool& m_AllocatorPool;
+
+    std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>> m_CommandLists;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> m_Allocators;
+};
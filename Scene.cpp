@@ -0,0 +1,247 @@
+#include "Scene.h"
+
+#if defined(_WIN32)
+#include <d3dcompiler.h>
+#else
+#include "NullDevice.h"
+#endif
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iterator>
+
+namespace
+{
+    const char g_SceneShaderSource[] = R"(
+        cbuffer Tile : register(b0)
+        {
+            float4 Rect;
+            uint Palette;
+            uint ColorIndex;
+        };
+
+        // Every view in the bindless heap. Handles keep their generation above the low 20 bits.
+        StructuredBuffer<float4> Buffers[] : register(t0, space1);
+
+        float4 VSMain(uint id : SV_VertexID) : SV_Position
+        {
+            // Two triangles: (0,0) (1,0) (0,1) and (0,1) (1,0) (1,1).
+            float2 corner = float2((0x32 >> id) & 1, (0x2C >> id) & 1);
+            return float4(lerp(Rect.xy, Rect.zw, corner), 0, 1);
+        }
+
+        float4 PSMain() : SV_Target
+        {
+            return Buffers[Palette & 0xFFFFF][ColorIndex];
+        }
+
+        // Cheap to compile, for the tiles drawn before PSMain is ready.
+        float4 PSFallback() : SV_Target
+        {
+            return float4(0.5, 0.5, 0.5, 1);
+        }
+    )";
+
+    struct TileConstants
+    {
+        float Rect[4];
+        BindlessHandle Palette;
+        uint32_t ColorIndex;
+    };
+
+    // A gradient of g_PaletteSide x g_PaletteSide colors, laid over the grid.
+    constexpr uint32_t g_PaletteSide = 16;
+
+    constexpr uint64_t g_TileConstantsStride =
+        (sizeof(TileConstants) + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+
+    Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(const char* entryPoint, const char* target)
+    {
+        Microsoft::WRL::ComPtr<ID3DBlob> bytecode;
+        Microsoft::WRL::ComPtr<ID3DBlob> errors;
+        ThrowIfFailed(D3DCompile(
+            g_SceneShaderSource,
+            sizeof(g_SceneShaderSource) - 1,
+            "Scene.hlsl",
+            nullptr,
+            nullptr,
+            entryPoint,
+            target,
+            D3DCOMPILE_OPTIMIZATION_LEVEL3,
+            0,
+            &bytecode,
+            &errors));
+
+        return bytecode;
+    }
+}
+
+Scene::Scene(
+    ResourceAllocator& resourceAllocator,
+    BindlessHeap& bindlessHeap,
+    PipelineCache& pipelineCache,
+    PipelineCompiler& pipelineCompiler,
+    bool useFallback,
+    DXGI_FORMAT renderTargetFormat,
+    uint32_t drawCount)
+    : m_ResourceAllocator(resourceAllocator)
+    , m_BindlessHeap(bindlessHeap)
+    , m_FramePipeline(nullptr)
+    , m_DrawCount(drawCount)
+    , m_Columns(std::max(1u, static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(drawCount))))))
+{
+    constexpr uint32_t paletteSize = g_PaletteSide * g_PaletteSide;
+
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(paletteSize * sizeof(float) * 4);
+    m_Palette = m_ResourceAllocator.Allocate(D3D12_HEAP_TYPE_UPLOAD, bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+    // The palette may share its buffer with other small buffers, so only map its own range.
+    uint8_t* mapped;
+    CD3DX12_RANGE readRange(0, 0);
+    ThrowIfFailed(m_Palette.Resource->Map(0, &readRange, reinterpret_cast<void**>(&mapped)));
+    float* colors = reinterpret_cast<float*>(mapped + m_Palette.Offset);
+    for (uint32_t i = 0; i < paletteSize; ++i)
+    {
+        colors[i * 4 + 0] = static_cast<float>(i % g_PaletteSide) / (g_PaletteSide - 1);
+        colors[i * 4 + 1] = static_cast<float>(i / g_PaletteSide) / (g_PaletteSide - 1);
+        colors[i * 4 + 2] = 0.5f;
+        colors[i * 4 + 3] = 1.0f;
+    }
+    CD3DX12_RANGE writtenRange(m_Palette.Offset, m_Palette.Offset + bufferDesc.Width);
+    m_Palette.Resource->Unmap(0, &writtenRange);
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC paletteView = {};
+    paletteView.Format = DXGI_FORMAT_UNKNOWN;
+    paletteView.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    paletteView.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    paletteView.Buffer.FirstElement = m_Palette.Offset / (sizeof(float) * 4);
+    paletteView.Buffer.NumElements = paletteSize;
+    paletteView.Buffer.StructureByteStride = sizeof(float) * 4;
+    m_PaletteHandle = m_BindlessHeap.RegisterShaderResourceView(m_Palette.Resource.Get(), &paletteView);
+
+    // One unbounded table reaches every slot of the bindless heap.
+    CD3DX12_DESCRIPTOR_RANGE bindlessRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 1);
+
+    CD3DX12_ROOT_PARAMETER rootParameters[2];
+    rootParameters[0].InitAsConstantBufferView(0);
+    rootParameters[1].InitAsDescriptorTable(1, &bindlessRange, D3D12_SHADER_VISIBILITY_PIXEL);
+
+    CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc(static_cast<UINT>(std::size(rootParameters)), rootParameters);
+
+    Microsoft::WRL::ComPtr<ID3DBlob> rootSignature;
+    Microsoft::WRL::ComPtr<ID3DBlob> errors;
+    ThrowIfFailed(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &rootSignature, &errors));
+    m_RootSignature = pipelineCache.CreateRootSignature(rootSignature->GetBufferPointer(), rootSignature->GetBufferSize());
+
+    Microsoft::WRL::ComPtr<ID3DBlob> vertexShader = CompileShader("VSMain", "vs_5_1");
+    Microsoft::WRL::ComPtr<ID3DBlob> pixelShader = CompileShader("PSMain", "ps_5_1");
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineDesc = {};
+    pipelineDesc.pRootSignature = m_RootSignature.Get();
+    pipelineDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
+    pipelineDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
+    pipelineDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    pipelineDesc.SampleMask = UINT_MAX;
+    pipelineDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    pipelineDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+    pipelineDesc.DepthStencilState.DepthEnable = FALSE;
+    pipelineDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    pipelineDesc.NumRenderTargets = 1;
+    pipelineDesc.RTVFormats[0] = renderTargetFormat;
+    pipelineDesc.SampleDesc = {1, 0};
+
+    Microsoft::WRL::ComPtr<ID3D12PipelineState> fallback;
+    if(useFallback)
+    {
+        Microsoft::WRL::ComPtr<ID3DBlob> fallbackShader = CompileShader("PSFallback", "ps_5_1");
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC fallbackDesc = pipelineDesc;
+        fallbackDesc.PS = CD3DX12_SHADER_BYTECODE(fallbackShader.Get());
+        CD3DX12_PIPELINE_STATE_STREAM fallbackStream(fallbackDesc);
+        fallback = pipelineCache.GetOrCreate({sizeof(fallbackStream), &fallbackStream});
+    }
+
+    CD3DX12_PIPELINE_STATE_STREAM pipelineStream(pipelineDesc);
+    m_Pipeline = pipelineCompiler.Compile({sizeof(pipelineStream), &pipelineStream}, fallback);
+}
+
+Scene::~Scene()
+{
+    // Whoever destroys the scene has already waited for the GPU to finish with it.
+    m_BindlessHeap.Unregister(m_PaletteHandle, nullptr, 0);
+    m_ResourceAllocator.Free(m_Palette);
+}
+
+uint32_t Scene::GetDrawCount() const
+{
+    return m_DrawCount;
+}
+
+uint64_t Scene::GetUploadSize() const
+{
+    return m_DrawCount * g_TileConstantsStride;
+}
+
+bool Scene::Update()
+{
+    m_FramePipeline = m_Pipeline.Get();
+
+    return m_FramePipeline != nullptr;
+}
+
+void Scene::RecordSetup(
+    ID3D12GraphicsCommandList* commandList,
+    D3D12_CPU_DESCRIPTOR_HANDLE renderTarget,
+    uint32_t width,
+    uint32_t height) const
+{
+    CD3DX12_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height));
+    CD3DX12_RECT scissorRect(0, 0, static_cast<LONG>(width), static_cast<LONG>(height));
+
+    D3D12_GPU_DESCRIPTOR_HANDLE bindlessTable = m_BindlessHeap.Bind(commandList);
+
+    commandList->SetPipelineState(m_FramePipeline);
+    commandList->SetGraphicsRootSignature(m_RootSignature.Get());
+    commandList->SetGraphicsRootDescriptorTable(1, bindlessTable);
+    commandList->RSSetViewports(1, &viewport);
+    commandList->RSSetScissorRects(1, &scissorRect);
+    commandList->OMSetRenderTargets(1, &renderTarget, FALSE, nullptr);
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
+
+void Scene::RecordDraws(ID3D12GraphicsCommandList* commandList, UploadRing& uploadRing, uint32_t begin, uint32_t end) const
+{
+    if(begin >= end)
+    {
+        return;
+    }
+
+    float tileSize = 2.0f / m_Columns;
+
+    // One allocation for the whole range keeps the ring's lock out of the per-draw loop.
+    UploadAllocation allocation = uploadRing.Allocate((end - begin) * g_TileConstantsStride);
+    uint8_t* cpuAddress = static_cast<uint8_t*>(allocation.CpuAddress);
+    D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = allocation.GpuAddress;
+
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        uint32_t column = i % m_Columns;
+        uint32_t row = i / m_Columns;
+
+        // Leave a gap between tiles and fade the color across the grid.
+        TileConstants& constants = *reinterpret_cast<TileConstants*>(cpuAddress);
+        constants.Rect[0] = -1.0f + column * tileSize;
+        constants.Rect[1] = 1.0f - row * tileSize;
+        constants.Rect[2] = constants.Rect[0] + tileSize * 0.9f;
+        constants.Rect[3] = constants.Rect[1] - tileSize * 0.9f;
+        constants.Palette = m_PaletteHandle;
+        constants.ColorIndex = row * g_PaletteSide / m_Columns * g_PaletteSide + column * g_PaletteSide / m_Columns;
+
+        commandList->SetGraphicsRootConstantBufferView(0, gpuAddress);
+        commandList->DrawInstanced(6, 1, 0, 0);
+
+        cpuAddress += g_TileConstantsStride;
+        gpuAddress += g_TileConstantsStride;
+    }
+}
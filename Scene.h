@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+#include "BindlessHeap.h"
+#include "PipelineCache.h"
+#include "PipelineCompiler.h"
+#include "ResourceAllocator.h"
+#include "UploadRing.h"
+
+#include <cstdint>
+
+// A grid of solid-colored tiles, one draw per tile, used to load command list recording. Each draw
+// reads its tile from its own constant buffer in the upload ring, and its color from a palette
+// buffer registered in the bindless heap. The palette is a small upload buffer from resourceAllocator.
+// The root signature comes from pipelineCache, and the pipeline is compiled by pipelineCompiler while
+// frames go on. Until it is ready the scene draws its tiles in flat grey with a fallback pipeline, made
+// up front, or with useFallback false isn't drawn at all.
+class Scene
+{
+public:
+    Scene(
+        ResourceAllocator& resourceAllocator,
+        BindlessHeap& bindlessHeap,
+        PipelineCache& pipelineCache,
+        PipelineCompiler& pipelineCompiler,
+        bool useFallback,
+        DXGI_FORMAT renderTargetFormat,
+        uint32_t drawCount);
+    ~Scene();
+
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
+
+    uint32_t GetDrawCount() const;
+
+    // Upload ring space that recording every draw once takes.
+    uint64_t GetUploadSize() const;
+
+    // Picks the pipeline for the frame about to be recorded, so all of its lists use the same one.
+    // Returns false when there is none yet and the scene should be skipped. Call before RecordSetup.
+    bool Update();
+
+    // Binds the pipeline, the bindless heap and the render target. Every command list that records
+    // draws needs this first.
+    void RecordSetup(
+        ID3D12GraphicsCommandList* commandList,
+        D3D12_CPU_DESCRIPTOR_HANDLE renderTarget,
+        uint32_t width,
+        uint32_t height) const;
+
+    void RecordDraws(ID3D12GraphicsCommandList* commandList, UploadRing& uploadRing, uint32_t begin, uint32_t end) const;
+
+private:
+    ResourceAllocator& m_ResourceAllocator;
+    BindlessHeap& m_BindlessHeap;
+    ResourceAllocation m_Palette;
+    BindlessHandle m_PaletteHandle;
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSignature;
+    PipelineHandle m_Pipeline;
+    ID3D12PipelineState* m_FramePipeline;
+    uint32_t m_DrawCount;
+    uint32_t m_Columns;
+};
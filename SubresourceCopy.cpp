@@ -0,0 +1,277 @@
+#include "SubresourceCopy.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <immintrin.h>
+#define SUBRESOURCE_COPY_STREAMING
+#endif
+
+namespace
+{
+    // Below this, waking the workers costs more than splitting the copy saves.
+    constexpr size_t g_ParallelCopyThreshold = 1 << 20;
+    constexpr size_t g_MinimumTaskSize = 256 << 10;
+    // Below this, a copy's destination fits in the cache next to its source, and ordinary stores that
+    // land there beat non-temporal ones going out to memory; at 256KB by more than half. Measured, the
+    // two break even at a few MB, so this errs towards the cache. Decided for a whole copy, not a row.
+    constexpr size_t g_StreamingCopyThreshold = 4 << 20;
+    // Non-temporal stores only pay off once a piece covers whole cache lines.
+    constexpr size_t g_MinimumStreamingSize = 256;
+
+    void CopyCached(uint8_t* destination, const uint8_t* source, size_t size)
+    {
+        memcpy(destination, source, size);
+    }
+
+    void CopyStreaming(uint8_t* destination, const uint8_t* source, size_t size)
+    {
+#if defined(SUBRESOURCE_COPY_STREAMING)
+        if(size < g_MinimumStreamingSize)
+        {
+            memcpy(destination, source, size);
+            return;
+        }
+
+#if defined(__AVX2__)
+        constexpr size_t vectorSize = 32;
+#else
+        constexpr size_t vectorSize = 16;
+#endif
+
+        // Streaming stores need an aligned destination; the source is loaded unaligned.
+        size_t head = (vectorSize - reinterpret_cast<uintptr_t>(destination) % vectorSize) % vectorSize;
+        memcpy(destination, source, head);
+        destination += head;
+        source += head;
+        size -= head;
+
+        uint8_t* end = destination + size / (2 * vectorSize) * (2 * vectorSize);
+        while (destination != end)
+        {
+#if defined(__AVX2__)
+            __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+            __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + vectorSize));
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(destination), first);
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(destination + vectorSize), second);
+#else
+            __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+            __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + vectorSize));
+            _mm_stream_si128(reinterpret_cast<__m128i*>(destination), first);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(destination + vectorSize), second);
+#endif
+            destination += 2 * vectorSize;
+            source += 2 * vectorSize;
+        }
+
+        memcpy(destination, source, size % (2 * vectorSize));
+#else
+        memcpy(destination, source, size);
+#endif
+    }
+
+    // Streaming stores are weakly ordered; this makes a thread's visible before whatever follows, e.g. Unmap.
+    void FinishStreaming()
+    {
+#if defined(SUBRESOURCE_COPY_STREAMING)
+        _mm_sfence();
+#endif
+    }
+
+    bool ShouldStream(bool writeCombined, uint64_t totalSize)
+    {
+        return writeCombined && totalSize >= g_StreamingCopyThreshold;
+    }
+
+    // CopySubresource once it is known whether to stream.
+    void CopySpans(
+        const D3D12_MEMCPY_DEST& destination,
+        const D3D12_SUBRESOURCE_DATA& source,
+        SIZE_T rowSizeInBytes,
+        UINT rowCount,
+        UINT sliceCount,
+        bool streaming,
+        WorkerPool* workers)
+    {
+        if(rowCount == 0 || sliceCount == 0 || rowSizeInBytes == 0)
+        {
+            return;
+        }
+
+        uint8_t* destinationData = static_cast<uint8_t*>(destination.pData);
+        const uint8_t* sourceData = static_cast<const uint8_t*>(source.pData);
+        void (*copy)(uint8_t*, const uint8_t*, size_t) = streaming ? CopyStreaming : CopyCached;
+
+        // The copy becomes spanCount equally sized spans, spansPerSlice of them in each slice. Rows, and
+        // then slices, are merged when they follow each other on both sides, so no padding is touched.
+        size_t rowPitch = destination.RowPitch;
+        bool mergeRows = rowCount == 1 ||
+            (rowPitch == rowSizeInBytes && source.RowPitch == static_cast<LONG_PTR>(rowSizeInBytes));
+        size_t sliceSize = mergeRows ? rowSizeInBytes * rowCount : rowSizeInBytes;
+        size_t slicePitch = destination.SlicePitch;
+        bool mergeSlices = mergeRows &&
+            (sliceCount == 1 || (slicePitch == sliceSize && source.SlicePitch == static_cast<LONG_PTR>(sliceSize)));
+
+        size_t spansPerSlice = mergeRows ? 1 : rowCount;
+        size_t spanCount = mergeSlices ? 1 : spansPerSlice * sliceCount;
+        size_t spanSize = mergeSlices ? sliceSize * sliceCount : sliceSize;
+
+        // Spans are cut into pieces when there are fewer of them than tasks, e.g. a single merged block.
+        size_t taskCount = 1;
+        size_t piecesPerSpan = 1;
+        size_t totalSize = spanCount * spanSize;
+        if(workers && workers->GetThreadCount() > 1 && totalSize >= g_ParallelCopyThreshold)
+        {
+            taskCount = std::min<size_t>(4 * workers->GetThreadCount(), totalSize / g_MinimumTaskSize);
+            piecesPerSpan = (taskCount + spanCount - 1) / spanCount;
+        }
+
+        // A whole number of cache lines per piece, so tasks don't write into the same line of an aligned span.
+        size_t pieceSize = (spanSize + piecesPerSpan - 1) / piecesPerSpan;
+        pieceSize = piecesPerSpan > 1 ? (pieceSize + 63) / 64 * 64 : pieceSize;
+        size_t pieceCount = spanCount * piecesPerSpan;
+
+        auto copyPieces = [&](uint32_t task)
+        {
+            size_t begin = pieceCount * task / taskCount;
+            size_t end = pieceCount * (task + 1) / taskCount;
+            for (size_t piece = begin; piece < end; ++piece)
+            {
+                size_t span = piece / piecesPerSpan;
+                size_t offset = piece % piecesPerSpan * pieceSize;
+                if(offset >= spanSize)
+                {
+                    continue;
+                }
+
+                size_t slice = span / spansPerSlice;
+                size_t row = span % spansPerSlice;
+                copy(destinationData + slicePitch * slice + rowPitch * row + offset,
+                     sourceData + source.SlicePitch * static_cast<LONG_PTR>(slice) + source.RowPitch * static_cast<LONG_PTR>(row) + offset,
+                     std::min(pieceSize, spanSize - offset));
+            }
+
+            if(streaming)
+            {
+                FinishStreaming();
+            }
+        };
+
+        if(taskCount > 1)
+        {
+            workers->ParallelFor(static_cast<uint32_t>(taskCount), copyPieces);
+        }
+        else
+        {
+            copyPieces(0);
+        }
+    }
+}
+
+void CopySubresource(
+    const D3D12_MEMCPY_DEST& destination,
+    const D3D12_SUBRESOURCE_DATA& source,
+    SIZE_T rowSizeInBytes,
+    UINT rowCount,
+    UINT sliceCount,
+    bool writeCombined,
+    WorkerPool* workers)
+{
+    uint64_t totalSize = static_cast<uint64_t>(rowSizeInBytes) * rowCount * sliceCount;
+    CopySpans(destination, source, rowSizeInBytes, rowCount, sliceCount, ShouldStream(writeCombined, totalSize), workers);
+}
+
+uint64_t UpdateSubresourcesParallel(
+    ID3D12GraphicsCommandList* commandList,
+    ID3D12Resource* destinationResource,
+    ID3D12Resource* intermediate,
+    uint64_t intermediateOffset,
+    UINT firstSubresource,
+    UINT subresourceCount,
+    const D3D12_SUBRESOURCE_DATA* sourceData,
+    FootprintCache& footprints,
+    WorkerPool& workers)
+{
+    if(subresourceCount == 0)
+    {
+        return 0;
+    }
+
+    D3D12_RESOURCE_DESC destinationDesc = destinationResource->GetDesc();
+    D3D12_RESOURCE_DESC intermediateDesc = intermediate->GetDesc();
+
+    const CopyableFootprints& cached = footprints.Get(destinationDesc, firstSubresource, subresourceCount);
+    const std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>& layouts = cached.Layouts;
+    const std::vector<UINT>& rowCounts = cached.RowCounts;
+    const std::vector<UINT64>& rowSizes = cached.RowSizes;
+    UINT64 requiredSize = cached.TotalBytes;
+
+    // The same checks as d3dx12.
+    if(intermediateDesc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER ||
+        intermediateDesc.Width < requiredSize + intermediateOffset ||
+        requiredSize > SIZE_T(-1) ||
+        (destinationDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER && (firstSubresource != 0 || subresourceCount != 1)))
+    {
+        return 0;
+    }
+
+    uint8_t* data;
+    if(FAILED(intermediate->Map(0, nullptr, reinterpret_cast<void**>(&data))))
+    {
+        return 0;
+    }
+
+    // One choice for the whole upload: its small mips would fit in the cache on their own, but not
+    // alongside the rest.
+    bool streaming = ShouldStream(true, requiredSize);
+
+    auto copy = [&](UINT i, WorkerPool* rowWorkers)
+    {
+        D3D12_MEMCPY_DEST destination = {
+            data + intermediateOffset + layouts[i].Offset,
+            layouts[i].Footprint.RowPitch,
+            static_cast<SIZE_T>(layouts[i].Footprint.RowPitch) * rowCounts[i]};
+        CopySpans(destination, sourceData[i], static_cast<SIZE_T>(rowSizes[i]), rowCounts[i], layouts[i].Footprint.Depth, streaming, rowWorkers);
+    };
+
+    // More than a thread's share can't be balanced by handing out whole subresources.
+    uint64_t share = requiredSize / workers.GetThreadCount();
+    std::vector<UINT> small;
+    for (UINT i = 0; i < subresourceCount; ++i)
+    {
+        if(rowSizes[i] * rowCounts[i] * layouts[i].Footprint.Depth > share)
+        {
+            copy(i, &workers);
+        }
+        else
+        {
+            small.push_back(i);
+        }
+    }
+
+    workers.ParallelFor(static_cast<uint32_t>(small.size()), [&](uint32_t i)
+    {
+        copy(small[i], nullptr);
+    });
+
+    intermediate->Unmap(0, nullptr);
+
+    if(destinationDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        commandList->CopyBufferRegion(destinationResource, 0, intermediate, intermediateOffset, layouts[0].Footprint.Width);
+    }
+    else
+    {
+        for (UINT i = 0; i < subresourceCount; ++i)
+        {
+            CD3DX12_TEXTURE_COPY_LOCATION destination(destinationResource, i + firstSubresource);
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT placed = {intermediateOffset + layouts[i].Offset, layouts[i].Footprint};
+            CD3DX12_TEXTURE_COPY_LOCATION source(intermediate, placed);
+            commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+        }
+    }
+
+    return requiredSize;
+}
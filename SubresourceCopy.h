@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+#include "FootprintCache.h"
+#include "WorkerPool.h"
+
+#include <cstdint>
+
+// A faster MemcpySubresource from d3dx12, taking the same arguments and writing the same bytes, and
+// no others. Rows are copied as one block when neither side has padding between them, and so are
+// slices. With writeCombined, e.g. for a mapped UPLOAD heap, copies of several MB use non-temporal
+// stores, which neither read the destination nor evict the cache for memory the CPU won't look at
+// again; smaller ones are faster through the cache.
+// Given workers, large copies are split across them; the pool must not be in a ParallelFor already.
+void CopySubresource(
+    const D3D12_MEMCPY_DEST& destination,
+    const D3D12_SUBRESOURCE_DATA& source,
+    SIZE_T rowSizeInBytes,
+    UINT rowCount,
+    UINT sliceCount,
+    bool writeCombined,
+    WorkerPool* workers = nullptr);
+
+// UpdateSubresources from d3dx12, with the subresources copied into the intermediate buffer on workers
+// rather than one after another. Subresources too large to share the work evenly, like the top mip of
+// a chain, are split on their own first, and the rest are spread across the threads. The copies to the
+// destination are recorded in subresource order once all data is in, and the intermediate ends up
+// with the same bytes as the serial version. Returns the required size, or 0 on failure, like d3dx12.
+// The layouts come from footprints instead of asking the destination's device every time.
+uint64_t UpdateSubresourcesParallel(
+    ID3D12GraphicsCommandList* commandList,
+    ID3D12Resource* destinationResource,
+    ID3D12Resource* intermediate,
+    uint64_t intermediateOffset,
+    UINT firstSubresource,
+    UINT subresourceCount,
+    const D3D12_SUBRESOURCE_DATA* sourceData,
+    FootprintCache& footprints,
+    WorkerPool& workers);
@@ -0,0 +1,142 @@
+#include "SubresourceCopy.h"
+#include "Tests.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    ComPtr<ID3D12Resource> CreateUploadBuffer(ID3D12Device2* device, uint64_t size)
+    {
+        ComPtr<ID3D12Resource> buffer;
+        CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+        CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(size);
+        ThrowIfFailed(device->CreateCommittedResource(
+            &heapProperties,
+            D3D12_HEAP_FLAG_NONE,
+            &desc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&buffer)));
+
+        // Filled, so bytes that neither version writes are compared too.
+        void* data;
+        ThrowIfFailed(buffer->Map(0, nullptr, &data));
+        memset(data, 0xcd, static_cast<size_t>(size));
+        buffer->Unmap(0, nullptr);
+
+        return buffer;
+    }
+
+    // Uploads random pixels into subresources [firstSubresource, firstSubresource + subresourceCount)
+    // with d3dx12's UpdateSubresources and with UpdateSubresourcesParallel, each through its own
+    // intermediate, and checks that both intermediates end up with the same bytes.
+    void CheckMatchesSerial(
+        ID3D12Device2* device,
+        const D3D12_RESOURCE_DESC& desc,
+        UINT firstSubresource,
+        UINT subresourceCount,
+        uint64_t intermediateOffset,
+        uint32_t threadCount)
+    {
+        ComPtr<ID3D12Resource> texture;
+        CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+        ThrowIfFailed(device->CreateCommittedResource(
+            &heapProperties,
+            D3D12_HEAP_FLAG_NONE,
+            &desc,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(&texture)));
+
+        // Laid out from intermediateOffset, as d3dx12 does when it asks the device itself.
+        D3D12_RESOURCE_DESC textureDesc = texture->GetDesc();
+        std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresourceCount);
+        std::vector<UINT> rowCounts(subresourceCount);
+        std::vector<UINT64> rowSizes(subresourceCount);
+        UINT64 requiredSize;
+        device->GetCopyableFootprints(&textureDesc, firstSubresource, subresourceCount, intermediateOffset,
+                                      layouts.data(), rowCounts.data(), rowSizes.data(), &requiredSize);
+
+        // Tightly packed, as a loader would hand them over.
+        std::mt19937 random(21);
+        std::vector<std::vector<uint8_t>> pixels(subresourceCount);
+        std::vector<D3D12_SUBRESOURCE_DATA> sources(subresourceCount);
+        for (UINT i = 0; i < subresourceCount; ++i)
+        {
+            pixels[i].resize(static_cast<size_t>(rowSizes[i]) * rowCounts[i] * layouts[i].Footprint.Depth);
+            for (uint8_t& byte : pixels[i])
+            {
+                byte = static_cast<uint8_t>(random());
+            }
+            sources[i] = {pixels[i].data(), static_cast<LONG_PTR>(rowSizes[i]), static_cast<LONG_PTR>(rowSizes[i] * rowCounts[i])};
+        }
+
+        uint64_t bufferSize = intermediateOffset + requiredSize + 4096;
+        ComPtr<ID3D12Resource> serialBuffer = CreateUploadBuffer(device, bufferSize);
+        ComPtr<ID3D12Resource> parallelBuffer = CreateUploadBuffer(device, bufferSize);
+
+        ComPtr<ID3D12CommandAllocator> allocator;
+        ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)));
+        ComPtr<ID3D12GraphicsCommandList> commandList;
+        ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&commandList)));
+
+        FootprintCache footprints;
+        WorkerPool workers(threadCount);
+
+        uint64_t serialSize = UpdateSubresources(commandList.Get(), texture.Get(), serialBuffer.Get(), firstSubresource, subresourceCount,
+                                                 requiredSize, layouts.data(), rowCounts.data(), rowSizes.data(), sources.data());
+        uint64_t parallelSize = UpdateSubresourcesParallel(commandList.Get(), texture.Get(), parallelBuffer.Get(), intermediateOffset,
+                                                           firstSubresource, subresourceCount, sources.data(), footprints, workers);
+        ThrowIfFailed(commandList->Close());
+
+        CHECK(serialSize == requiredSize);
+        CHECK(parallelSize == serialSize);
+
+        void* serialData;
+        void* parallelData;
+        ThrowIfFailed(serialBuffer->Map(0, nullptr, &serialData));
+        ThrowIfFailed(parallelBuffer->Map(0, nullptr, &parallelData));
+        CHECK(memcmp(serialData, parallelData, static_cast<size_t>(bufferSize)) == 0);
+        serialBuffer->Unmap(0, nullptr);
+        parallelBuffer->Unmap(0, nullptr);
+    }
+}
+
+TEST(UpdateSubresourcesParallelMatchesSerialForArrays)
+{
+    // Rows of 400 bytes, so each is padded to the 256 byte pitch alignment and none can be merged.
+    CheckMatchesSerial(device, CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 100, 60, 6, 1), 0, 6, 0, 4);
+    // Rows without padding, merged into one block per slice.
+    CheckMatchesSerial(device, CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 4, 1), 0, 4, 0, 4);
+    // Slices of a volume, and a block compressed format.
+    CheckMatchesSerial(device, CD3DX12_RESOURCE_DESC::Tex3D(DXGI_FORMAT_R8G8B8A8_UNORM, 64, 48, 16, 1), 0, 1, 0, 4);
+    CheckMatchesSerial(device, CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_BC1_UNORM, 120, 88, 3, 1), 0, 3, 0, 4);
+}
+
+TEST(UpdateSubresourcesParallelMatchesSerialForMipChains)
+{
+    // Full chains down to 1x1, whose top mips are large enough to be split across the threads and
+    // to be streamed, and a range starting part way into the second slice.
+    CheckMatchesSerial(device, CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 1024, 768, 2, 11), 0, 22, 0, 4);
+    CheckMatchesSerial(device, CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 300, 200, 3, 9), 12, 14, 0, 3);
+    CheckMatchesSerial(device, CD3DX12_RESOURCE_DESC::Tex3D(DXGI_FORMAT_R8G8B8A8_UNORM, 64, 64, 32, 7), 0, 7, 0, 2);
+    // One thread, where everything runs inline.
+    CheckMatchesSerial(device, CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 1024, 768, 1, 11), 0, 11, 0, 1);
+}
+
+TEST(UpdateSubresourcesParallelMatchesSerialAtUnalignedOffsets)
+{
+    // Offsets that aren't 512 byte aligned, nor even 16 byte aligned, move where the streaming stores'
+    // aligned part of each row starts.
+    CheckMatchesSerial(device, CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 1024, 768, 2, 11), 0, 22, 100, 4);
+    CheckMatchesSerial(device, CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 100, 60, 6, 7), 0, 42, 7, 4);
+    CheckMatchesSerial(device, CD3DX12_RESOURCE_DESC::Buffer(5 << 20), 0, 1, 333, 4);
+}
@@ -0,0 +1,64 @@
+#include "Tests.h"
+
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    struct Test
+    {
+        const char* Name;
+        TestFunction Function;
+    };
+
+    // A function static, so registrations in other files can't run before it exists.
+    std::vector<Test>& GetTests()
+    {
+        static std::vector<Test> tests;
+        return tests;
+    }
+
+    // Failed checks of the test being run.
+    uint32_t g_Failures = 0;
+}
+
+TestRegistration::TestRegistration(const char* name, TestFunction function)
+{
+    GetTests().push_back({name, function});
+}
+
+bool ReportCheck(bool passed, const char* expression, const char* file, int line)
+{
+    if(!passed)
+    {
+        ++g_Failures;
+        std::cout << "  " << file << ":" << line << ": CHECK(" << expression << ") failed" << std::endl;
+    }
+
+    return passed;
+}
+
+int RunTests(ID3D12Device2* device)
+{
+    int failed = 0;
+    for (const Test& test : GetTests())
+    {
+        g_Failures = 0;
+        try
+        {
+            test.Function(device);
+        }
+        catch (const std::exception&)
+        {
+            std::cout << "  exception thrown" << std::endl;
+            ++g_Failures;
+        }
+
+        std::cout << (g_Failures == 0 ? "[ OK ] " : "[FAIL] ") << test.Name << std::endl;
+        failed += g_Failures == 0 ? 0 : 1;
+    }
+
+    std::cout << "Tests: " << GetTests().size() - failed << " of " << GetTests().size() << " passed" << std::endl;
+
+    return failed;
+}
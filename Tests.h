@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+
+// Self-checks run by --test, each against the device the app created; the null device on other
+// platforms. A test is a function defined with TEST, and CHECK records a failure without stopping it,
+// so one run reports every broken expectation. An exception escaping a test fails it too.
+
+typedef void (*TestFunction)(ID3D12Device2* device);
+
+struct TestRegistration
+{
+    TestRegistration(const char* name, TestFunction function);
+};
+
+#define TEST(name) \
+    static void Test_##name(ID3D12Device2* device); \
+    static TestRegistration g_TestRegistration_##name(#name, Test_##name); \
+    static void Test_##name(ID3D12Device2* device)
+
+#define CHECK(condition) ReportCheck(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+// Returns passed, so a test can skip what depends on a failed check.
+bool ReportCheck(bool passed, const char* expression, const char* file, int line);
+
+// Runs every test and returns how many failed.
+int RunTests(ID3D12Device2* device);
@@ -0,0 +1,279 @@
+#include "TlsfAllocator.h"
+#include "MemoryHelpers.h"
+
+#include <algorithm>
+
+TlsfAllocator::TlsfAllocator(uint64_t size, uint64_t granularity)
+    // The smallest size class still has to split into SecondLevelCount steps.
+    : m_Granularity(std::max<uint64_t>(granularity, SecondLevelCount))
+    , m_Capacity(size / m_Granularity * m_Granularity)
+    , m_Allocated(0)
+    , m_FirstLevelBitmap(0)
+    , m_SecondLevelBitmaps()
+{
+    for (auto& freeLists : m_FreeLists)
+    {
+        std::fill(std::begin(freeLists), std::end(freeLists), InvalidNode);
+    }
+
+    if(m_Capacity > 0)
+    {
+        InsertFree(CreateNode(0, m_Capacity));
+    }
+}
+
+TlsfAllocator::Allocation TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    size = AlignUp(std::max<uint64_t>(size, 1), m_Granularity);
+    alignment = std::max(alignment, m_Granularity);
+    if(size > m_Capacity)
+    {
+        return InvalidAllocation;
+    }
+
+    // Try a range of the size itself first, which is often aligned already; freed ranges of the same
+    // size are then reused exactly. Failing that, any range large enough to align the start in fits.
+    uint32_t node = FindFree(size);
+    if(node != InvalidNode && AlignUp(m_Nodes[node].Offset, alignment) + size > m_Nodes[node].Offset + m_Nodes[node].Size)
+    {
+        node = InvalidNode;
+    }
+    if(node == InvalidNode && alignment > m_Granularity && size + alignment - m_Granularity <= m_Capacity)
+    {
+        node = FindFree(size + alignment - m_Granularity);
+    }
+
+    if(node == InvalidNode)
+    {
+        return InvalidAllocation;
+    }
+
+    RemoveFree(node);
+
+    // Give the space in front of the aligned start back as a range of its own.
+    uint64_t padding = AlignUp(m_Nodes[node].Offset, alignment) - m_Nodes[node].Offset;
+    if(padding > 0)
+    {
+        uint32_t front = node;
+        SplitTail(front, padding);
+        node = m_Nodes[front].NextPhysical;
+        RemoveFree(node);
+        InsertFree(front);
+    }
+
+    SplitTail(node, size);
+    m_Nodes[node].Free = false;
+    m_Allocated += m_Nodes[node].Size;
+
+    return node;
+}
+
+void TlsfAllocator::Free(Allocation allocation)
+{
+    uint32_t node = allocation;
+    m_Nodes[node].Free = true;
+    m_Allocated -= m_Nodes[node].Size;
+
+    uint32_t previous = m_Nodes[node].PreviousPhysical;
+    if(previous != InvalidNode && m_Nodes[previous].Free)
+    {
+        RemoveFree(previous);
+        m_Nodes[previous].Size += m_Nodes[node].Size;
+        m_Nodes[previous].NextPhysical = m_Nodes[node].NextPhysical;
+        if(m_Nodes[node].NextPhysical != InvalidNode)
+        {
+            m_Nodes[m_Nodes[node].NextPhysical].PreviousPhysical = previous;
+        }
+        DestroyNode(node);
+        node = previous;
+    }
+
+    uint32_t next = m_Nodes[node].NextPhysical;
+    if(next != InvalidNode && m_Nodes[next].Free)
+    {
+        RemoveFree(next);
+        m_Nodes[node].Size += m_Nodes[next].Size;
+        m_Nodes[node].NextPhysical = m_Nodes[next].NextPhysical;
+        if(m_Nodes[next].NextPhysical != InvalidNode)
+        {
+            m_Nodes[m_Nodes[next].NextPhysical].PreviousPhysical = node;
+        }
+        DestroyNode(next);
+    }
+
+    InsertFree(node);
+}
+
+uint32_t TlsfAllocator::FindFree(uint64_t size) const
+{
+    // Rounding up to the next size class means every range in the list found is large enough.
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    MapSize(size + (uint64_t(1) << (FindHighestBit(size) - SecondLevelBits)) - 1, firstLevel, secondLevel);
+
+    uint32_t secondLevelMap = m_SecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+    if(!secondLevelMap)
+    {
+        uint64_t firstLevelMap = firstLevel + 1 < FirstLevelCount ? m_FirstLevelBitmap & (~uint64_t(0) << (firstLevel + 1)) : 0;
+        if(!firstLevelMap)
+        {
+            return InvalidNode;
+        }
+
+        firstLevel = FindLowestBit(firstLevelMap);
+        secondLevelMap = m_SecondLevelBitmaps[firstLevel];
+    }
+
+    return m_FreeLists[firstLevel][FindLowestBit(secondLevelMap)];
+}
+
+uint64_t TlsfAllocator::GetOffset(Allocation allocation) const
+{
+    return m_Nodes[allocation].Offset;
+}
+
+uint64_t TlsfAllocator::GetSize(Allocation allocation) const
+{
+    return m_Nodes[allocation].Size;
+}
+
+uint64_t TlsfAllocator::GetCapacity() const
+{
+    return m_Capacity;
+}
+
+uint64_t TlsfAllocator::GetAllocated() const
+{
+    return m_Allocated;
+}
+
+uint64_t TlsfAllocator::GetLargestFreeRange() const
+{
+    if(!m_FirstLevelBitmap)
+    {
+        return 0;
+    }
+
+    uint32_t firstLevel = FindHighestBit(m_FirstLevelBitmap);
+    uint32_t secondLevel = FindHighestBit(m_SecondLevelBitmaps[firstLevel]);
+
+    uint64_t largest = 0;
+    for (uint32_t node = m_FreeLists[firstLevel][secondLevel]; node != InvalidNode; node = m_Nodes[node].NextFree)
+    {
+        largest = std::max(largest, m_Nodes[node].Size);
+    }
+
+    return largest;
+}
+
+uint32_t TlsfAllocator::GetLargestFreeLevel() const
+{
+    return m_FirstLevelBitmap ? FindHighestBit(m_FirstLevelBitmap) : NoFreeLevel;
+}
+
+bool TlsfAllocator::IsEmpty() const
+{
+    return m_Allocated == 0;
+}
+
+void TlsfAllocator::MapSize(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+    firstLevel = FindHighestBit(size);
+    secondLevel = static_cast<uint32_t>(size >> (firstLevel - SecondLevelBits)) & (SecondLevelCount - 1);
+}
+
+uint32_t TlsfAllocator::CreateNode(uint64_t offset, uint64_t size)
+{
+    uint32_t node;
+    if(!m_UnusedNodes.empty())
+    {
+        node = m_UnusedNodes.back();
+        m_UnusedNodes.pop_back();
+    }
+    else
+    {
+        node = static_cast<uint32_t>(m_Nodes.size());
+        m_Nodes.emplace_back();
+    }
+
+    m_Nodes[node] = {offset, size, InvalidNode, InvalidNode, InvalidNode, InvalidNode, true};
+
+    return node;
+}
+
+void TlsfAllocator::DestroyNode(uint32_t node)
+{
+    m_UnusedNodes.push_back(node);
+}
+
+void TlsfAllocator::InsertFree(uint32_t node)
+{
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    MapSize(m_Nodes[node].Size, firstLevel, secondLevel);
+
+    uint32_t head = m_FreeLists[firstLevel][secondLevel];
+    m_Nodes[node].Free = true;
+    m_Nodes[node].PreviousFree = InvalidNode;
+    m_Nodes[node].NextFree = head;
+    if(head != InvalidNode)
+    {
+        m_Nodes[head].PreviousFree = node;
+    }
+
+    m_FreeLists[firstLevel][secondLevel] = node;
+    m_FirstLevelBitmap |= uint64_t(1) << firstLevel;
+    m_SecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+void TlsfAllocator::RemoveFree(uint32_t node)
+{
+    uint32_t firstLevel;
+    uint32_t secondLevel;
+    MapSize(m_Nodes[node].Size, firstLevel, secondLevel);
+
+    uint32_t previous = m_Nodes[node].PreviousFree;
+    uint32_t next = m_Nodes[node].NextFree;
+    if(previous != InvalidNode)
+    {
+        m_Nodes[previous].NextFree = next;
+    }
+    else
+    {
+        m_FreeLists[firstLevel][secondLevel] = next;
+    }
+    if(next != InvalidNode)
+    {
+        m_Nodes[next].PreviousFree = previous;
+    }
+
+    if(m_FreeLists[firstLevel][secondLevel] == InvalidNode)
+    {
+        m_SecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+        if(!m_SecondLevelBitmaps[firstLevel])
+        {
+            m_FirstLevelBitmap &= ~(uint64_t(1) << firstLevel);
+        }
+    }
+}
+
+void TlsfAllocator::SplitTail(uint32_t node, uint64_t size)
+{
+    uint64_t remainder = m_Nodes[node].Size - size;
+    if(remainder < m_Granularity)
+    {
+        return;
+    }
+
+    uint32_t tail = CreateNode(m_Nodes[node].Offset + size, remainder);
+    m_Nodes[node].Size = size;
+    m_Nodes[tail].PreviousPhysical = node;
+    m_Nodes[tail].NextPhysical = m_Nodes[node].NextPhysical;
+    if(m_Nodes[node].NextPhysical != InvalidNode)
+    {
+        m_Nodes[m_Nodes[node].NextPhysical].PreviousPhysical = tail;
+    }
+    m_Nodes[node].NextPhysical = tail;
+
+    InsertFree(tail);
+}
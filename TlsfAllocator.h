@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Two-level segregated fit over the offsets [0, size) of some block of memory. Free ranges are kept on
+// lists by size class: the first level is the power of two below the size, the second splits that
+// into SecondLevelCount linear steps. Finding a list with a range that fits is two bit scans, so
+// Allocate and Free are O(1). Freed ranges merge with free neighbours straight away.
+//
+// Sizes and offsets are in bytes, rounded to granularity. Pure CPU and not thread safe.
+class TlsfAllocator
+{
+public:
+    typedef uint32_t Allocation;
+    static constexpr Allocation InvalidAllocation = UINT32_MAX;
+    static constexpr uint32_t LevelCount = 64;
+    static constexpr uint32_t NoFreeLevel = UINT32_MAX;
+
+    TlsfAllocator(uint64_t size, uint64_t granularity);
+
+    // alignment has to be a power of two. Returns InvalidAllocation if no free range fits.
+    Allocation Allocate(uint64_t size, uint64_t alignment);
+    void Free(Allocation allocation);
+
+    uint64_t GetOffset(Allocation allocation) const;
+    // Rounded up to granularity.
+    uint64_t GetSize(Allocation allocation) const;
+
+    uint64_t GetCapacity() const;
+    uint64_t GetAllocated() const;
+    // Walks the largest non-empty size class, so not for every allocation.
+    uint64_t GetLargestFreeRange() const;
+    // The first level of the largest free range's size class, so that range is at least 1 << level
+    // bytes; NoFreeLevel when nothing is free.
+    uint32_t GetLargestFreeLevel() const;
+    bool IsEmpty() const;
+
+private:
+    static constexpr uint32_t SecondLevelBits = 4;
+    static constexpr uint32_t SecondLevelCount = 1u << SecondLevelBits;
+    static constexpr uint32_t FirstLevelCount = LevelCount;
+    static constexpr uint32_t InvalidNode = UINT32_MAX;
+
+    // A range of the memory, free or allocated, linked to its neighbours in memory and, while free,
+    // to the other free ranges of its size class.
+    struct Node
+    {
+        uint64_t Offset;
+        uint64_t Size;
+        uint32_t PreviousPhysical;
+        uint32_t NextPhysical;
+        uint32_t PreviousFree;
+        uint32_t NextFree;
+        bool Free;
+    };
+
+    static void MapSize(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+    // The head of the first non-empty list whose ranges are all at least size, or InvalidNode.
+    uint32_t FindFree(uint64_t size) const;
+
+    uint32_t CreateNode(uint64_t offset, uint64_t size);
+    void DestroyNode(uint32_t node);
+    void InsertFree(uint32_t node);
+    void RemoveFree(uint32_t node);
+    // Splits the end of the node off as a new free node, if there is enough of it.
+    void SplitTail(uint32_t node, uint64_t size);
+
+    uint64_t m_Granularity;
+    uint64_t m_Capacity;
+    uint64_t m_Allocated;
+
+    std::vector<Node> m_Nodes;
+    std::vector<uint32_t> m_UnusedNodes;
+
+    uint64_t m_FirstLevelBitmap;
+    uint32_t m_SecondLevelBitmaps[FirstLevelCount];
+    uint32_t m_FreeLists[FirstLevelCount][SecondLevelCount];
+};
@@ -0,0 +1,94 @@
+#include "TransientMemoryPlanner.h"
+#include "MemoryHelpers.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+    bool LifetimesOverlap(const TransientMemoryRequest& a, const TransientMemoryRequest& b)
+    {
+        return a.FirstPass <= b.LastPass && b.FirstPass <= a.LastPass;
+    }
+
+    struct Range
+    {
+        uint64_t Begin;
+        uint64_t End;
+    };
+}
+
+TransientMemoryPlan PlanTransientMemory(const std::vector<TransientMemoryRequest>& requests)
+{
+    TransientMemoryPlan plan = {};
+    plan.Offsets.resize(requests.size(), 0);
+    plan.Aliased.resize(requests.size(), false);
+
+    std::vector<size_t> order(requests.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&requests](size_t a, size_t b)
+    {
+        if(requests[a].Size != requests[b].Size)
+        {
+            return requests[a].Size > requests[b].Size;
+        }
+        return requests[a].FirstPass < requests[b].FirstPass;
+    });
+
+    std::vector<size_t> placed;
+    std::vector<Range> occupied;
+    uint64_t unaliasedEnd = 0;
+    for (size_t index : order)
+    {
+        const TransientMemoryRequest& request = requests[index];
+        uint64_t alignment = std::max<uint64_t>(request.Alignment, 1);
+
+        occupied.clear();
+        for (size_t other : placed)
+        {
+            if(LifetimesOverlap(request, requests[other]))
+            {
+                occupied.push_back({plan.Offsets[other], plan.Offsets[other] + requests[other].Size});
+            }
+        }
+        std::sort(occupied.begin(), occupied.end(), [](const Range& a, const Range& b)
+        {
+            return a.Begin < b.Begin;
+        });
+
+        // First fit in the gaps between the memory that is in use while the request is alive.
+        uint64_t offset = 0;
+        for (const Range& range : occupied)
+        {
+            if(offset + request.Size <= range.Begin)
+            {
+                break;
+            }
+            offset = std::max(offset, AlignUp(range.End, alignment));
+        }
+
+        plan.Offsets[index] = offset;
+        plan.HeapSize = std::max(plan.HeapSize, offset + request.Size);
+        unaliasedEnd = AlignUp(unaliasedEnd, alignment) + request.Size;
+        placed.push_back(index);
+    }
+
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        for (size_t j = i + 1; j < requests.size(); ++j)
+        {
+            bool memoryOverlaps = plan.Offsets[i] < plan.Offsets[j] + requests[j].Size &&
+                plan.Offsets[j] < plan.Offsets[i] + requests[i].Size;
+            if(memoryOverlaps)
+            {
+                plan.Aliased[i] = true;
+                plan.Aliased[j] = true;
+            }
+        }
+    }
+
+    plan.UnaliasedSize = unaliasedEnd;
+    plan.SavedSize = plan.UnaliasedSize > plan.HeapSize ? plan.UnaliasedSize - plan.HeapSize : 0;
+
+    return plan;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Packs resources that only live for part of a frame into as little memory as possible. Resources
+// whose lifetimes don't overlap may share memory. Pure CPU; the caller creates the heap and places
+// the resources at the planned offsets.
+
+struct TransientMemoryRequest
+{
+    // From GetResourceAllocationInfo.
+    uint64_t Size;
+    uint64_t Alignment;
+    // The first and last pass, in execution order, that use the resource.
+    uint32_t FirstPass;
+    uint32_t LastPass;
+};
+
+struct TransientMemoryPlan
+{
+    // One per request.
+    std::vector<uint64_t> Offsets;
+    // Requests that share some of their memory with another request, and so have to be activated
+    // with an aliasing barrier before their first pass.
+    std::vector<bool> Aliased;
+    uint64_t HeapSize;
+    // The heap the requests would take placed one after another, alignment included, and how much of
+    // it the plan saves.
+    uint64_t UnaliasedSize;
+    uint64_t SavedSize;
+};
+
+// Places the largest requests first, each at the lowest offset that doesn't overlap a request already
+// placed with an overlapping lifetime.
+TransientMemoryPlan PlanTransientMemory(const std::vector<TransientMemoryRequest>& requests);
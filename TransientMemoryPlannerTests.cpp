@@ -0,0 +1,131 @@
+#include "TransientMemoryPlanner.h"
+#include "Tests.h"
+
+#include <random>
+
+namespace
+{
+    bool MemoryOverlaps(const TransientMemoryPlan& plan, const std::vector<TransientMemoryRequest>& requests, size_t a, size_t b)
+    {
+        return plan.Offsets[a] < plan.Offsets[b] + requests[b].Size && plan.Offsets[b] < plan.Offsets[a] + requests[a].Size;
+    }
+}
+
+TEST(TransientMemoryPlannerSharesMemoryBetweenDisjointLifetimes)
+{
+    std::vector<TransientMemoryRequest> requests =
+    {
+        {65536, 65536, 0, 1},
+        {65536, 65536, 2, 3},
+        {65536, 65536, 4, 4}
+    };
+
+    TransientMemoryPlan plan = PlanTransientMemory(requests);
+
+    CHECK(plan.Offsets[0] == 0);
+    CHECK(plan.Offsets[1] == 0);
+    CHECK(plan.Offsets[2] == 0);
+    CHECK(plan.Aliased[0] && plan.Aliased[1] && plan.Aliased[2]);
+    CHECK(plan.HeapSize == 65536);
+}
+
+TEST(TransientMemoryPlannerKeepsOverlappingLifetimesApart)
+{
+    std::mt19937 random(15);
+    std::vector<TransientMemoryRequest> requests;
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        uint32_t firstPass = static_cast<uint32_t>(random() % 16);
+        uint32_t lastPass = firstPass + static_cast<uint32_t>(random() % 6);
+        uint64_t alignment = 1ull << (random() % 17);
+        requests.push_back({1 + random() % 300000, alignment, firstPass, lastPass});
+    }
+
+    TransientMemoryPlan plan = PlanTransientMemory(requests);
+
+    bool apart = true;
+    bool aliasedMatches = true;
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        bool aliased = false;
+        for (size_t j = 0; j < requests.size(); ++j)
+        {
+            if(i == j)
+            {
+                continue;
+            }
+
+            bool lifetimesOverlap = requests[i].FirstPass <= requests[j].LastPass && requests[j].FirstPass <= requests[i].LastPass;
+            bool memoryOverlaps = MemoryOverlaps(plan, requests, i, j);
+            apart = apart && !(lifetimesOverlap && memoryOverlaps);
+            aliased = aliased || memoryOverlaps;
+        }
+
+        aliasedMatches = aliasedMatches && plan.Aliased[i] == aliased;
+        CHECK(plan.Offsets[i] % requests[i].Alignment == 0);
+        CHECK(plan.Offsets[i] + requests[i].Size <= plan.HeapSize);
+    }
+
+    CHECK(apart);
+    CHECK(aliasedMatches);
+}
+
+TEST(TransientMemoryPlannerHonoursAlignment)
+{
+    // The larger request goes first, and leaves the next 64KB boundary past its end for the other.
+    std::vector<TransientMemoryRequest> requests =
+    {
+        {70000, 1, 0, 2},
+        {10, 65536, 1, 1}
+    };
+
+    TransientMemoryPlan plan = PlanTransientMemory(requests);
+
+    CHECK(plan.Offsets[0] == 0);
+    CHECK(plan.Offsets[1] == 131072);
+    CHECK(plan.HeapSize == 131082);
+    CHECK(!plan.Aliased[0] && !plan.Aliased[1]);
+}
+
+TEST(TransientMemoryPlannerReportsSavedSize)
+{
+    // Two full-size resources take turns at offset 0 while a half-size one lives alongside both.
+    std::vector<TransientMemoryRequest> requests =
+    {
+        {65536, 65536, 0, 0},
+        {65536, 65536, 1, 1},
+        {32768, 65536, 0, 1}
+    };
+
+    TransientMemoryPlan plan = PlanTransientMemory(requests);
+
+    CHECK(plan.Offsets[2] == 65536);
+    CHECK(plan.HeapSize == 98304);
+    CHECK(plan.UnaliasedSize == 163840);
+    CHECK(plan.SavedSize == 65536);
+
+    // Placed one after another, the smaller request would start at the next 256 byte boundary.
+    requests =
+    {
+        {300, 256, 0, 0},
+        {100, 256, 1, 1}
+    };
+
+    plan = PlanTransientMemory(requests);
+
+    CHECK(plan.HeapSize == 300);
+    CHECK(plan.UnaliasedSize == 612);
+    CHECK(plan.SavedSize == 312);
+
+    // Nothing to share when every lifetime overlaps.
+    requests =
+    {
+        {65536, 65536, 0, 1},
+        {65536, 65536, 1, 2}
+    };
+
+    plan = PlanTransientMemory(requests);
+
+    CHECK(plan.HeapSize == 131072);
+    CHECK(plan.SavedSize == 0);
+}
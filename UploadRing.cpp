@@ -0,0 +1,95 @@
+#include "UploadRing.h"
+#include "MemoryHelpers.h"
+
+#if !defined(_WIN32)
+#include "directXHeaders/dxguids/dxguids.h"
+#endif
+
+#include <algorithm>
+
+UploadRing::UploadRing(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, uint64_t size)
+    // A whole number of 64KB blocks keeps every alignment up to that the same in and out of the ring.
+    : m_Size(AlignUp(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT))
+    , m_Head(0)
+    , m_Tail(0)
+    , m_PeakUsed(0)
+{
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(m_Size);
+    ThrowIfFailed(device->CreateCommittedResource(
+        &heapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&m_Buffer)));
+
+    CD3DX12_RANGE readRange(0, 0);
+    ThrowIfFailed(m_Buffer->Map(0, &readRange, reinterpret_cast<void**>(&m_CpuAddress)));
+
+    m_GpuAddress = m_Buffer->GetGPUVirtualAddress();
+}
+
+UploadAllocation UploadRing::Allocate(uint64_t size, uint64_t alignment)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if(size > m_Size)
+    {
+        ThrowIfFailed(E_OUTOFMEMORY);
+    }
+
+    // Allocations never straddle the end of the buffer; skip to the start instead.
+    uint64_t offset = AlignUp(m_Head, alignment);
+    if(offset % m_Size + size > m_Size)
+    {
+        offset = AlignUp(offset, m_Size);
+    }
+
+    if(offset + size - m_Tail > m_Size)
+    {
+        Reclaim();
+        if(offset + size - m_Tail > m_Size)
+        {
+            ThrowIfFailed(E_OUTOFMEMORY);
+        }
+    }
+
+    m_Head = offset + size;
+    m_PeakUsed = std::max(m_PeakUsed, m_Head - m_Tail);
+
+    UploadAllocation allocation;
+    allocation.CpuAddress = m_CpuAddress + offset % m_Size;
+    allocation.GpuAddress = m_GpuAddress + offset % m_Size;
+
+    return allocation;
+}
+
+void UploadRing::FinishFrame(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_Regions.push_back({fence, fenceValue, m_Head});
+    Reclaim();
+}
+
+void UploadRing::Reclaim()
+{
+    while (!m_Regions.empty() && m_Regions.front().Fence->GetCompletedValue() >= m_Regions.front().FenceValue)
+    {
+        m_Tail = m_Regions.front().End;
+        m_Regions.pop_front();
+    }
+}
+
+UploadRingStatistics UploadRing::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    UploadRingStatistics statistics;
+    statistics.Size = m_Size;
+    statistics.Used = m_Head - m_Tail;
+    statistics.PeakUsed = m_PeakUsed;
+
+    return statistics;
+}
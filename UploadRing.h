@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Helpers.h"
+#if defined(_WIN32)
+#include <wrl.h>
+#endif
+#include "directXHeaders/directx/d3dx12.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+struct UploadAllocation
+{
+    void* CpuAddress;
+    D3D12_GPU_VIRTUAL_ADDRESS GpuAddress;
+};
+
+struct UploadRingStatistics
+{
+    uint64_t Size;
+    // Bytes held by frames that had not completed when last checked, and the most there has ever been.
+    uint64_t Used;
+    uint64_t PeakUsed;
+};
+
+// A single persistently mapped UPLOAD buffer that every frame in flight allocates its dynamic data from.
+// FinishFrame tags everything allocated since the previous call with a fence value, and that space is
+// only handed out again once the fence has passed it. Safe to allocate from several recording threads.
+class UploadRing
+{
+public:
+    UploadRing(const Microsoft::WRL::ComPtr<ID3D12Device2>& device, uint64_t size);
+
+    // Throws E_OUTOFMEMORY when the frames still in flight leave no room for the allocation.
+    UploadAllocation Allocate(uint64_t size, uint64_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+    void FinishFrame(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t fenceValue);
+
+    UploadRingStatistics GetStatistics() const;
+
+private:
+    // Frees the space of every finished frame the GPU is done with. Call with m_Mutex held.
+    void Reclaim();
+
+    struct Region
+    {
+        Microsoft::WRL::ComPtr<ID3D12Fence> Fence;
+        uint64_t FenceValue;
+        uint64_t End;
+    };
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_Buffer;
+    uint8_t* m_CpuAddress;
+    D3D12_GPU_VIRTUAL_ADDRESS m_GpuAddress;
+    uint64_t m_Size;
+
+    mutable std::mutex m_Mutex;
+    // Offsets only ever grow; the position in the buffer is the offset modulo m_Size.
+    uint64_t m_Head;
+    uint64_t m_Tail;
+    uint64_t m_PeakUsed;
+    std::deque<Region> m_Regions;
+};
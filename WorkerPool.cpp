@@ -0,0 +1,127 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(uint32_t threadCount)
+    : m_Task(nullptr)
+    , m_Count(0)
+    , m_Next(0)
+    , m_Finished(0)
+    , m_Error(nullptr)
+    , m_Generation(0)
+    , m_Stop(false)
+{
+    for (uint32_t i = 1; i < std::max(threadCount, 1u); ++i)
+    {
+        m_Threads.emplace_back(&WorkerPool::Run, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_WorkAvailable.notify_all();
+
+    for (std::thread& thread : m_Threads)
+    {
+        thread.join();
+    }
+}
+
+uint32_t WorkerPool::GetThreadCount() const
+{
+    return static_cast<uint32_t>(m_Threads.size()) + 1;
+}
+
+void WorkerPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task)
+{
+    if(m_Threads.empty() || count <= 1)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Task = &task;
+        m_Count = count;
+        m_Next = 0;
+        m_Finished = 0;
+        m_Error = nullptr;
+        ++m_Generation;
+    }
+    m_WorkAvailable.notify_all();
+
+    RunTasks();
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_WorkDone.wait(lock, [this] { return m_Finished == m_Count; });
+    m_Task = nullptr;
+
+    if(m_Error)
+    {
+        std::exception_ptr error = m_Error;
+        m_Error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void WorkerPool::Run()
+{
+    uint64_t generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkAvailable.wait(lock, [this, generation] { return m_Stop || m_Generation != generation; });
+            if(m_Stop)
+            {
+                return;
+            }
+            generation = m_Generation;
+        }
+
+        RunTasks();
+    }
+}
+
+void WorkerPool::RunTasks()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while (m_Task && m_Next < m_Count)
+    {
+        const std::function<void(uint32_t)>& task = *m_Task;
+        uint32_t index = m_Next++;
+
+        // A throw is kept for ParallelFor to rethrow, and the item still counts as finished, so
+        // ParallelFor neither returns early nor waits forever.
+        std::exception_ptr error;
+        lock.unlock();
+        try
+        {
+            task(index);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        if(error && !m_Error)
+        {
+            m_Error = error;
+        }
+
+        if(++m_Finished == m_Count)
+        {
+            m_WorkDone.notify_all();
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads for fork/join work. The calling thread takes part in ParallelFor, so a pool
+// of N threads starts N - 1 workers and a pool of one runs everything inline.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(uint32_t threadCount);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    uint32_t GetThreadCount() const;
+
+    // Calls task(i) once for every i in [0, count) and returns when all calls have finished. If a call
+    // throws, the first exception is rethrown once every call that was started has finished.
+    // Not reentrant: a task must not call ParallelFor on the same pool.
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task);
+
+private:
+    void Run();
+    void RunTasks();
+
+    std::vector<std::thread> m_Threads;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkAvailable;
+    std::condition_variable m_WorkDone;
+    const std::function<void(uint32_t)>* m_Task;
+    uint32_t m_Count;
+    uint32_t m_Next;
+    uint32_t m_Finished;
+    std::exception_ptr m_Error;
+    uint64_t m_Generation;
+    bool m_Stop;
+};